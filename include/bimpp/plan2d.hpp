@@ -28,6 +28,9 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
 #include <cmath>
 #include <cassert>
 #include <stdexcept>
@@ -36,18 +39,76 @@
 #include <vector>
 #include <array>
 #include <map>
+#include <unordered_map>
+#include <set>
 #include <algorithm>
+#include <type_traits>
+#include <iterator>
+#include <utility>
+#include <new>
+#include <functional>
+#include <exception>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <limits>
+#include <chrono>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <locale>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BIMPP_PLAN2D_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if !defined(BIMPP_PLAN2D_NO_SIMD)
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define BIMPP_PLAN2D_SIMD_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define BIMPP_PLAN2D_SIMD_NEON
+#include <arm_neon.h>
+#endif
+#endif
+
+#if defined(BIMPP_PLAN2D_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#define BIMPP_PLAN2D_TARGET_SSE2 __attribute__((target("sse2")))
+#define BIMPP_PLAN2D_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define BIMPP_PLAN2D_TARGET_SSE2
+#define BIMPP_PLAN2D_TARGET_AVX2
+#endif
 
 #if !defined(M_PI)
 #define M_PI       3.14159265358979323846   // pi
 #endif
 
+/// Define `BIMPP_PLAN2D_STATS` before including this file to collect `algorithm::room_ex_stats`, the code is removed if it is not defined
+#if defined(BIMPP_PLAN2D_STATS)
+#define BIMPP_PLAN2D_STATS_ONLY(...) __VA_ARGS__
+#else
+#define BIMPP_PLAN2D_STATS_ONLY(...)
+#endif
+
 namespace bimpp
 {
     namespace plan2d
     {
         /*!
          * Define a point for the 2D plan, it has two dimensions.
+         * 
+         * It is trivially copyable, so the arrays of points and nodes can be copied by `memcpy`,
+         * and all functions except the setters and `normalize` are `constexpr`.
          */
         template<typename T = double>
         class point
@@ -56,85 +117,69 @@ namespace bimpp
             typedef T   precision_type;
 
         public:
-            point(precision_type _x = 0, precision_type _y = 0)
-                : data({ _x, _y })
-            {}
-
-            point(const point& _a)
-                : data(_a.data)
+            constexpr point(precision_type _x = 0, precision_type _y = 0) noexcept
+                : data{ { _x, _y } }
             {}
 
         public:
-            inline precision_type x() const
+            constexpr precision_type x() const noexcept
             {
                 return data[0];
             }
 
-            inline point& x(precision_type _v)
+            inline point& x(precision_type _v) noexcept
             {
                 data[0] = _v;
                 return *this;
             }
 
-            inline precision_type y() const
+            constexpr precision_type y() const noexcept
             {
                 return data[1];
             }
 
-            inline point& y(precision_type _v)
+            inline point& y(precision_type _v) noexcept
             {
                 data[1] = _v;
                 return *this;
             }
 
         public:
-            point& operator=(const point& _a)
-            {
-                data = _a.data;
-                return *this;
-            }
-
-            bool operator==(const point& _a) const
+            constexpr bool operator==(const point& _a) const noexcept
             {
-                return (data == _a.data);
+                return (data[0] == _a.data[0] && data[1] == _a.data[1]);
             }
 
-            bool operator<(const point& _a) const
+            constexpr bool operator<(const point& _a) const noexcept
             {
-                if (data[0] < _a.data[0])
-                {
-                    return true;
-                }
-                if (data[0] > _a.data[0])
-                {
-                    return false;
-                }
-                return (data[1] < _a.data[1]);
+                return (data[0] < _a.data[0] || (!(_a.data[0] < data[0]) && data[1] < _a.data[1]));
             }
 
-            point operator+(const point& _a) const
+            constexpr point operator+(const point& _a) const noexcept
             {
                 return point(x() + _a.x(), y() + _a.y());
             }
 
-            point operator-(const point& _a) const
+            constexpr point operator-(const point& _a) const noexcept
             {
                 return point(x() - _a.x(), y() - _a.y());
             }
 
-            inline precision_type dot(const point& _a) const
+            /// \f$ x_1 y_2 - y_1 x_2 \f$
+            constexpr precision_type dot(const point& _a) const noexcept
             {
                 return (x() * _a.y() - y() * _a.x());
             }
 
-            inline precision_type cross(const point& _a) const
+            /// \f$ x_1 x_2 + y_1 y_2 \f$
+            constexpr precision_type cross(const point& _a) const noexcept
             {
                 return (x() * _a.x() + y() * _a.y());
             }
 
-            inline precision_type normalize()
+            inline precision_type normalize() noexcept
             {
-                precision_type len = sqrt(x() * x() + y() * y());
+                precision_type len = std::sqrt(x() * x() + y() * y());
                 if (len != static_cast<precision_type>(0)
                     && len != static_cast<precision_type>(1))
                 {
@@ -148,844 +193,8884 @@ namespace bimpp
             std::array<precision_type, 2> data;
         };
 
+        static_assert(std::is_trivially_copyable<point<float>>::value && std::is_trivially_copyable<point<double>>::value, "point must be trivially copyable!");
+        static_assert(sizeof(point<float>) == sizeof(float) * 2 && sizeof(point<double>) == sizeof(double) * 2, "point must be packed!");
+        static_assert(point<float>(1, 2).dot(point<float>(3, 4)) == -2 && point<float>(1, 2).cross(point<float>(3, 4)) == 11, "point must be constexpr!");
+        static_assert(point<double>(1, 2) + point<double>(3, 4) == point<double>(4, 6) && point<double>(1, 2) < point<double>(1, 3), "point must be constexpr!");
+
         /*!
-         * Define some classes and declare some constant values
+         * The exact geometric predicates, which decide the topology of the room-exs.
+         *
+         * The orientation is computed in `double` and checked by an error bound first,
+         * only the nearly collinear cases fall back to the exact expansion arithmetic,
+         * so the result is always the sign of the exact determinant of the input coordinates.
+         * The points can be any type with `x()` and `y()`, `float` is converted to `double` exactly, the other precisions are rounded to `double` before.
+         * It doesn't work with `-ffast-math`, or when the products overflow or underflow.
          */
-        template<typename TPrecision = double, typename TPoint = point<TPrecision>>
-        class constant
+        class predicates
         {
-        public:
-            typedef TPrecision      precision_type;
-            /// Define the point type
-            typedef TPoint          point_type;
-            typedef size_t          id_type;
-
-        public:
-            static const point_type zero_point;     ///< Origin point
-            static const point_type unit_point;     ///< Unit point
-            static const id_type    none_id;        ///< Invalid id
-
         public:
             /*!
-             * Is id valid?
+             * The orientation of \f$ {O} \f$, \f$ {A} \f$ and \f$ {B} \f$, it is the sign of \f$ \vec{OA} \times \vec{OB} \f$.
+             *
+             * @param _o The \f$ {O} \f$ point
+             * @param _a The \f$ {A} \f$ point
+             * @param _b The \f$ {B} \f$ point
+             * @return 1 if they are counterclockwise, -1 if they are clockwise, 0 if they are collinear
              */
-            static bool isValid(id_type _id)
+            template<typename TPoint>
+            static int orientation(const TPoint& _o, const TPoint& _a, const TPoint& _b)
             {
-                return (_id != none_id);
+                return orientation(static_cast<double>(_o.x()), static_cast<double>(_o.y())
+                    , static_cast<double>(_a.x()), static_cast<double>(_a.y())
+                    , static_cast<double>(_b.x()), static_cast<double>(_b.y()));
             }
 
-            template<typename TV>
-            static TPrecision convert(TV _v)
+            /// same as above, the points are given by their coordinates
+            static int orientation(double _ox, double _oy, double _ax, double _ay, double _bx, double _by)
             {
-                return static_cast<TPrecision>(_v);
+                const double bim_det_left = (_ax - _ox) * (_by - _oy);
+                const double bim_det_right = (_ay - _oy) * (_bx - _ox);
+                const double bim_det = bim_det_left - bim_det_right;
+                /// the signs of the rounded products are exact, so the determinant is exact if they are different
+                if ((bim_det_left > 0 && bim_det_right <= 0) || (bim_det_left < 0 && bim_det_right >= 0)
+                    || (bim_det_left == 0 && bim_det_right == 0))
+                {
+                    return sign(bim_det);
+                }
+                /// the error bound of Shewchuk's `orient2d`, \f$ (3 + 16 \epsilon) \epsilon \f$ of the sum of the absolute products
+                const double bim_epsilon = std::numeric_limits<double>::epsilon() * 0.5;
+                const double bim_error_bound = (3.0 + 16.0 * bim_epsilon) * bim_epsilon * (std::fabs(bim_det_left) + std::fabs(bim_det_right));
+                if (bim_det >= bim_error_bound || -bim_det >= bim_error_bound)
+                {
+                    return sign(bim_det);
+                }
+                return orientationExact(_ox, _oy, _ax, _ay, _bx, _by);
             }
-        };
 
-        template<typename TPrecision, typename TPoint>
-        const typename constant<TPrecision, TPoint>::point_type     constant<TPrecision, TPoint>::zero_point(0, 0);
-        template<typename TPrecision, typename TPoint>
-        const typename constant<TPrecision, TPoint>::point_type     constant<TPrecision, TPoint>::unit_point(1, 1);
-        template<typename TPrecision, typename TPoint>
-        const typename constant<TPrecision, TPoint>::id_type        constant<TPrecision, TPoint>::none_id(-1);
-
-        /*!
-         * A node represents a point or a joint with two walls in the 2D plan
-         * 
-         * @brief A point or a joint in the plan
-         */
-        template<typename TConstant = constant<>>
-        class node
-        {
-        public:
-            typedef typename TConstant::precision_type  precision_type;
-            typedef typename TConstant::point_type      point_type;
+            /*!
+             * Are \f$ \vec{OA} \f$ and \f$ \vec{OB} \f$ in the same direction?
+             *
+             * It compares the coordinates only, so it is exact.
+             *
+             * @param _o The \f$ {O} \f$ point
+             * @param _a The \f$ {A} \f$ point
+             * @param _b The \f$ {B} \f$ point
+             * @note The three points must be collinear, see `orientation`
+             */
+            template<typename TPoint>
+            static bool isSameDirection(const TPoint& _o, const TPoint& _a, const TPoint& _b)
+            {
+                return (compare(_a.x(), _o.x()) == compare(_b.x(), _o.x())
+                    && compare(_a.y(), _o.y()) == compare(_b.y(), _o.y()));
+            }
 
-        public:
             /*!
-             * A constructor by a 2D coordinate
-             * 
-             * @param _x The value in x-axis, default is 0.
-             * @param _y The value in y-axis, default is 0.
+             * Is the direction \f$ \vec{OA} \f$ before the direction \f$ \vec{OB} \f$ when turning counterclockwise from the x-axis?
+             *
+             * @param _o The \f$ {O} \f$ point
+             * @param _a The \f$ {A} \f$ point, it must not be same as \f$ {O} \f$
+             * @param _b The \f$ {B} \f$ point, it must not be same as \f$ {O} \f$
              */
-            node(precision_type _x = 0, precision_type _y = 0)
-                : point(_x, _y)
-            {}
+            template<typename TPoint>
+            static bool isLessAngle(const TPoint& _o, const TPoint& _a, const TPoint& _b)
+            {
+                const bool a_is_upper = (_a.y() > _o.y() || (_a.y() == _o.y() && _a.x() > _o.x()));
+                const bool b_is_upper = (_b.y() > _o.y() || (_b.y() == _o.y() && _b.x() > _o.x()));
+                if (a_is_upper != b_is_upper)
+                {
+                    return a_is_upper;
+                }
+                return orientation(_o, _a, _b) > 0;
+            }
 
             /*!
-             * A constructor by a 2D point
-             * 
-             * @param _point A 2D point, default is origin point.
+             * Is the direction \f$ \vec{OA} \f$ before the direction \f$ \vec{OB} \f$ when turning counterclockwise from \f$ \vec{OR} \f$?
+             *
+             * The angles are in \f$ [0^{\circ}, 360^{\circ}) \f$, so it is same as comparing their `sin-angle-ex`, but exactly.
+             *
+             * @param _o The \f$ {O} \f$ point
+             * @param _r The \f$ {R} \f$ point, it must not be same as \f$ {O} \f$
+             * @param _a The \f$ {A} \f$ point, it must not be same as \f$ {O} \f$
+             * @param _b The \f$ {B} \f$ point, it must not be same as \f$ {O} \f$
              */
-            node(const point_type& _point = TConstant::zero_point)
-                : point(_point)
-            {}
+            template<typename TPoint>
+            static bool isLessTurn(const TPoint& _o, const TPoint& _r, const TPoint& _a, const TPoint& _b)
+            {
+                const int bim_a_orientation = orientation(_o, _r, _a);
+                const int bim_b_orientation = orientation(_o, _r, _b);
+                const bool a_is_upper = (bim_a_orientation > 0 || (bim_a_orientation == 0 && isSameDirection(_o, _r, _a)));
+                const bool b_is_upper = (bim_b_orientation > 0 || (bim_b_orientation == 0 && isSameDirection(_o, _r, _b)));
+                if (a_is_upper != b_is_upper)
+                {
+                    return a_is_upper;
+                }
+                return orientation(_o, _a, _b) > 0;
+            }
 
-        public:
-            inline const point_type& p() const
+        private:
+            template<typename T>
+            static int compare(T _a, T _b)
             {
-                return point;
+                return (_a < _b ? -1 : (_b < _a ? 1 : 0));
             }
 
-            inline precision_type x() const
+            static int sign(double _v)
             {
-                return point.x();
+                return (_v > 0 ? 1 : (_v < 0 ? -1 : 0));
             }
 
-            inline node& x(precision_type _x)
+            /// \f$ s + e = a + b \f$ exactly
+            static void twoSum(double _a, double _b, double& _s, double& _e)
             {
-                point.x(_x);
-                return *this;
+                _s = _a + _b;
+                const double bim_b_virtual = _s - _a;
+                const double bim_a_virtual = _s - bim_b_virtual;
+                _e = (_a - bim_a_virtual) + (_b - bim_b_virtual);
             }
 
-            inline precision_type y() const
+            /// \f$ p + e = a b \f$ exactly
+            static void twoProduct(double _a, double _b, double& _p, double& _e)
             {
-                return point.y();
+                _p = _a * _b;
+                _e = std::fma(_a, _b, -_p);
             }
 
-            inline node& y(precision_type _x)
+            /// add \f$ b \f$ to the expansion, its components are nonoverlapping and in the increasing order of magnitude without zeros
+            static size_t growExpansion(double* _e, size_t _count, double _b)
             {
-                point.y(_x);
-                return *this;
+                double bim_q = _b;
+                size_t bim_count = 0;
+                for (size_t i = 0; i < _count; ++i)
+                {
+                    double bim_h = 0;
+                    twoSum(bim_q, _e[i], bim_q, bim_h);
+                    if (bim_h != 0)
+                    {
+                        _e[bim_count++] = bim_h;
+                    }
+                }
+                if (bim_q != 0)
+                {
+                    _e[bim_count++] = bim_q;
+                }
+                return bim_count;
             }
 
-        private:
-            /*!
-             * The point or position of the node
-             */
-            point_type point;
+            static int orientationExact(double _ox, double _oy, double _ax, double _ay, double _bx, double _by)
+            {
+                /// every difference is exact as two components, so the determinant is a sum of 16 exact products
+                double bim_ax[2], bim_ay[2], bim_bx[2], bim_by[2];
+                twoSum(_ax, -_ox, bim_ax[1], bim_ax[0]);
+                twoSum(_ay, -_oy, bim_ay[1], bim_ay[0]);
+                twoSum(_bx, -_ox, bim_bx[1], bim_bx[0]);
+                twoSum(_by, -_oy, bim_by[1], bim_by[0]);
+                double bim_expansion[16];
+                size_t bim_count = 0;
+                for (size_t i = 0; i < 2; ++i)
+                {
+                    for (size_t j = 0; j < 2; ++j)
+                    {
+                        double bim_p = 0, bim_e = 0;
+                        twoProduct(bim_ax[i], bim_by[j], bim_p, bim_e);
+                        bim_count = growExpansion(bim_expansion, bim_count, bim_e);
+                        bim_count = growExpansion(bim_expansion, bim_count, bim_p);
+                        twoProduct(bim_ay[i], bim_bx[j], bim_p, bim_e);
+                        bim_count = growExpansion(bim_expansion, bim_count, -bim_e);
+                        bim_count = growExpansion(bim_expansion, bim_count, -bim_p);
+                    }
+                }
+                /// the biggest component decides the sign
+                return (bim_count == 0 ? 0 : sign(bim_expansion[bim_count - 1]));
+            }
         };
 
         /*!
-         * A wall represents a wall in the 2D plan
+         * A map which stores its items in contiguous slots.
+         * 
+         * The keys are the external ids, they are looked up by an open-addressing hash table in \f$ O(1) \f$.
+         * Every item also has a generational handle, which can be looked up without hashing and becomes invalid after the item is erased.
+         * The iteration is in the order of keys like `std::map`, so it can replace `std::map` for the entities of a house.
+         * 
+         * Inserting and erasing are \f$ O(1) \f$: an erased item is only marked in the order list, and a key which is not the biggest
+         * is appended to it unsorted. The order list is rebuilt by the first iteration after the changes, it costs \f$ O(n + k \log k) \f$
+         * for \f$ k \f$ unsorted keys, and it is locked so the const map can be iterated by many threads.
+         * Unlike `std::map`, inserting or erasing any item invalidates all iterators.
          */
-        template<typename TConstant = constant<>>
-        class wall
+        template<typename TKey, typename TValue>
+        class slot_map
         {
         public:
-            typedef typename TConstant::precision_type  precision_type;
-            typedef typename TConstant::id_type         id_type;
-
-        public:
-            wall(id_type _start_node_id = TConstant::none_id
-                , id_type _end_node_id = TConstant::none_id
-                , precision_type _thickness = 0)
-                : kind("")
-                , start_node_id(_start_node_id)
-                , end_node_id(_end_node_id)
-                , thickness(_thickness)
-            {}
+            typedef TKey                                    key_type;
+            typedef TValue                                  mapped_type;
+            typedef std::pair<const key_type, mapped_type>  value_type;
+            typedef size_t                                  size_type;
 
-        public:
-            inline bool isValid() const
+            /*!
+             * A generational handle of an item
+             */
+            class handle_type
             {
-                return (TConstant::isValid(start_node_id)
-                    && TConstant::isValid(end_node_id)
-                    && start_node_id != end_node_id
-                    && thickness >= 0);
-            }
+            public:
+                handle_type(std::uint32_t _index = static_cast<std::uint32_t>(-1), std::uint32_t _generation = 0)
+                    : index(_index)
+                    , generation(_generation)
+                {}
 
-        public:
-            /// The kind of wall
-            std::string     kind;
-            /// The start of wall
-            id_type         start_node_id;
-            /// The end of wall
-            id_type         end_node_id;
-            /// The thickness of wall
-            precision_type  thickness;
-        };
+            public:
+                bool operator==(const handle_type& _a) const
+                {
+                    return (index == _a.index && generation == _a.generation);
+                }
 
-        /*!
-         * A hole represents a hole in the 2D plan,
-         * it might be a window or a door or a hole in a wall.
-         */
-        template<typename TConstant = constant<>>
-        class hole
-        {
-        public:
-            typedef typename TConstant::precision_type  precision_type;
-            typedef typename TConstant::id_type         id_type;
+                bool operator!=(const handle_type& _a) const
+                {
+                    return !(*this == _a);
+                }
 
-        public:
-            hole(id_type _wall_id = TConstant::none_id
-                , precision_type _distance = 0
-                , precision_type _width = 0)
-                : kind("")
-                , direction("")
-                , wall_id(_wall_id)
-                , distance(_distance)
-                , width(_width)
-            {}
+            public:
+                std::uint32_t   index;
+                std::uint32_t   generation;
+            };
 
-        public:
-            inline bool isValid() const
+        private:
+            class slot
             {
-                return (TConstant::isValid(wall_id)
-                    && distance != 0
-                    && width != 0);
+            public:
+                explicit slot(const value_type& _value, std::uint32_t _generation = 0)
+                    : value(_value)
+                    , generation(_generation)
+                    , position(0)
+                    , alive(true)
+                {}
+
+            public:
+                value_type      value;
+                std::uint32_t   generation;
+                size_type       position;   ///< The position in the order list, it is valid after the order list is rebuilt
+                bool            alive;
+            };
+
+            static size_type nonePosition()
+            {
+                return static_cast<size_type>(-1);
             }
 
-        public:
-            std::string     kind;
-            std::string     direction;
-            id_type         wall_id;
-            precision_type  distance;
-            precision_type  width;
-        };
+            /// an iterator keeps its slot, and finds its position in the order list when it is moved
+            template<typename TSlotMap, typename TItem>
+            class iterator_base
+            {
+            public:
+                typedef std::bidirectional_iterator_tag     iterator_category;
+                typedef typename slot_map::value_type       value_type;
+                typedef std::ptrdiff_t                      difference_type;
+                typedef TItem*                              pointer;
+                typedef TItem&                              reference;
 
-        template<typename TConstant = constant<>>
-        class room
-        {
-        public:
-            typedef typename TConstant::id_type         id_type;
-            typedef std::vector<id_type>                id_vector;
+            public:
+                iterator_base(TSlotMap* _map = nullptr, size_type _slot_index = nonePosition(), size_type _position = nonePosition())
+                    : map(_map)
+                    , slot_index(_slot_index)
+                    , position(_position)
+                {}
 
-        public:
-            room()
-                : kind("")
-                , wall_ids()
-            {}
+                template<typename TOtherSlotMap, typename TOtherItem>
+                iterator_base(const iterator_base<TOtherSlotMap, TOtherItem>& _a)
+                    : map(_a.map)
+                    , slot_index(_a.slot_index)
+                    , position(_a.position)
+                {}
 
-        public:
-            std::string     kind;
-            id_vector       wall_ids;
-        };
+            public:
+                reference operator*() const
+                {
+                    return map->slots[slot_index].value;
+                }
+
+                pointer operator->() const
+                {
+                    return &map->slots[slot_index].value;
+                }
+
+                iterator_base& operator++()
+                {
+                    moveTo(findPosition() + 1);
+                    return *this;
+                }
+
+                iterator_base operator++(int)
+                {
+                    iterator_base res(*this);
+                    ++(*this);
+                    return res;
+                }
+
+                iterator_base& operator--()
+                {
+                    moveTo(findPosition() - 1);
+                    return *this;
+                }
+
+                iterator_base operator--(int)
+                {
+                    iterator_base res(*this);
+                    --(*this);
+                    return res;
+                }
+
+                template<typename TOtherSlotMap, typename TOtherItem>
+                bool operator==(const iterator_base<TOtherSlotMap, TOtherItem>& _a) const
+                {
+                    return (slot_index == _a.slot_index);
+                }
+
+                template<typename TOtherSlotMap, typename TOtherItem>
+                bool operator!=(const iterator_base<TOtherSlotMap, TOtherItem>& _a) const
+                {
+                    return (slot_index != _a.slot_index);
+                }
+
+            private:
+                size_type findPosition()
+                {
+                    if (position == nonePosition())
+                    {
+                        map->sortOrder();
+                        position = (slot_index == nonePosition()) ? map->order.size() : map->slots[slot_index].position;
+                    }
+                    return position;
+                }
+
+                void moveTo(size_type _position)
+                {
+                    position = _position;
+                    slot_index = (_position < map->order.size()) ? map->order[_position] : nonePosition();
+                }
+
+            public:
+                TSlotMap*   map;
+                size_type   slot_index;
+                size_type   position;   ///< `nonePosition()` until the iterator is moved
+            };
 
-        template<typename TConstant = constant<>>
-        class house
-        {
         public:
-            typedef node<TConstant>                 node_type;
-            typedef std::map<size_t, node_type>     node_map;
-            typedef std::pair<size_t, node_type>    node_pair;
-            typedef wall<TConstant>                 wall_type;
-            typedef std::map<size_t, wall_type>     wall_map;
-            typedef std::pair<size_t, wall_type>    wall_pair;
-            typedef hole<TConstant>                 hole_type;
-            typedef std::map<size_t, hole_type>     hole_map;
-            typedef std::pair<size_t, hole_type>    hole_pair;
-            typedef room<TConstant>                 room_type;
-            typedef std::map<size_t, room_type>     room_map;
-            typedef std::pair<size_t, room_type>    room_pair;
+            typedef iterator_base<slot_map, value_type>                 iterator;
+            typedef iterator_base<const slot_map, const value_type>     const_iterator;
 
         public:
-            house()
-                : name("")
-                , nodes()
-                , walls()
-                , holes()
-                , rooms()
+            slot_map()
+                : slots()
+                , free_slots()
+                , erased_slots()
+                , order()
+                , buckets()
+                , items_count(0)
+                , sorted_count(0)
+                , sorted(true)
+                , mutex()
             {}
 
-        public:
-            inline void reset()
+            slot_map(const slot_map& _a)
+                : slots()
+                , free_slots()
+                , erased_slots()
+                , order()
+                , buckets()
+                , items_count(0)
+                , sorted_count(0)
+                , sorted(true)
+                , mutex()
             {
-                name = "";
-                nodes.clear();
-                walls.clear();
-                holes.clear();
-                rooms.clear();
+                copy(_a);
+            }
+
+            slot_map(slot_map&& _a)
+                : slots()
+                , free_slots()
+                , erased_slots()
+                , order()
+                , buckets()
+                , items_count(0)
+                , sorted_count(0)
+                , sorted(true)
+                , mutex()
+            {
+                swap(_a);
+            }
+
+            slot_map& operator=(const slot_map& _a)
+            {
+                if (this != &_a)
+                {
+                    copy(_a);
+                }
+                return *this;
+            }
+
+            slot_map& operator=(slot_map&& _a)
+            {
+                if (this != &_a)
+                {
+                    clear();
+                    swap(_a);
+                }
+                return *this;
             }
 
         public:
-            std::string name;
-            node_map nodes;
-            wall_map walls;
-            hole_map holes;
-            room_map rooms;
+            inline size_type size() const
+            {
+                return items_count;
+            }
+
+            inline bool empty() const
+            {
+                return (items_count == 0);
+            }
+
+            inline void clear()
+            {
+                slots.clear();
+                free_slots.clear();
+                erased_slots.clear();
+                order.clear();
+                buckets.clear();
+                items_count = 0;
+                sorted_count = 0;
+                sorted.store(true, std::memory_order_relaxed);
+            }
+
+            inline void reserve(size_type _count)
+            {
+                slots.reserve(_count);
+                order.reserve(_count);
+                rehash(_count);
+            }
+
+            inline void swap(slot_map& _a)
+            {
+                slots.swap(_a.slots);
+                free_slots.swap(_a.free_slots);
+                erased_slots.swap(_a.erased_slots);
+                order.swap(_a.order);
+                buckets.swap(_a.buckets);
+                std::swap(items_count, _a.items_count);
+                std::swap(sorted_count, _a.sorted_count);
+                const bool bim_sorted = sorted.load(std::memory_order_relaxed);
+                sorted.store(_a.sorted.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                _a.sorted.store(bim_sorted, std::memory_order_relaxed);
+            }
+
+            inline iterator begin() { sortOrder(); return iterator(this, order.empty() ? nonePosition() : order.front(), 0); }
+            inline iterator end() { return iterator(this); }
+            inline const_iterator begin() const { sortOrder(); return const_iterator(this, order.empty() ? nonePosition() : order.front(), 0); }
+            inline const_iterator end() const { return const_iterator(this); }
+            inline const_iterator cbegin() const { return begin(); }
+            inline const_iterator cend() const { return end(); }
+
+            iterator find(const key_type& _key)
+            {
+                const size_type slot_index = findSlot(_key);
+                return (slot_index == slots.size()) ? end() : iterator(this, slot_index);
+            }
+
+            const_iterator find(const key_type& _key) const
+            {
+                const size_type slot_index = findSlot(_key);
+                return (slot_index == slots.size()) ? end() : const_iterator(this, slot_index);
+            }
+
+            inline size_type count(const key_type& _key) const
+            {
+                return (findSlot(_key) == slots.size()) ? 0 : 1;
+            }
+
+            /*!
+             * Insert an item, it does nothing if the key is existed.
+             */
+            std::pair<iterator, bool> insert(const value_type& _value)
+            {
+                const size_type found_slot_index = findSlot(_value.first);
+                if (found_slot_index != slots.size())
+                {
+                    return std::make_pair(iterator(this, found_slot_index), false);
+                }
+
+                size_type slot_index = slots.size();
+                if (free_slots.empty())
+                {
+                    slots.push_back(slot(_value));
+                }
+                else
+                {
+                    /// the key is const, so the slot is constructed again
+                    slot_index = free_slots.back();
+                    free_slots.pop_back();
+                    const std::uint32_t generation = slots[slot_index].generation;
+                    slots[slot_index].~slot();
+                    new (&slots[slot_index]) slot(_value, generation);
+                }
+                ++items_count;
+
+                /// append it if it is the biggest key, otherwise the order list is sorted by the next iteration
+                if (sorted_count == order.size() && (order.empty() || slots[order.back()].value.first < _value.first))
+                {
+                    slots[slot_index].position = order.size();
+                    ++sorted_count;
+                }
+                else
+                {
+                    sorted.store(false, std::memory_order_relaxed);
+                }
+                order.push_back(slot_index);
+
+                if ((slots.size() * 4) > (buckets.size() * 3))
+                {
+                    rehash(slots.size() * 2);
+                }
+                else
+                {
+                    insertBucket(_value.first, slot_index);
+                }
+                return std::make_pair(iterator(this, slot_index), true);
+            }
+
+            mapped_type& operator[](const key_type& _key)
+            {
+                return insert(value_type(_key, mapped_type())).first->second;
+            }
+
+            /*!
+             * Erase an item by its key, and its handle becomes invalid.
+             * 
+             * The slot is reused after the order list is rebuilt.
+             */
+            size_type erase(const key_type& _key)
+            {
+                const size_type slot_index = findSlot(_key);
+                if (slot_index == slots.size())
+                {
+                    return 0;
+                }
+                eraseBucket(_key);
+
+                slot& old_slot = slots[slot_index];
+                old_slot.alive = false;
+                ++old_slot.generation;
+                erased_slots.push_back(slot_index);
+                --items_count;
+                sorted.store(false, std::memory_order_relaxed);
+                /// rebuild the order list if most of it are erased, so the erased slots can be reused
+                if (erased_slots.size() > items_count + 16)
+                {
+                    sortOrder();
+                }
+                return 1;
+            }
+
+            /*!
+             * Get the generational handle of an item, it is invalid if the key is not found.
+             */
+            handle_type handle(const key_type& _key) const
+            {
+                const size_type slot_index = findSlot(_key);
+                if (slot_index == slots.size())
+                {
+                    return handle_type();
+                }
+                return handle_type(static_cast<std::uint32_t>(slot_index), slots[slot_index].generation);
+            }
+
+            /*!
+             * Get an item by its generational handle, return `nullptr` if the item has been erased.
+             */
+            const value_type* get(const handle_type& _handle) const
+            {
+                if (_handle.index >= slots.size()) return nullptr;
+                const slot& found_slot = slots[_handle.index];
+                if (!found_slot.alive || found_slot.generation != _handle.generation) return nullptr;
+                return &found_slot.value;
+            }
+
+            value_type* get(const handle_type& _handle)
+            {
+                return const_cast<value_type*>(static_cast<const slot_map*>(this)->get(_handle));
+            }
+
+        private:
+            static size_type hashKey(const key_type& _key, size_type _mask)
+            {
+                return static_cast<size_type>((static_cast<std::uint64_t>(_key) * 0x9E3779B97F4A7C15ull) >> 32) & _mask;
+            }
+
+            void copy(const slot_map& _a)
+            {
+                _a.sortOrder();
+                std::vector<slot>(_a.slots).swap(slots);
+                free_slots = _a.free_slots;
+                erased_slots.clear();
+                order = _a.order;
+                buckets = _a.buckets;
+                items_count = _a.items_count;
+                sorted_count = _a.sorted_count;
+                sorted.store(true, std::memory_order_relaxed);
+            }
+
+            /*!
+             * Rebuild the order list after inserting or erasing, the erased slots are removed, and the unsorted keys are sorted and merged.
+             * 
+             * It is called by the const iterations, so it is locked, and it is checked again after locking.
+             */
+            void sortOrder() const
+            {
+                if (sorted.load(std::memory_order_acquire)) return;
+                std::lock_guard<std::mutex> lock(mutex);
+                if (sorted.load(std::memory_order_relaxed)) return;
+
+                size_type kept_sorted_count = 0;
+                size_type kept_count = 0;
+                for (size_type i = 0, ic = order.size(); i < ic; ++i)
+                {
+                    if (!slots[order[i]].alive) continue;
+                    if (i < sorted_count) ++kept_sorted_count;
+                    order[kept_count++] = order[i];
+                }
+                order.resize(kept_count);
+                auto less = [this](size_type _a, size_type _b) { return slots[_a].value.first < slots[_b].value.first; };
+                std::sort(order.begin() + kept_sorted_count, order.end(), less);
+                std::inplace_merge(order.begin(), order.begin() + kept_sorted_count, order.end(), less);
+                for (size_type i = 0, ic = order.size(); i < ic; ++i)
+                {
+                    slots[order[i]].position = i;
+                }
+                free_slots.insert(free_slots.end(), erased_slots.begin(), erased_slots.end());
+                erased_slots.clear();
+                sorted_count = order.size();
+                sorted.store(true, std::memory_order_release);
+            }
+
+            size_type findSlot(const key_type& _key) const
+            {
+                if (buckets.empty()) return slots.size();
+                const size_type mask = buckets.size() - 1;
+                for (size_type i = hashKey(_key, mask); buckets[i].second != 0; i = (i + 1) & mask)
+                {
+                    if (buckets[i].first == _key) return buckets[i].second - 1;
+                }
+                return slots.size();
+            }
+
+            void insertBucket(const key_type& _key, size_type _slot_index)
+            {
+                const size_type mask = buckets.size() - 1;
+                size_type i = hashKey(_key, mask);
+                while (buckets[i].second != 0)
+                {
+                    i = (i + 1) & mask;
+                }
+                buckets[i] = std::make_pair(_key, _slot_index + 1);
+            }
+
+            /// erase by the backward shift, so no tombstone is needed
+            void eraseBucket(const key_type& _key)
+            {
+                const size_type mask = buckets.size() - 1;
+                size_type i = hashKey(_key, mask);
+                while (buckets[i].first != _key || buckets[i].second == 0)
+                {
+                    i = (i + 1) & mask;
+                }
+                for (size_type j = (i + 1) & mask; buckets[j].second != 0; j = (j + 1) & mask)
+                {
+                    const size_type k = hashKey(buckets[j].first, mask);
+                    const bool can_move = (i <= j) ? (k <= i || k > j) : (k <= i && k > j);
+                    if (can_move)
+                    {
+                        buckets[i] = buckets[j];
+                        i = j;
+                    }
+                }
+                buckets[i] = std::make_pair(key_type(), 0);
+            }
+
+            void rehash(size_type _count)
+            {
+                size_type bucket_count = 16;
+                while (bucket_count * 3 < _count * 4)
+                {
+                    bucket_count *= 2;
+                }
+                if (bucket_count <= buckets.size()) return;
+                buckets.assign(bucket_count, std::make_pair(key_type(), static_cast<size_type>(0)));
+                for (size_type slot_index = 0, slot_count = slots.size(); slot_index < slot_count; ++slot_index)
+                {
+                    if (slots[slot_index].alive)
+                    {
+                        insertBucket(slots[slot_index].value.first, slot_index);
+                    }
+                }
+            }
+
+        private:
+            mutable std::vector<slot>                       slots;
+            mutable std::vector<size_type>                  free_slots;
+            mutable std::vector<size_type>                  erased_slots;   ///< The erased slots which are still in the order list
+            mutable std::vector<size_type>                  order;          ///< The slot indices in the order of keys, and the unsorted ones after `sorted_count`
+            std::vector<std::pair<key_type, size_type>>     buckets;        ///< The keys and the slot indices + 1, 0 means empty
+            size_type                                       items_count;
+            mutable size_type                               sorted_count;   ///< The count of the sorted part of the order list
+            mutable std::atomic<bool>                       sorted;         ///< Is the order list rebuilt after the last change?
+            mutable std::mutex                              mutex;
         };
 
-        template<typename TConstant = constant<>>
-        class building
+        /*!
+         * The storage of entities, it stores them by `std::map`.
+         */
+        class map_storage
         {
         public:
-            typedef typename TConstant::id_type         id_type;
-            typedef house<TConstant>                    house_type;
-            typedef std::map<id_type, house_type>       house_map;
-            typedef typename TConstant::point_type      position_type;
-            typedef std::map<position_type, id_type>    potision_map;
+            template<typename TKey, typename TValue>
+            class rebind
+            {
+            public:
+                typedef std::map<TKey, TValue>      type;
+            };
+        };
 
+        /*!
+         * The storage of entities, it stores them by `slot_map`.
+         */
+        class slot_storage
+        {
         public:
-            house_map houses;
-            potision_map positions;
+            template<typename TKey, typename TValue>
+            class rebind
+            {
+            public:
+                typedef slot_map<TKey, TValue>      type;
+            };
         };
 
-        template<typename TConstant = constant<>>
-        class site
+        /*!
+         * The interned strings of `symbol`, every string is stored once and kept until the process exits.
+         * 
+         * The strings are stored in chunks which are never moved, so they can be read without any lock,
+         * only interning a new string locks the table.
+         * 
+         * The table is shared by the process and never shrinks, so `intern` throws `std::length_error` if there are `maxSize()` symbols,
+         * it is `chunk_size * max_chunks` by default and can be lowered by `setMaxSize` to bound the memory of untrusted strings.
+         */
+        class symbol_table
         {
         public:
-            typedef typename TConstant::id_type         id_type;
-            typedef building<TConstant>                 building_type;
-            typedef std::map<id_type, building_type>    building_map;
+            typedef std::uint32_t   id_type;
+
+            static const size_t chunk_size = 4096;
+            static const size_t max_chunks = 1024;
 
         public:
-            std::string name;
-            building_map buildings;
+            static symbol_table& instance()
+            {
+                static symbol_table table;
+                return table;
+            }
+
+            ~symbol_table()
+            {
+                for (size_t i = 0; i < max_chunks; ++i)
+                {
+                    delete[] chunks[i].load(std::memory_order_relaxed);
+                }
+            }
+
+        public:
+            /*!
+             * Get the id of a string, it is added if it is not found, the id of the empty string is 0.
+             */
+            id_type intern(const std::string& _string)
+            {
+                if (_string.empty()) return 0;
+                std::lock_guard<std::mutex> lock(mutex);
+                std::unordered_map<std::string, id_type>::const_iterator cit_found = ids.find(_string);
+                if (cit_found != ids.cend())
+                {
+                    return cit_found->second;
+                }
+
+                const size_t bim_index = count.load(std::memory_order_relaxed);
+                if (bim_index >= max_size.load(std::memory_order_relaxed))
+                {
+                    throw std::length_error("too many symbols!");
+                }
+                std::string* bim_chunk = chunks[bim_index / chunk_size].load(std::memory_order_relaxed);
+                if (bim_chunk == nullptr)
+                {
+                    bim_chunk = new std::string[chunk_size];
+                    chunks[bim_index / chunk_size].store(bim_chunk, std::memory_order_release);
+                }
+                bim_chunk[bim_index % chunk_size] = _string;
+                ids.insert(std::make_pair(_string, static_cast<id_type>(bim_index)));
+                count.store(bim_index + 1, std::memory_order_release);
+                return static_cast<id_type>(bim_index);
+            }
+
+            /*!
+             * Find the id of a string without adding it, return false if it is not found.
+             */
+            bool find(const std::string& _string, id_type& _id) const
+            {
+                if (_string.empty())
+                {
+                    _id = 0;
+                    return true;
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                std::unordered_map<std::string, id_type>::const_iterator cit_found = ids.find(_string);
+                if (cit_found == ids.cend()) return false;
+                _id = cit_found->second;
+                return true;
+            }
+
+            /*!
+             * Get the string of an id which is returned by `intern`.
+             */
+            const std::string& str(id_type _id) const
+            {
+                assert(_id < count.load(std::memory_order_acquire));
+                return chunks[_id / chunk_size].load(std::memory_order_acquire)[_id % chunk_size];
+            }
+
+            size_t size() const
+            {
+                return count.load(std::memory_order_acquire);
+            }
+
+            size_t maxSize() const
+            {
+                return max_size.load(std::memory_order_relaxed);
+            }
+
+            /*!
+             * Set the max count of symbols, including the empty string, it is not bigger than `chunk_size * max_chunks`.
+             * The interned symbols are kept if there are more than it, only the new strings can't be interned.
+             */
+            void setMaxSize(size_t _max_size)
+            {
+                max_size.store(std::min(_max_size, chunk_size * max_chunks), std::memory_order_relaxed);
+            }
+
+        private:
+            symbol_table()
+                : mutex()
+                , ids()
+                , count(1)
+                , max_size(chunk_size * max_chunks)
+            {
+                for (size_t i = 0; i < max_chunks; ++i)
+                {
+                    chunks[i].store(nullptr, std::memory_order_relaxed);
+                }
+                chunks[0].store(new std::string[chunk_size], std::memory_order_release);
+            }
+
+            symbol_table(const symbol_table&);
+            symbol_table& operator=(const symbol_table&);
+
+        private:
+            mutable std::mutex                          mutex;
+            std::unordered_map<std::string, id_type>    ids;
+            std::atomic<size_t>                         count;
+            std::atomic<size_t>                         max_size;
+            std::atomic<std::string*>                   chunks[max_chunks];
         };
 
-        template<typename TConstant = constant<>>
-        class project
+        /*!
+         * An interned string, it is a 4-byte id of `symbol_table`.
+         * 
+         * Copying and comparing symbols don't touch the strings, so filtering the entities by kind is \f$ O(1) \f$.
+         * The order of symbols is the order of their ids, not the order of their strings.
+         */
+        class symbol
         {
         public:
-            typedef typename TConstant::id_type         id_type;
-            typedef site<TConstant>                     site_type;
-            typedef std::map<id_type, site_type>        site_map;
+            typedef symbol_table::id_type   id_type;
 
         public:
-            std::string name;
-            site_map sites;
+            symbol()
+                : id(0)
+            {}
+
+            symbol(const std::string& _string)
+                : id(symbol_table::instance().intern(_string))
+            {}
+
+            symbol(const char* _string)
+                : id((_string == nullptr || *_string == 0) ? 0 : symbol_table::instance().intern(_string))
+            {}
+
+        public:
+            /*!
+             * Find the symbol of a string without adding it into `symbol_table`, return false if it is not found.
+             */
+            static bool find(const std::string& _string, symbol& _symbol)
+            {
+                return symbol_table::instance().find(_string, _symbol.id);
+            }
+
+            inline id_type value() const
+            {
+                return id;
+            }
+
+            inline bool empty() const
+            {
+                return (id == 0);
+            }
+
+            inline const std::string& str() const
+            {
+                return symbol_table::instance().str(id);
+            }
+
+            inline operator const std::string&() const
+            {
+                return str();
+            }
+
+            friend inline bool operator==(const symbol& _a, const symbol& _b) { return _a.id == _b.id; }
+            friend inline bool operator!=(const symbol& _a, const symbol& _b) { return _a.id != _b.id; }
+            friend inline bool operator<(const symbol& _a, const symbol& _b) { return _a.id < _b.id; }
+
+            /// comparing with a string looks it up in `symbol_table` without interning it, so make a symbol of it once in a loop
+            friend inline bool operator==(const symbol& _a, const std::string& _b) { return _a.isSame(_b); }
+            friend inline bool operator!=(const symbol& _a, const std::string& _b) { return !_a.isSame(_b); }
+            friend inline bool operator==(const symbol& _a, const char* _b) { return _a.isSame(_b); }
+            friend inline bool operator!=(const symbol& _a, const char* _b) { return !_a.isSame(_b); }
+            friend inline bool operator==(const std::string& _a, const symbol& _b) { return _b.isSame(_a); }
+            friend inline bool operator!=(const std::string& _a, const symbol& _b) { return !_b.isSame(_a); }
+            friend inline bool operator==(const char* _a, const symbol& _b) { return _b.isSame(_a); }
+            friend inline bool operator!=(const char* _a, const symbol& _b) { return !_b.isSame(_a); }
+
+        private:
+            /// a string which isn't interned isn't the string of any symbol
+            bool isSame(const std::string& _string) const
+            {
+                if (id == 0) return _string.empty();
+                id_type bim_id = 0;
+                return symbol_table::instance().find(_string, bim_id) && bim_id == id;
+            }
+
+            bool isSame(const char* _string) const
+            {
+                if (_string == nullptr || *_string == 0) return (id == 0);
+                return (id != 0) && isSame(std::string(_string));
+            }
+
+        private:
+            id_type id;
+        };
+
+        /*!
+         * Define some classes and declare some constant values
+         */
+        template<typename TPrecision = double, typename TPoint = point<TPrecision>, typename TStorage = map_storage, typename TKind = symbol, typename TId = size_t>
+        class constant
+        {
+        public:
+            typedef TPrecision      precision_type;
+            /// Define the point type
+            typedef TPoint          point_type;
+            /// Define the ids of entities, `std::uint32_t` halves the size of ids if there are less than \f$ 2^{32} - 1 \f$ entities, see `algorithm::renumberHouse`
+            typedef TId             id_type;
+            /// Define how to store the entities of a house, `map_storage` or `slot_storage`
+            typedef TStorage        storage_type;
+            /// Define the kinds of walls, holes and rooms, and the directions of holes, `symbol` or `std::string`
+            typedef TKind           kind_type;
+
+        public:
+            static constexpr point_type zero_point = point_type(0, 0);  ///< Origin point
+            static constexpr point_type unit_point = point_type(1, 1);  ///< Unit point
+            static const id_type    none_id;        ///< Invalid id
+
+        public:
+            /*!
+             * Is id valid?
+             */
+            static bool isValid(id_type _id)
+            {
+                return (_id != none_id);
+            }
+
+            template<typename TV>
+            static TPrecision convert(TV _v)
+            {
+                return static_cast<TPrecision>(_v);
+            }
+        };
+
+        template<typename TPrecision, typename TPoint, typename TStorage, typename TKind, typename TId>
+        constexpr typename constant<TPrecision, TPoint, TStorage, TKind, TId>::point_type    constant<TPrecision, TPoint, TStorage, TKind, TId>::zero_point;
+        template<typename TPrecision, typename TPoint, typename TStorage, typename TKind, typename TId>
+        constexpr typename constant<TPrecision, TPoint, TStorage, TKind, TId>::point_type    constant<TPrecision, TPoint, TStorage, TKind, TId>::unit_point;
+        template<typename TPrecision, typename TPoint, typename TStorage, typename TKind, typename TId>
+        const typename constant<TPrecision, TPoint, TStorage, TKind, TId>::id_type       constant<TPrecision, TPoint, TStorage, TKind, TId>::none_id(-1);
+
+        /*!
+         * A node represents a point or a joint with two walls in the 2D plan
+         * 
+         * @brief A point or a joint in the plan
+         */
+        template<typename TConstant = constant<>>
+        class node
+        {
+        public:
+            typedef typename TConstant::precision_type  precision_type;
+            typedef typename TConstant::point_type      point_type;
+
+        public:
+            /*!
+             * A constructor by a 2D coordinate
+             * 
+             * @param _x The value in x-axis, default is 0.
+             * @param _y The value in y-axis, default is 0.
+             */
+            constexpr node(precision_type _x = 0, precision_type _y = 0) noexcept
+                : point(_x, _y)
+            {}
+
+            /*!
+             * A constructor by a 2D point
+             * 
+             * @param _point A 2D point, default is origin point.
+             */
+            constexpr node(const point_type& _point = TConstant::zero_point) noexcept
+                : point(_point)
+            {}
+
+        public:
+            constexpr const point_type& p() const noexcept
+            {
+                return point;
+            }
+
+            constexpr precision_type x() const noexcept
+            {
+                return point.x();
+            }
+
+            inline node& x(precision_type _x) noexcept
+            {
+                point.x(_x);
+                return *this;
+            }
+
+            constexpr precision_type y() const noexcept
+            {
+                return point.y();
+            }
+
+            inline node& y(precision_type _x) noexcept
+            {
+                point.y(_x);
+                return *this;
+            }
+
+        private:
+            /*!
+             * The point or position of the node
+             */
+            point_type point;
+        };
+
+        static_assert(std::is_trivially_copyable<node<constant<float>>>::value && std::is_trivially_copyable<node<constant<double>>>::value, "node must be trivially copyable!");
+        static_assert(sizeof(node<constant<float>>) == sizeof(point<float>) && sizeof(node<constant<double>>) == sizeof(point<double>), "node must be packed!");
+        static_assert(node<constant<float>>(1, 2).y() == 2 && node<constant<double>>(constant<double>::unit_point).x() == 1, "node must be constexpr!");
+
+        /*!
+         * A wall represents a wall in the 2D plan
+         */
+        template<typename TConstant = constant<>>
+        class wall
+        {
+        public:
+            typedef typename TConstant::precision_type  precision_type;
+            typedef typename TConstant::id_type         id_type;
+            typedef typename TConstant::kind_type       kind_type;
+
+        public:
+            wall(id_type _start_node_id = TConstant::none_id
+                , id_type _end_node_id = TConstant::none_id
+                , precision_type _thickness = 0)
+                : kind()
+                , start_node_id(_start_node_id)
+                , end_node_id(_end_node_id)
+                , thickness(_thickness)
+            {}
+
+        public:
+            inline bool isValid() const
+            {
+                return (TConstant::isValid(start_node_id)
+                    && TConstant::isValid(end_node_id)
+                    && start_node_id != end_node_id
+                    && thickness >= 0);
+            }
+
+        public:
+            /// The kind of wall
+            kind_type       kind;
+            /// The start of wall
+            id_type         start_node_id;
+            /// The end of wall
+            id_type         end_node_id;
+            /// The thickness of wall
+            precision_type  thickness;
+        };
+
+        /*!
+         * A hole represents a hole in the 2D plan,
+         * it might be a window or a door or a hole in a wall.
+         */
+        template<typename TConstant = constant<>>
+        class hole
+        {
+        public:
+            typedef typename TConstant::precision_type  precision_type;
+            typedef typename TConstant::id_type         id_type;
+            typedef typename TConstant::kind_type       kind_type;
+
+        public:
+            hole(id_type _wall_id = TConstant::none_id
+                , precision_type _distance = 0
+                , precision_type _width = 0)
+                : kind()
+                , direction()
+                , wall_id(_wall_id)
+                , distance(_distance)
+                , width(_width)
+            {}
+
+        public:
+            inline bool isValid() const
+            {
+                return (TConstant::isValid(wall_id)
+                    && distance != 0
+                    && width != 0);
+            }
+
+        public:
+            kind_type       kind;
+            kind_type       direction;
+            id_type         wall_id;
+            precision_type  distance;
+            precision_type  width;
+        };
+
+        template<typename TConstant = constant<>>
+        class room
+        {
+        public:
+            typedef typename TConstant::id_type         id_type;
+            typedef typename TConstant::kind_type       kind_type;
+            typedef std::vector<id_type>                id_vector;
+
+        public:
+            room()
+                : kind()
+                , wall_ids()
+            {}
+
+        public:
+            kind_type       kind;
+            id_vector       wall_ids;
+        };
+
+        template<typename TConstant = constant<>>
+        class house
+        {
+        public:
+            typedef typename TConstant::storage_type    storage_type;
+            typedef typename TConstant::id_type         id_type;
+            typedef node<TConstant>                     node_type;
+            typedef typename storage_type::template rebind<id_type, node_type>::type node_map;
+            typedef std::pair<id_type, node_type>       node_pair;
+            typedef wall<TConstant>                     wall_type;
+            typedef typename storage_type::template rebind<id_type, wall_type>::type wall_map;
+            typedef std::pair<id_type, wall_type>       wall_pair;
+            typedef hole<TConstant>                     hole_type;
+            typedef typename storage_type::template rebind<id_type, hole_type>::type hole_map;
+            typedef std::pair<id_type, hole_type>       hole_pair;
+            typedef room<TConstant>                     room_type;
+            typedef typename storage_type::template rebind<id_type, room_type>::type room_map;
+            typedef std::pair<id_type, room_type>       room_pair;
+
+        public:
+            house()
+                : name("")
+                , nodes()
+                , walls()
+                , holes()
+                , rooms()
+            {}
+
+        public:
+            inline void reset()
+            {
+                name = "";
+                nodes.clear();
+                walls.clear();
+                holes.clear();
+                rooms.clear();
+            }
+
+        public:
+            std::string name;
+            node_map nodes;
+            wall_map walls;
+            hole_map holes;
+            room_map rooms;
+        };
+
+        template<typename TConstant = constant<>>
+        class building
+        {
+        public:
+            typedef typename TConstant::id_type         id_type;
+            typedef house<TConstant>                    house_type;
+            typedef std::map<id_type, house_type>       house_map;
+            typedef typename TConstant::point_type      position_type;
+            typedef std::map<position_type, id_type>    potision_map;
+
+        public:
+            house_map houses;
+            potision_map positions;
+        };
+
+        template<typename TConstant = constant<>>
+        class site
+        {
+        public:
+            typedef typename TConstant::id_type         id_type;
+            typedef building<TConstant>                 building_type;
+            typedef std::map<id_type, building_type>    building_map;
+
+        public:
+            std::string name;
+            building_map buildings;
+        };
+
+        template<typename TConstant = constant<>>
+        class project
+        {
+        public:
+            typedef typename TConstant::id_type         id_type;
+            typedef site<TConstant>                     site_type;
+            typedef std::map<id_type, site_type>        site_map;
+
+        public:
+            std::string name;
+            site_map sites;
+        };
+
+        /*!
+         * The versioned little-endian binary format of houses and projects.
+         * 
+         * A file starts with a header of `header_size` bytes:
+         * 
+         * | Offset | Type         | Value                                                  |
+         * |--------|--------------|--------------------------------------------------------|
+         * | 0      | char[8]      | `"BIMPP2D"`                                            |
+         * | 8      | uint32       | `version`                                              |
+         * | 12     | uint32       | `content_house` or `content_project`                   |
+         * | 16     | string       | The name of the project                                |
+         * | 24     | uint32       | `section_count`                                        |
+         * | 28     | uint32       | Reserved, 0                                            |
+         * | 32     | section[]    | The offset and the count of records of every section   |
+         * 
+         * Every section is a flat table of fixed-size records, and starts at a multiple of 8 bytes.
+         * A string is a pair of uint32 offset and uint32 length in the string section, and all integers are little-endian.
+         * The houses of all buildings of all sites are stored in a table, and every house owns a range of nodes, walls, holes and rooms,
+         * they are sorted by their ids.
+         */
+        class binary_format
+        {
+        public:
+            static const std::uint32_t version = 1;
+
+            enum content
+            {
+                content_house = 1,      ///< Only a house
+                content_project = 2,    ///< The sites, buildings and houses of a project
+            };
+
+            enum section
+            {
+                section_strings,    ///< 1 byte: all strings
+                section_sites,      ///< 32 bytes: id, name, the range of buildings
+                section_buildings,  ///< 40 bytes: id, the range of houses, the range of positions
+                section_positions,  ///< 24 bytes: x, y, the id of house
+                section_houses,     ///< 80 bytes: id, name, the ranges of nodes, walls, holes and rooms
+                section_nodes,      ///< 24 bytes: id, x, y
+                section_walls,      ///< 40 bytes: id, start node id, end node id, thickness, kind
+                section_holes,      ///< 48 bytes: id, wall id, distance, width, kind, direction
+                section_rooms,      ///< 32 bytes: id, kind, the range of room walls
+                section_room_walls, ///< 8 bytes: the id of wall
+                section_count,
+            };
+
+            static const size_t header_size = 32 + section_count * 16;
+
+        public:
+            static const char* magic()
+            {
+                return "BIMPP2D";
+            }
+
+            static size_t recordSize(section _section)
+            {
+                static const size_t record_sizes[section_count] = { 1, 32, 40, 24, 80, 24, 40, 48, 32, 8 };
+                return record_sizes[_section];
+            }
+
+            static std::uint32_t readU32(const char* _p)
+            {
+                const unsigned char* p = reinterpret_cast<const unsigned char*>(_p);
+                return static_cast<std::uint32_t>(p[0])
+                    | (static_cast<std::uint32_t>(p[1]) << 8)
+                    | (static_cast<std::uint32_t>(p[2]) << 16)
+                    | (static_cast<std::uint32_t>(p[3]) << 24);
+            }
+
+            static std::uint64_t readU64(const char* _p)
+            {
+                return static_cast<std::uint64_t>(readU32(_p))
+                    | (static_cast<std::uint64_t>(readU32(_p + 4)) << 32);
+            }
+
+            static double readF64(const char* _p)
+            {
+                const std::uint64_t bits = readU64(_p);
+                double v = 0;
+                std::memcpy(&v, &bits, sizeof(v));
+                return v;
+            }
+
+            static void writeU32(char* _p, std::uint32_t _v)
+            {
+                for (size_t i = 0; i < 4; ++i)
+                {
+                    _p[i] = static_cast<char>((_v >> (i * 8)) & 0xFF);
+                }
+            }
+
+            static void writeU64(char* _p, std::uint64_t _v)
+            {
+                writeU32(_p, static_cast<std::uint32_t>(_v & 0xFFFFFFFF));
+                writeU32(_p + 4, static_cast<std::uint32_t>(_v >> 32));
+            }
+
+            static void writeF64(char* _p, double _v)
+            {
+                std::uint64_t bits = 0;
+                std::memcpy(&bits, &_v, sizeof(bits));
+                writeU64(_p, bits);
+            }
+        };
+
+        /*!
+         * Write houses and projects in `binary_format`.
+         */
+        template<typename TConstant = constant<>>
+        class binary_writer
+        {
+        public:
+            typedef typename TConstant::id_type         id_type;
+            typedef house<TConstant>                    house_type;
+            typedef building<TConstant>                 building_type;
+            typedef site<TConstant>                     site_type;
+            typedef project<TConstant>                  project_type;
+
+        public:
+            /*!
+             * Write a house.
+             * 
+             * @param _house The house
+             * @param _bytes Output the bytes of the file
+             */
+            static void write(const house_type& _house, std::vector<char>& _bytes)
+            {
+                tables bim_tables;
+                appendHouse(bim_tables, TConstant::none_id, _house);
+                bim_tables.finish(binary_format::content_house, std::string(), _bytes);
+            }
+
+            /*!
+             * Write a project with all its sites, buildings and houses.
+             * 
+             * @param _project The project
+             * @param _bytes Output the bytes of the file
+             */
+            static void write(const project_type& _project, std::vector<char>& _bytes)
+            {
+                tables bim_tables;
+                for (typename project_type::site_map::const_iterator cit_site = _project.sites.cbegin(); cit_site != _project.sites.cend(); ++cit_site)
+                {
+                    const site_type& bim_site = cit_site->second;
+                    char* bim_site_record = bim_tables.append(binary_format::section_sites);
+                    binary_format::writeU64(bim_site_record, toU64(cit_site->first));
+                    bim_tables.writeString(bim_site_record + 8, bim_site.name);
+                    binary_format::writeU64(bim_site_record + 16, bim_tables.count(binary_format::section_buildings));
+                    binary_format::writeU64(bim_site_record + 24, bim_site.buildings.size());
+                    for (typename site_type::building_map::const_iterator cit_building = bim_site.buildings.cbegin(); cit_building != bim_site.buildings.cend(); ++cit_building)
+                    {
+                        const building_type& bim_building = cit_building->second;
+                        char* bim_building_record = bim_tables.append(binary_format::section_buildings);
+                        binary_format::writeU64(bim_building_record, toU64(cit_building->first));
+                        binary_format::writeU64(bim_building_record + 8, bim_tables.count(binary_format::section_houses));
+                        binary_format::writeU64(bim_building_record + 16, bim_building.houses.size());
+                        binary_format::writeU64(bim_building_record + 24, bim_tables.count(binary_format::section_positions));
+                        binary_format::writeU64(bim_building_record + 32, bim_building.positions.size());
+                        for (typename building_type::house_map::const_iterator cit_house = bim_building.houses.cbegin(); cit_house != bim_building.houses.cend(); ++cit_house)
+                        {
+                            appendHouse(bim_tables, cit_house->first, cit_house->second);
+                        }
+                        for (typename building_type::potision_map::const_iterator cit_position = bim_building.positions.cbegin(); cit_position != bim_building.positions.cend(); ++cit_position)
+                        {
+                            char* bim_position_record = bim_tables.append(binary_format::section_positions);
+                            binary_format::writeF64(bim_position_record, static_cast<double>(cit_position->first.x()));
+                            binary_format::writeF64(bim_position_record + 8, static_cast<double>(cit_position->first.y()));
+                            binary_format::writeU64(bim_position_record + 16, toU64(cit_position->second));
+                        }
+                    }
+                }
+                bim_tables.finish(binary_format::content_project, _project.name, _bytes);
+            }
+
+        private:
+            /// the sections which are being written, the same strings are only stored once
+            class tables
+            {
+            public:
+                tables()
+                    : sections()
+                    , strings()
+                {}
+
+            public:
+                inline std::uint64_t count(binary_format::section _section) const
+                {
+                    return sections[_section].size() / binary_format::recordSize(_section);
+                }
+
+                inline char* append(binary_format::section _section)
+                {
+                    std::vector<char>& bim_bytes = sections[_section];
+                    bim_bytes.resize(bim_bytes.size() + binary_format::recordSize(_section), 0);
+                    return &bim_bytes[bim_bytes.size() - binary_format::recordSize(_section)];
+                }
+
+                void writeString(char* _p, const std::string& _string)
+                {
+                    std::vector<char>& bim_bytes = sections[binary_format::section_strings];
+                    std::map<std::string, std::uint32_t>::const_iterator cit_found = strings.find(_string);
+                    std::uint32_t bim_offset = 0;
+                    if (cit_found != strings.cend())
+                    {
+                        bim_offset = cit_found->second;
+                    }
+                    else
+                    {
+                        bim_offset = static_cast<std::uint32_t>(bim_bytes.size());
+                        bim_bytes.insert(bim_bytes.end(), _string.begin(), _string.end());
+                        strings.insert(std::make_pair(_string, bim_offset));
+                    }
+                    binary_format::writeU32(_p, bim_offset);
+                    binary_format::writeU32(_p + 4, static_cast<std::uint32_t>(_string.size()));
+                }
+
+                void finish(binary_format::content _content, const std::string& _name, std::vector<char>& _bytes)
+                {
+                    char bim_name[8];
+                    writeString(bim_name, _name);
+                    if (sections[binary_format::section_strings].size() > 0xFFFFFFFFull)
+                    {
+                        throw std::length_error("too many strings!");
+                    }
+
+                    _bytes.assign(binary_format::header_size, 0);
+                    std::memcpy(&_bytes[0], binary_format::magic(), 8);
+                    binary_format::writeU32(&_bytes[8], binary_format::version);
+                    binary_format::writeU32(&_bytes[12], static_cast<std::uint32_t>(_content));
+                    std::memcpy(&_bytes[16], bim_name, 8);
+                    binary_format::writeU32(&_bytes[24], binary_format::section_count);
+                    for (size_t i = 0; i < binary_format::section_count; ++i)
+                    {
+                        const binary_format::section bim_section = static_cast<binary_format::section>(i);
+                        _bytes.resize((_bytes.size() + 7) / 8 * 8, 0);
+                        binary_format::writeU64(&_bytes[32 + i * 16], _bytes.size());
+                        binary_format::writeU64(&_bytes[32 + i * 16 + 8], count(bim_section));
+                        _bytes.insert(_bytes.end(), sections[i].begin(), sections[i].end());
+                    }
+                }
+
+            private:
+                std::array<std::vector<char>, binary_format::section_count> sections;
+                std::map<std::string, std::uint32_t>                        strings;
+            };
+
+            static inline std::uint64_t toU64(id_type _id)
+            {
+                return TConstant::isValid(_id) ? static_cast<std::uint64_t>(_id) : ~static_cast<std::uint64_t>(0);
+            }
+
+            static void appendHouse(tables& _tables, id_type _house_id, const house_type& _house)
+            {
+                char* bim_house_record = _tables.append(binary_format::section_houses);
+                binary_format::writeU64(bim_house_record, toU64(_house_id));
+                _tables.writeString(bim_house_record + 8, _house.name);
+                binary_format::writeU64(bim_house_record + 16, _tables.count(binary_format::section_nodes));
+                binary_format::writeU64(bim_house_record + 24, _house.nodes.size());
+                binary_format::writeU64(bim_house_record + 32, _tables.count(binary_format::section_walls));
+                binary_format::writeU64(bim_house_record + 40, _house.walls.size());
+                binary_format::writeU64(bim_house_record + 48, _tables.count(binary_format::section_holes));
+                binary_format::writeU64(bim_house_record + 56, _house.holes.size());
+                binary_format::writeU64(bim_house_record + 64, _tables.count(binary_format::section_rooms));
+                binary_format::writeU64(bim_house_record + 72, _house.rooms.size());
+
+                for (typename house_type::node_map::const_iterator cit = _house.nodes.cbegin(); cit != _house.nodes.cend(); ++cit)
+                {
+                    char* bim_record = _tables.append(binary_format::section_nodes);
+                    binary_format::writeU64(bim_record, toU64(cit->first));
+                    binary_format::writeF64(bim_record + 8, static_cast<double>(cit->second.x()));
+                    binary_format::writeF64(bim_record + 16, static_cast<double>(cit->second.y()));
+                }
+                for (typename house_type::wall_map::const_iterator cit = _house.walls.cbegin(); cit != _house.walls.cend(); ++cit)
+                {
+                    char* bim_record = _tables.append(binary_format::section_walls);
+                    binary_format::writeU64(bim_record, toU64(cit->first));
+                    binary_format::writeU64(bim_record + 8, toU64(cit->second.start_node_id));
+                    binary_format::writeU64(bim_record + 16, toU64(cit->second.end_node_id));
+                    binary_format::writeF64(bim_record + 24, static_cast<double>(cit->second.thickness));
+                    _tables.writeString(bim_record + 32, cit->second.kind);
+                }
+                for (typename house_type::hole_map::const_iterator cit = _house.holes.cbegin(); cit != _house.holes.cend(); ++cit)
+                {
+                    char* bim_record = _tables.append(binary_format::section_holes);
+                    binary_format::writeU64(bim_record, toU64(cit->first));
+                    binary_format::writeU64(bim_record + 8, toU64(cit->second.wall_id));
+                    binary_format::writeF64(bim_record + 16, static_cast<double>(cit->second.distance));
+                    binary_format::writeF64(bim_record + 24, static_cast<double>(cit->second.width));
+                    _tables.writeString(bim_record + 32, cit->second.kind);
+                    _tables.writeString(bim_record + 40, cit->second.direction);
+                }
+                for (typename house_type::room_map::const_iterator cit = _house.rooms.cbegin(); cit != _house.rooms.cend(); ++cit)
+                {
+                    char* bim_record = _tables.append(binary_format::section_rooms);
+                    binary_format::writeU64(bim_record, toU64(cit->first));
+                    _tables.writeString(bim_record + 8, cit->second.kind);
+                    binary_format::writeU64(bim_record + 16, _tables.count(binary_format::section_room_walls));
+                    binary_format::writeU64(bim_record + 24, cit->second.wall_ids.size());
+                    for (id_type bim_wall_id : cit->second.wall_ids)
+                    {
+                        binary_format::writeU64(_tables.append(binary_format::section_room_walls), toU64(bim_wall_id));
+                    }
+                }
+            }
+        };
+
+        /*!
+         * Read the bytes of `binary_format` in place, they can be mapped from a file by `mapped_file`.
+         * 
+         * The records are read from the bytes when they are queried, and the entities are found by binary search.
+         * The bytes must be kept until the view and all its sub-views are not used.
+         */
+        template<typename TConstant = constant<>>
+        class binary_view
+        {
+        public:
+            typedef typename TConstant::precision_type  precision_type;
+            typedef typename TConstant::point_type      point_type;
+            typedef typename TConstant::id_type         id_type;
+            typedef node<TConstant>                     node_type;
+            typedef wall<TConstant>                     wall_type;
+            typedef hole<TConstant>                     hole_type;
+            typedef room<TConstant>                     room_type;
+            typedef house<TConstant>                    house_type;
+            typedef building<TConstant>                 building_type;
+            typedef site<TConstant>                     site_type;
+            typedef project<TConstant>                  project_type;
+
+            /*!
+             * A house in the bytes, the entities are found by their indices or ids.
+             * The `findXXX` functions return the count of the entities if the id is not found.
+             */
+            class house_view
+            {
+            public:
+                house_view(const binary_view& _view, size_t _index)
+                    : view(&_view)
+                    , record(_view.record(binary_format::section_houses, _index))
+                {}
+
+            public:
+                inline id_type id() const
+                {
+                    return toId(binary_format::readU64(record));
+                }
+
+                inline std::string name() const
+                {
+                    return view->readString(record + 8);
+                }
+
+                inline size_t nodeCount() const
+                {
+                    return count(16);
+                }
+
+                inline id_type nodeId(size_t _index) const
+                {
+                    return toId(binary_format::readU64(nodeRecord(_index)));
+                }
+
+                inline node_type node(size_t _index) const
+                {
+                    const char* bim_record = nodeRecord(_index);
+                    return node_type(static_cast<precision_type>(binary_format::readF64(bim_record + 8))
+                        , static_cast<precision_type>(binary_format::readF64(bim_record + 16)));
+                }
+
+                inline size_t findNode(id_type _node_id) const
+                {
+                    return find(binary_format::section_nodes, 16, _node_id);
+                }
+
+                inline size_t wallCount() const
+                {
+                    return count(32);
+                }
+
+                inline id_type wallId(size_t _index) const
+                {
+                    return toId(binary_format::readU64(wallRecord(_index)));
+                }
+
+                wall_type wall(size_t _index) const
+                {
+                    const char* bim_record = wallRecord(_index);
+                    wall_type bim_wall(toId(binary_format::readU64(bim_record + 8))
+                        , toId(binary_format::readU64(bim_record + 16))
+                        , static_cast<precision_type>(binary_format::readF64(bim_record + 24)));
+                    bim_wall.kind = view->readString(bim_record + 32);
+                    return bim_wall;
+                }
+
+                inline size_t findWall(id_type _wall_id) const
+                {
+                    return find(binary_format::section_walls, 32, _wall_id);
+                }
+
+                inline size_t holeCount() const
+                {
+                    return count(48);
+                }
+
+                inline id_type holeId(size_t _index) const
+                {
+                    return toId(binary_format::readU64(holeRecord(_index)));
+                }
+
+                hole_type hole(size_t _index) const
+                {
+                    const char* bim_record = holeRecord(_index);
+                    hole_type bim_hole(toId(binary_format::readU64(bim_record + 8))
+                        , static_cast<precision_type>(binary_format::readF64(bim_record + 16))
+                        , static_cast<precision_type>(binary_format::readF64(bim_record + 24)));
+                    bim_hole.kind = view->readString(bim_record + 32);
+                    bim_hole.direction = view->readString(bim_record + 40);
+                    return bim_hole;
+                }
+
+                inline size_t findHole(id_type _hole_id) const
+                {
+                    return find(binary_format::section_holes, 48, _hole_id);
+                }
+
+                inline size_t roomCount() const
+                {
+                    return count(64);
+                }
+
+                inline id_type roomId(size_t _index) const
+                {
+                    return toId(binary_format::readU64(roomRecord(_index)));
+                }
+
+                inline size_t roomWallCount(size_t _index) const
+                {
+                    return static_cast<size_t>(binary_format::readU64(roomRecord(_index) + 24));
+                }
+
+                inline id_type roomWallId(size_t _index, size_t _wall_index) const
+                {
+                    const size_t bim_begin = static_cast<size_t>(binary_format::readU64(roomRecord(_index) + 16));
+                    return toId(binary_format::readU64(view->record(binary_format::section_room_walls, bim_begin + _wall_index)));
+                }
+
+                room_type room(size_t _index) const
+                {
+                    room_type bim_room;
+                    bim_room.kind = view->readString(roomRecord(_index) + 8);
+                    const size_t bim_walls_count = roomWallCount(_index);
+                    bim_room.wall_ids.reserve(bim_walls_count);
+                    for (size_t i = 0; i < bim_walls_count; ++i)
+                    {
+                        bim_room.wall_ids.push_back(roomWallId(_index, i));
+                    }
+                    return bim_room;
+                }
+
+                inline size_t findRoom(id_type _room_id) const
+                {
+                    return find(binary_format::section_rooms, 64, _room_id);
+                }
+
+                /*!
+                 * Convert it to a house.
+                 */
+                void toHouse(house_type& _house) const
+                {
+                    _house.reset();
+                    _house.name = name();
+                    for (size_t i = 0, ic = nodeCount(); i < ic; ++i)
+                    {
+                        _house.nodes.insert(std::make_pair(nodeId(i), node(i)));
+                    }
+                    for (size_t i = 0, ic = wallCount(); i < ic; ++i)
+                    {
+                        _house.walls.insert(std::make_pair(wallId(i), wall(i)));
+                    }
+                    for (size_t i = 0, ic = holeCount(); i < ic; ++i)
+                    {
+                        _house.holes.insert(std::make_pair(holeId(i), hole(i)));
+                    }
+                    for (size_t i = 0, ic = roomCount(); i < ic; ++i)
+                    {
+                        _house.rooms.insert(std::make_pair(roomId(i), room(i)));
+                    }
+                }
+
+            private:
+                inline size_t count(size_t _offset) const
+                {
+                    return static_cast<size_t>(binary_format::readU64(record + _offset + 8));
+                }
+
+                inline const char* entityRecord(binary_format::section _section, size_t _offset, size_t _index) const
+                {
+                    return view->record(_section, static_cast<size_t>(binary_format::readU64(record + _offset)) + _index);
+                }
+
+                inline const char* nodeRecord(size_t _index) const { return entityRecord(binary_format::section_nodes, 16, _index); }
+                inline const char* wallRecord(size_t _index) const { return entityRecord(binary_format::section_walls, 32, _index); }
+                inline const char* holeRecord(size_t _index) const { return entityRecord(binary_format::section_holes, 48, _index); }
+                inline const char* roomRecord(size_t _index) const { return entityRecord(binary_format::section_rooms, 64, _index); }
+
+                size_t find(binary_format::section _section, size_t _offset, id_type _id) const
+                {
+                    const std::uint64_t bim_id = toU64(_id);
+                    size_t bim_low = 0;
+                    size_t bim_high = count(_offset);
+                    while (bim_low < bim_high)
+                    {
+                        const size_t bim_middle = bim_low + (bim_high - bim_low) / 2;
+                        if (binary_format::readU64(entityRecord(_section, _offset, bim_middle)) < bim_id)
+                        {
+                            bim_low = bim_middle + 1;
+                        }
+                        else
+                        {
+                            bim_high = bim_middle;
+                        }
+                    }
+                    if (bim_low < count(_offset) && binary_format::readU64(entityRecord(_section, _offset, bim_low)) == bim_id)
+                    {
+                        return bim_low;
+                    }
+                    return count(_offset);
+                }
+
+            private:
+                const binary_view*  view;
+                const char*         record;
+            };
+
+            class building_view
+            {
+            public:
+                building_view(const binary_view& _view, size_t _index)
+                    : view(&_view)
+                    , record(_view.record(binary_format::section_buildings, _index))
+                {}
+
+            public:
+                inline id_type id() const
+                {
+                    return toId(binary_format::readU64(record));
+                }
+
+                inline size_t houseCount() const
+                {
+                    return static_cast<size_t>(binary_format::readU64(record + 16));
+                }
+
+                inline house_view houseView(size_t _index) const
+                {
+                    return house_view(*view, static_cast<size_t>(binary_format::readU64(record + 8)) + _index);
+                }
+
+                inline size_t positionCount() const
+                {
+                    return static_cast<size_t>(binary_format::readU64(record + 32));
+                }
+
+                /*!
+                 * Get a position and the id of its house.
+                 */
+                inline std::pair<point_type, id_type> position(size_t _index) const
+                {
+                    const char* bim_record = view->record(binary_format::section_positions, static_cast<size_t>(binary_format::readU64(record + 24)) + _index);
+                    return std::make_pair(point_type(static_cast<precision_type>(binary_format::readF64(bim_record))
+                        , static_cast<precision_type>(binary_format::readF64(bim_record + 8)))
+                        , toId(binary_format::readU64(bim_record + 16)));
+                }
+
+                void toBuilding(building_type& _building) const
+                {
+                    _building.houses.clear();
+                    _building.positions.clear();
+                    for (size_t i = 0, ic = houseCount(); i < ic; ++i)
+                    {
+                        const house_view bim_house = houseView(i);
+                        house_type& bim_new_house = _building.houses[bim_house.id()];
+                        bim_house.toHouse(bim_new_house);
+                    }
+                    for (size_t i = 0, ic = positionCount(); i < ic; ++i)
+                    {
+                        _building.positions.insert(position(i));
+                    }
+                }
+
+            private:
+                const binary_view*  view;
+                const char*         record;
+            };
+
+            class site_view
+            {
+            public:
+                site_view(const binary_view& _view, size_t _index)
+                    : view(&_view)
+                    , record(_view.record(binary_format::section_sites, _index))
+                {}
+
+            public:
+                inline id_type id() const
+                {
+                    return toId(binary_format::readU64(record));
+                }
+
+                inline std::string name() const
+                {
+                    return view->readString(record + 8);
+                }
+
+                inline size_t buildingCount() const
+                {
+                    return static_cast<size_t>(binary_format::readU64(record + 24));
+                }
+
+                inline building_view buildingView(size_t _index) const
+                {
+                    return building_view(*view, static_cast<size_t>(binary_format::readU64(record + 16)) + _index);
+                }
+
+                void toSite(site_type& _site) const
+                {
+                    _site.name = name();
+                    _site.buildings.clear();
+                    for (size_t i = 0, ic = buildingCount(); i < ic; ++i)
+                    {
+                        const building_view bim_building = buildingView(i);
+                        bim_building.toBuilding(_site.buildings[bim_building.id()]);
+                    }
+                }
+
+            private:
+                const binary_view*  view;
+                const char*         record;
+            };
+
+        public:
+            binary_view()
+                : bytes(nullptr)
+                , bytes_size(0)
+                , content(binary_format::content_house)
+                , section_offsets()
+                , section_counts()
+            {}
+
+        public:
+            /*!
+             * Check the header and all ranges of the bytes, and read the sections.
+             * 
+             * @param _bytes The bytes of the file
+             * @param _size The count of bytes
+             * @return Whether the bytes are valid
+             */
+            bool open(const char* _bytes, size_t _size)
+            {
+                bytes = nullptr;
+                bytes_size = 0;
+                if (_bytes == nullptr || _size < binary_format::header_size
+                    || std::memcmp(_bytes, binary_format::magic(), 8) != 0
+                    || binary_format::readU32(_bytes + 8) != binary_format::version
+                    || binary_format::readU32(_bytes + 24) < binary_format::section_count)
+                {
+                    return false;
+                }
+                const std::uint32_t bim_content = binary_format::readU32(_bytes + 12);
+                if (bim_content != binary_format::content_house && bim_content != binary_format::content_project)
+                {
+                    return false;
+                }
+                content = static_cast<binary_format::content>(bim_content);
+                for (size_t i = 0; i < binary_format::section_count; ++i)
+                {
+                    const std::uint64_t bim_offset = binary_format::readU64(_bytes + 32 + i * 16);
+                    const std::uint64_t bim_count = binary_format::readU64(_bytes + 32 + i * 16 + 8);
+                    const size_t bim_record_size = binary_format::recordSize(static_cast<binary_format::section>(i));
+                    if (bim_offset % 8 != 0 || bim_offset > _size || bim_count > (_size - bim_offset) / bim_record_size)
+                    {
+                        return false;
+                    }
+                    section_offsets[i] = static_cast<size_t>(bim_offset);
+                    section_counts[i] = static_cast<size_t>(bim_count);
+                }
+                bytes = _bytes;
+                bytes_size = _size;
+                if (!isValid())
+                {
+                    bytes = nullptr;
+                    bytes_size = 0;
+                    return false;
+                }
+                return true;
+            }
+
+            inline bool isOpen() const
+            {
+                return (bytes != nullptr);
+            }
+
+            /*!
+             * Whether the bytes are a house or a project, see `binary_format::content`.
+             */
+            inline binary_format::content contentType() const
+            {
+                return content;
+            }
+
+            /// The name of the project
+            inline std::string name() const
+            {
+                return readString(bytes + 16);
+            }
+
+            inline size_t siteCount() const
+            {
+                return section_counts[binary_format::section_sites];
+            }
+
+            inline site_view siteView(size_t _index) const
+            {
+                return site_view(*this, _index);
+            }
+
+            /// The count of the houses of all buildings
+            inline size_t houseCount() const
+            {
+                return section_counts[binary_format::section_houses];
+            }
+
+            inline house_view houseView(size_t _index) const
+            {
+                return house_view(*this, _index);
+            }
+
+            /*!
+             * Convert the first house to a house.
+             */
+            bool toHouse(house_type& _house) const
+            {
+                if (houseCount() == 0)
+                {
+                    return false;
+                }
+                houseView(0).toHouse(_house);
+                return true;
+            }
+
+            /*!
+             * Convert all sites to a project.
+             */
+            void toProject(project_type& _project) const
+            {
+                _project.name = name();
+                _project.sites.clear();
+                for (size_t i = 0, ic = siteCount(); i < ic; ++i)
+                {
+                    const site_view bim_site = siteView(i);
+                    bim_site.toSite(_project.sites[bim_site.id()]);
+                }
+            }
+
+        private:
+            /// the ids are stored as uint64, an id which doesn't fit `id_type` is `none_id`
+            static inline id_type toId(std::uint64_t _v)
+            {
+                return (_v >= static_cast<std::uint64_t>(TConstant::none_id)) ? TConstant::none_id : static_cast<id_type>(_v);
+            }
+
+            static inline std::uint64_t toU64(id_type _id)
+            {
+                return TConstant::isValid(_id) ? static_cast<std::uint64_t>(_id) : ~static_cast<std::uint64_t>(0);
+            }
+
+            inline const char* record(binary_format::section _section, size_t _index) const
+            {
+                assert(_index < section_counts[_section]);
+                return bytes + section_offsets[_section] + _index * binary_format::recordSize(_section);
+            }
+
+            inline std::string readString(const char* _p) const
+            {
+                return std::string(bytes + section_offsets[binary_format::section_strings] + binary_format::readU32(_p)
+                    , binary_format::readU32(_p + 4));
+            }
+
+            inline bool isValidString(const char* _p) const
+            {
+                const std::uint64_t bim_end = static_cast<std::uint64_t>(binary_format::readU32(_p)) + binary_format::readU32(_p + 4);
+                return (bim_end <= section_counts[binary_format::section_strings]);
+            }
+
+            inline bool isValidRange(const char* _p, binary_format::section _section) const
+            {
+                const std::uint64_t bim_begin = binary_format::readU64(_p);
+                const std::uint64_t bim_count = binary_format::readU64(_p + 8);
+                return (bim_begin <= section_counts[_section] && bim_count <= section_counts[_section] - bim_begin);
+            }
+
+            /// check all ranges and strings, and the entities of every house must be sorted by their ids
+            bool isValid() const
+            {
+                if (!isValidString(bytes + 16)) return false;
+                for (size_t i = 0, ic = siteCount(); i < ic; ++i)
+                {
+                    const char* bim_record = record(binary_format::section_sites, i);
+                    if (!isValidString(bim_record + 8) || !isValidRange(bim_record + 16, binary_format::section_buildings)) return false;
+                }
+                for (size_t i = 0, ic = section_counts[binary_format::section_buildings]; i < ic; ++i)
+                {
+                    const char* bim_record = record(binary_format::section_buildings, i);
+                    if (!isValidRange(bim_record + 8, binary_format::section_houses)
+                        || !isValidRange(bim_record + 24, binary_format::section_positions)) return false;
+                }
+                const binary_format::section bim_entity_sections[] = { binary_format::section_nodes, binary_format::section_walls
+                    , binary_format::section_holes, binary_format::section_rooms };
+                for (size_t i = 0, ic = houseCount(); i < ic; ++i)
+                {
+                    const char* bim_record = record(binary_format::section_houses, i);
+                    if (!isValidString(bim_record + 8)) return false;
+                    for (size_t s = 0; s < 4; ++s)
+                    {
+                        const char* bim_range = bim_record + 16 + s * 16;
+                        if (!isValidRange(bim_range, bim_entity_sections[s])) return false;
+                        const size_t bim_begin = static_cast<size_t>(binary_format::readU64(bim_range));
+                        for (size_t j = 1, jc = static_cast<size_t>(binary_format::readU64(bim_range + 8)); j < jc; ++j)
+                        {
+                            if (binary_format::readU64(record(bim_entity_sections[s], bim_begin + j - 1))
+                                >= binary_format::readU64(record(bim_entity_sections[s], bim_begin + j))) return false;
+                        }
+                    }
+                }
+                for (size_t i = 0, ic = section_counts[binary_format::section_walls]; i < ic; ++i)
+                {
+                    if (!isValidString(record(binary_format::section_walls, i) + 32)) return false;
+                }
+                for (size_t i = 0, ic = section_counts[binary_format::section_holes]; i < ic; ++i)
+                {
+                    const char* bim_record = record(binary_format::section_holes, i);
+                    if (!isValidString(bim_record + 32) || !isValidString(bim_record + 40)) return false;
+                }
+                for (size_t i = 0, ic = section_counts[binary_format::section_rooms]; i < ic; ++i)
+                {
+                    const char* bim_record = record(binary_format::section_rooms, i);
+                    if (!isValidString(bim_record + 8) || !isValidRange(bim_record + 16, binary_format::section_room_walls)) return false;
+                }
+                return true;
+            }
+
+        private:
+            const char*                                         bytes;
+            size_t                                              bytes_size;
+            binary_format::content                              content;
+            std::array<size_t, binary_format::section_count>    section_offsets;
+            std::array<size_t, binary_format::section_count>    section_counts;
+        };
+
+        /*!
+         * A read-only file which is mapped into the memory by `mmap` on POSIX, or read into the memory on the other systems.
+         */
+        class mapped_file
+        {
+        public:
+            mapped_file()
+                : bytes(nullptr)
+                , bytes_size(0)
+                , buffer()
+            {}
+
+            ~mapped_file()
+            {
+                close();
+            }
+
+        private:
+            mapped_file(const mapped_file&);
+            mapped_file& operator=(const mapped_file&);
+
+        public:
+            bool open(const std::string& _path)
+            {
+                close();
+#if defined(BIMPP_PLAN2D_MMAP)
+                const int bim_file = ::open(_path.c_str(), O_RDONLY);
+                if (bim_file < 0)
+                {
+                    return false;
+                }
+                struct stat bim_stat;
+                if (::fstat(bim_file, &bim_stat) != 0 || bim_stat.st_size <= 0)
+                {
+                    ::close(bim_file);
+                    return false;
+                }
+                void* bim_bytes = ::mmap(nullptr, static_cast<size_t>(bim_stat.st_size), PROT_READ, MAP_PRIVATE, bim_file, 0);
+                ::close(bim_file);
+                if (bim_bytes == MAP_FAILED)
+                {
+                    return false;
+                }
+                bytes = static_cast<const char*>(bim_bytes);
+                bytes_size = static_cast<size_t>(bim_stat.st_size);
+#else
+                std::ifstream bim_file(_path.c_str(), std::ios::binary);
+                if (!bim_file)
+                {
+                    return false;
+                }
+                buffer.assign(std::istreambuf_iterator<char>(bim_file), std::istreambuf_iterator<char>());
+                if (buffer.empty())
+                {
+                    return false;
+                }
+                bytes = &buffer[0];
+                bytes_size = buffer.size();
+#endif
+                return true;
+            }
+
+            void close()
+            {
+#if defined(BIMPP_PLAN2D_MMAP)
+                if (bytes != nullptr)
+                {
+                    ::munmap(const_cast<char*>(bytes), bytes_size);
+                }
+#endif
+                bytes = nullptr;
+                bytes_size = 0;
+                buffer.clear();
+            }
+
+            inline const char* data() const
+            {
+                return bytes;
+            }
+
+            inline size_t size() const
+            {
+                return bytes_size;
+            }
+
+        private:
+            const char*         bytes;
+            size_t              bytes_size;
+            std::vector<char>   buffer;     ///< The bytes if the file can't be mapped
+        };
+
+        /*!
+         * Read a house or a project from a JSON stream in one pass, without building a DOM.
+         * 
+         * The entities are inserted as soon as their objects are read, so the memory is close to the size of the result.
+         * A house is an object like
+         * 
+         *     {"name": "", "nodes": [{"id": 0, "x": 0, "y": 0}],
+         *      "walls": [{"id": 0, "start_node_id": 0, "end_node_id": 1, "thickness": 0, "kind": ""}],
+         *      "holes": [{"id": 0, "wall_id": 0, "distance": 0, "width": 0, "kind": "", "direction": ""}],
+         *      "rooms": [{"id": 0, "kind": "", "wall_ids": [0]}]}
+         * 
+         * and a project is an object like
+         * 
+         *     {"name": "", "sites": [{"id": 0, "name": "", "buildings": [{"id": 0,
+         *      "houses": [{"id": 0, ...the fields of a house...}], "positions": [{"x": 0, "y": 0, "house_id": 0}]}]}]}
+         * 
+         * The keys can be in any order, the unknown keys are skipped, and a `null` id is `TConstant::none_id`.
+         * The numbers must follow the JSON grammar, so `+1`, `.5`, `1.` and `01` fail with "invalid number!",
+         * and they are parsed in the classic locale whatever the global one is.
+         * The kinds are interned into `symbol_table`, so reading fails with "too many kinds!" if it is full, see `symbol_table::setMaxSize`.
+         */
+        template<typename TConstant = constant<>>
+        class json_reader
+        {
+        public:
+            typedef typename TConstant::precision_type  precision_type;
+            typedef typename TConstant::point_type      point_type;
+            typedef typename TConstant::id_type         id_type;
+            typedef typename TConstant::kind_type       kind_type;
+            typedef node<TConstant>                     node_type;
+            typedef wall<TConstant>                     wall_type;
+            typedef hole<TConstant>                     hole_type;
+            typedef room<TConstant>                     room_type;
+            typedef house<TConstant>                    house_type;
+            typedef building<TConstant>                 building_type;
+            typedef site<TConstant>                     site_type;
+            typedef project<TConstant>                  project_type;
+
+        public:
+            /*!
+             * @param _buffer_size The count of bytes which are read from the stream at once
+             */
+            explicit json_reader(size_t _buffer_size = 64 * 1024)
+                : input(nullptr)
+                , buffer(std::max<size_t>(_buffer_size, 1))
+                , position(0)
+                , buffer_end(0)
+                , buffer_offset(0)
+                , error_offset(0)
+                , error_message("")
+                , key()
+                , text()
+                , number_input()
+            {
+                number_input.imbue(std::locale::classic());
+            }
+
+        public:
+            /*!
+             * Read a house, it may be partly filled if it fails.
+             * 
+             * @param _input The JSON stream
+             * @param _house Output the house
+             * @return Whether it succeeds, see `errorOffset` and `errorMessage` if it fails
+             */
+            bool read(std::istream& _input, house_type& _house)
+            {
+                _house.reset();
+                return readRoot(_input, [this, &_house]() { readHouse(_house, nullptr); });
+            }
+
+            /*!
+             * Read a project, it may be partly filled if it fails.
+             * 
+             * @param _input The JSON stream
+             * @param _project Output the project
+             * @return Whether it succeeds, see `errorOffset` and `errorMessage` if it fails
+             */
+            bool read(std::istream& _input, project_type& _project)
+            {
+                _project.name = "";
+                _project.sites.clear();
+                return readRoot(_input, [this, &_project]() { readProject(_project); });
+            }
+
+            /// The offset in bytes from the start of the stream where the last error is found
+            inline size_t errorOffset() const
+            {
+                return error_offset;
+            }
+
+            inline const std::string& errorMessage() const
+            {
+                return error_message;
+            }
+
+        private:
+            class parse_error
+            {
+            };
+
+            static const size_t max_depth = 256;
+
+            template<typename TRead>
+            bool readRoot(std::istream& _input, const TRead& _read)
+            {
+                input = &_input;
+                position = 0;
+                buffer_end = 0;
+                buffer_offset = 0;
+                error_offset = 0;
+                error_message = "";
+                bool bim_result = true;
+                try
+                {
+                    skipSpaces();
+                    _read();
+                    skipSpaces();
+                    if (peek() != EOF)
+                    {
+                        fail("unexpected data after the document!");
+                    }
+                }
+                catch (const parse_error&)
+                {
+                    bim_result = false;
+                }
+                input = nullptr;
+                return bim_result;
+            }
+
+            void readProject(project_type& _project)
+            {
+                readObject([this, &_project]()
+                {
+                    if (key == "name") readString(_project.name);
+                    else if (key == "sites") readArray([this, &_project]()
+                    {
+                        const size_t bim_offset = offset();
+                        id_type bim_site_id = TConstant::none_id;
+                        site_type bim_site;
+                        readObject([this, &bim_site, &bim_site_id]()
+                        {
+                            if (key == "id") bim_site_id = readId();
+                            else if (key == "name") readString(bim_site.name);
+                            else if (key == "buildings") readArray([this, &bim_site]() { readBuilding(bim_site); });
+                            else skipValue(0);
+                        });
+                        insertEntity(_project.sites, bim_site_id, bim_site, bim_offset, "site");
+                    });
+                    else skipValue(0);
+                });
+            }
+
+            void readBuilding(site_type& _site)
+            {
+                const size_t bim_offset = offset();
+                id_type bim_building_id = TConstant::none_id;
+                building_type bim_building;
+                readObject([this, &bim_building, &bim_building_id]()
+                {
+                    if (key == "id") bim_building_id = readId();
+                    else if (key == "houses") readArray([this, &bim_building]()
+                    {
+                        const size_t bim_house_offset = offset();
+                        id_type bim_house_id = TConstant::none_id;
+                        house_type bim_house;
+                        readHouse(bim_house, &bim_house_id);
+                        insertEntity(bim_building.houses, bim_house_id, bim_house, bim_house_offset, "house");
+                    });
+                    else if (key == "positions") readArray([this, &bim_building]()
+                    {
+                        const size_t bim_position_offset = offset();
+                        precision_type bim_x = 0;
+                        precision_type bim_y = 0;
+                        id_type bim_house_id = TConstant::none_id;
+                        readObject([this, &bim_x, &bim_y, &bim_house_id]()
+                        {
+                            if (key == "x") bim_x = readNumber();
+                            else if (key == "y") bim_y = readNumber();
+                            else if (key == "house_id") bim_house_id = readId();
+                            else skipValue(0);
+                        });
+                        if (!bim_building.positions.insert(std::make_pair(point_type(bim_x, bim_y), bim_house_id)).second)
+                        {
+                            failAt(bim_position_offset, "duplicated position!");
+                        }
+                    });
+                    else skipValue(0);
+                });
+                insertEntity(_site.buildings, bim_building_id, bim_building, bim_offset, "building");
+            }
+
+            /// read the fields of a house, and its id if `_house_id` is not null
+            void readHouse(house_type& _house, id_type* _house_id)
+            {
+                readObject([this, &_house, _house_id]()
+                {
+                    if (key == "id" && _house_id != nullptr) *_house_id = readId();
+                    else if (key == "name") readString(_house.name);
+                    else if (key == "nodes") readArray([this, &_house]()
+                    {
+                        const size_t bim_offset = offset();
+                        id_type bim_id = TConstant::none_id;
+                        precision_type bim_x = 0;
+                        precision_type bim_y = 0;
+                        readObject([this, &bim_id, &bim_x, &bim_y]()
+                        {
+                            if (key == "id") bim_id = readId();
+                            else if (key == "x") bim_x = readNumber();
+                            else if (key == "y") bim_y = readNumber();
+                            else skipValue(0);
+                        });
+                        node_type bim_node(bim_x, bim_y);
+                        insertEntity(_house.nodes, bim_id, bim_node, bim_offset, "node");
+                    });
+                    else if (key == "walls") readArray([this, &_house]()
+                    {
+                        const size_t bim_offset = offset();
+                        id_type bim_id = TConstant::none_id;
+                        wall_type bim_wall;
+                        readObject([this, &bim_id, &bim_wall]()
+                        {
+                            if (key == "id") bim_id = readId();
+                            else if (key == "start_node_id") bim_wall.start_node_id = readId();
+                            else if (key == "end_node_id") bim_wall.end_node_id = readId();
+                            else if (key == "thickness") bim_wall.thickness = readNumber();
+                            else if (key == "kind") readKind(bim_wall.kind);
+                            else skipValue(0);
+                        });
+                        insertEntity(_house.walls, bim_id, bim_wall, bim_offset, "wall");
+                    });
+                    else if (key == "holes") readArray([this, &_house]()
+                    {
+                        const size_t bim_offset = offset();
+                        id_type bim_id = TConstant::none_id;
+                        hole_type bim_hole;
+                        readObject([this, &bim_id, &bim_hole]()
+                        {
+                            if (key == "id") bim_id = readId();
+                            else if (key == "wall_id") bim_hole.wall_id = readId();
+                            else if (key == "distance") bim_hole.distance = readNumber();
+                            else if (key == "width") bim_hole.width = readNumber();
+                            else if (key == "kind") readKind(bim_hole.kind);
+                            else if (key == "direction") readKind(bim_hole.direction);
+                            else skipValue(0);
+                        });
+                        insertEntity(_house.holes, bim_id, bim_hole, bim_offset, "hole");
+                    });
+                    else if (key == "rooms") readArray([this, &_house]()
+                    {
+                        const size_t bim_offset = offset();
+                        id_type bim_id = TConstant::none_id;
+                        room_type bim_room;
+                        readObject([this, &bim_id, &bim_room]()
+                        {
+                            if (key == "id") bim_id = readId();
+                            else if (key == "kind") readKind(bim_room.kind);
+                            else if (key == "wall_ids") readArray([this, &bim_room]() { bim_room.wall_ids.push_back(readId()); });
+                            else skipValue(0);
+                        });
+                        insertEntity(_house.rooms, bim_id, bim_room, bim_offset, "room");
+                    });
+                    else skipValue(0);
+                });
+            }
+
+            template<typename TMap, typename TEntity>
+            void insertEntity(TMap& _map, id_type _id, TEntity& _entity, size_t _offset, const char* _name)
+            {
+                if (!TConstant::isValid(_id))
+                {
+                    failAt(_offset, std::string("the ") + _name + " has no id!");
+                }
+                if (_map.find(_id) != _map.end())
+                {
+                    failAt(_offset, std::string("duplicated ") + _name + " id!");
+                }
+                _map.insert(std::make_pair(_id, std::move(_entity)));
+            }
+
+            /// read an object, `_read_value` reads the value of `key`
+            template<typename TReadValue>
+            void readObject(const TReadValue& _read_value)
+            {
+                expect('{');
+                skipSpaces();
+                if (peek() == '}')
+                {
+                    next();
+                    return;
+                }
+                while (true)
+                {
+                    skipSpaces();
+                    readString(key);
+                    skipSpaces();
+                    expect(':');
+                    skipSpaces();
+                    _read_value();
+                    skipSpaces();
+                    const int c = next();
+                    if (c == '}') return;
+                    if (c != ',') fail("expect ',' or '}'!", 1);
+                }
+            }
+
+            template<typename TReadItem>
+            void readArray(const TReadItem& _read_item)
+            {
+                expect('[');
+                skipSpaces();
+                if (peek() == ']')
+                {
+                    next();
+                    return;
+                }
+                while (true)
+                {
+                    skipSpaces();
+                    _read_item();
+                    skipSpaces();
+                    const int c = next();
+                    if (c == ']') return;
+                    if (c != ',') fail("expect ',' or ']'!", 1);
+                }
+            }
+
+            void skipValue(size_t _depth)
+            {
+                if (_depth > max_depth)
+                {
+                    fail("too deep!");
+                }
+                const int c = peek();
+                if (c == '{')
+                {
+                    readObject([this, _depth]() { skipValue(_depth + 1); });
+                }
+                else if (c == '[')
+                {
+                    readArray([this, _depth]() { skipValue(_depth + 1); });
+                }
+                else if (c == '"')
+                {
+                    readString(text);
+                }
+                else if (c == 't')
+                {
+                    expectWord("true");
+                }
+                else if (c == 'f')
+                {
+                    expectWord("false");
+                }
+                else if (c == 'n')
+                {
+                    expectWord("null");
+                }
+                else
+                {
+                    readNumber();
+                }
+            }
+
+            id_type readId()
+            {
+                if (peek() == 'n')
+                {
+                    expectWord("null");
+                    return TConstant::none_id;
+                }
+                const size_t bim_offset = offset();
+                std::uint64_t bim_id = 0;
+                size_t bim_digits_count = 0;
+                while (peek() >= '0' && peek() <= '9')
+                {
+                    const std::uint64_t bim_digit = static_cast<std::uint64_t>(next() - '0');
+                    if (bim_id > (std::numeric_limits<id_type>::max() - bim_digit) / 10)
+                    {
+                        failAt(bim_offset, "the id is too big!");
+                    }
+                    bim_id = bim_id * 10 + bim_digit;
+                    ++bim_digits_count;
+                }
+                if (bim_digits_count == 0)
+                {
+                    failAt(bim_offset, "expect an id!");
+                }
+                if (!TConstant::isValid(static_cast<id_type>(bim_id)))
+                {
+                    failAt(bim_offset, "the id is too big!");
+                }
+                return static_cast<id_type>(bim_id);
+            }
+
+            /// a mantissa of so many digits is exact in a `double`
+            static const size_t fast_digits_count = 15;
+
+            /// read a number by `-?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?`
+            precision_type readNumber()
+            {
+                const size_t bim_offset = offset();
+                text.clear();
+                if (peek() == '-')
+                {
+                    text.push_back(static_cast<char>(next()));
+                }
+                std::uint64_t bim_mantissa = 0;
+                size_t bim_digits_count = 0;
+                if (peek() == '0')
+                {
+                    text.push_back(static_cast<char>(next()));
+                }
+                else if (readDigits(bim_mantissa, bim_digits_count) == 0)
+                {
+                    failAt(bim_offset, (text.empty() && !isNumberChar(peek())) ? "expect a value!" : "invalid number!");
+                }
+                int bim_power = 0;
+                if (peek() == '.')
+                {
+                    text.push_back(static_cast<char>(next()));
+                    const size_t bim_fraction_count = readDigits(bim_mantissa, bim_digits_count);
+                    if (bim_fraction_count == 0)
+                    {
+                        failAt(bim_offset, "invalid number!");
+                    }
+                    bim_power -= static_cast<int>(std::min<size_t>(bim_fraction_count, 1000));
+                }
+                if (peek() == 'e' || peek() == 'E')
+                {
+                    text.push_back(static_cast<char>(next()));
+                    const bool bim_negative = (peek() == '-');
+                    if (peek() == '+' || peek() == '-')
+                    {
+                        text.push_back(static_cast<char>(next()));
+                    }
+                    std::uint64_t bim_exponent = 0;
+                    size_t bim_exponent_count = 0;
+                    if (readDigits(bim_exponent, bim_exponent_count) == 0)
+                    {
+                        failAt(bim_offset, "invalid number!");
+                    }
+                    bim_exponent = (bim_exponent_count > fast_digits_count) ? 1000 : std::min<std::uint64_t>(bim_exponent, 1000);
+                    bim_power += bim_negative ? -static_cast<int>(bim_exponent) : static_cast<int>(bim_exponent);
+                }
+                if (isNumberChar(peek()))
+                {
+                    failAt(bim_offset, "invalid number!");
+                }
+
+                /// the mantissa and the power of 10 are both exact, so one multiplication or division rounds correctly
+                static const double powers_of_10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10
+                    , 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+                double bim_value = 0;
+                if (bim_digits_count <= fast_digits_count && bim_power >= -22 && bim_power <= 22)
+                {
+                    bim_value = static_cast<double>(bim_mantissa);
+                    bim_value = (bim_power < 0) ? bim_value / powers_of_10[-bim_power] : bim_value * powers_of_10[bim_power];
+                    if (text[0] == '-') bim_value = -bim_value;
+                }
+                else
+                {
+                    number_input.clear();
+                    number_input.str(text);
+                    number_input >> bim_value;
+                    if (number_input.fail())
+                    {
+                        failAt(bim_offset, "the number is out of range!");
+                    }
+                }
+                return static_cast<precision_type>(bim_value);
+            }
+
+            /// append the digits to the buffer, and add them to the mantissa while it has no more than `fast_digits_count` digits
+            size_t readDigits(std::uint64_t& _mantissa, size_t& _digits_count)
+            {
+                size_t bim_count = 0;
+                while (peek() >= '0' && peek() <= '9')
+                {
+                    const int c = next();
+                    text.push_back(static_cast<char>(c));
+                    ++bim_count;
+                    if (_digits_count == 0 && c == '0') continue;
+                    if (++_digits_count <= fast_digits_count)
+                    {
+                        _mantissa = _mantissa * 10 + static_cast<std::uint64_t>(c - '0');
+                    }
+                }
+                return bim_count;
+            }
+
+            static inline bool isNumberChar(int c)
+            {
+                return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+            }
+
+            /// read a string into the buffer, and convert it to a kind, it fails if `symbol_table` is full
+            void readKind(kind_type& _kind)
+            {
+                const size_t bim_offset = offset();
+                readString(text);
+                try
+                {
+                    _kind = kind_type(text);
+                }
+                catch (const std::length_error&)
+                {
+                    failAt(bim_offset, "too many kinds!");
+                }
+            }
+
+            void readString(std::string& _string)
+            {
+                _string.clear();
+                expect('"');
+                while (true)
+                {
+                    int c = next();
+                    if (c == '"') return;
+                    if (c == EOF) fail("unterminated string!");
+                    if (static_cast<unsigned char>(c) < 0x20) fail("invalid character in string!", 1);
+                    if (c != '\\')
+                    {
+                        _string.push_back(static_cast<char>(c));
+                        continue;
+                    }
+                    c = next();
+                    switch (c)
+                    {
+                    case '"': _string.push_back('"'); break;
+                    case '\\': _string.push_back('\\'); break;
+                    case '/': _string.push_back('/'); break;
+                    case 'b': _string.push_back('\b'); break;
+                    case 'f': _string.push_back('\f'); break;
+                    case 'n': _string.push_back('\n'); break;
+                    case 'r': _string.push_back('\r'); break;
+                    case 't': _string.push_back('\t'); break;
+                    case 'u':
+                    {
+                        std::uint32_t bim_code = readHex4();
+                        if (bim_code >= 0xD800 && bim_code < 0xDC00)
+                        {
+                            /// a surrogate pair
+                            expect('\\');
+                            expect('u');
+                            const std::uint32_t bim_low = readHex4();
+                            if (bim_low < 0xDC00 || bim_low >= 0xE000) fail("invalid surrogate pair!", 6);
+                            bim_code = 0x10000 + ((bim_code - 0xD800) << 10) + (bim_low - 0xDC00);
+                        }
+                        else if (bim_code >= 0xDC00 && bim_code < 0xE000)
+                        {
+                            fail("invalid surrogate pair!", 6);
+                        }
+                        appendUtf8(_string, bim_code);
+                        break;
+                    }
+                    default:
+                        fail("invalid escape!", 1);
+                    }
+                }
+            }
+
+            std::uint32_t readHex4()
+            {
+                std::uint32_t bim_code = 0;
+                for (size_t i = 0; i < 4; ++i)
+                {
+                    const int c = next();
+                    bim_code <<= 4;
+                    if (c >= '0' && c <= '9') bim_code |= static_cast<std::uint32_t>(c - '0');
+                    else if (c >= 'a' && c <= 'f') bim_code |= static_cast<std::uint32_t>(c - 'a' + 10);
+                    else if (c >= 'A' && c <= 'F') bim_code |= static_cast<std::uint32_t>(c - 'A' + 10);
+                    else fail("invalid hex digit!", (c == EOF) ? 0 : 1);
+                }
+                return bim_code;
+            }
+
+            static void appendUtf8(std::string& _string, std::uint32_t _code)
+            {
+                if (_code < 0x80)
+                {
+                    _string.push_back(static_cast<char>(_code));
+                }
+                else if (_code < 0x800)
+                {
+                    _string.push_back(static_cast<char>(0xC0 | (_code >> 6)));
+                    _string.push_back(static_cast<char>(0x80 | (_code & 0x3F)));
+                }
+                else if (_code < 0x10000)
+                {
+                    _string.push_back(static_cast<char>(0xE0 | (_code >> 12)));
+                    _string.push_back(static_cast<char>(0x80 | ((_code >> 6) & 0x3F)));
+                    _string.push_back(static_cast<char>(0x80 | (_code & 0x3F)));
+                }
+                else
+                {
+                    _string.push_back(static_cast<char>(0xF0 | (_code >> 18)));
+                    _string.push_back(static_cast<char>(0x80 | ((_code >> 12) & 0x3F)));
+                    _string.push_back(static_cast<char>(0x80 | ((_code >> 6) & 0x3F)));
+                    _string.push_back(static_cast<char>(0x80 | (_code & 0x3F)));
+                }
+            }
+
+            void expectWord(const char* _word)
+            {
+                const size_t bim_offset = offset();
+                for (const char* p = _word; *p != '\0'; ++p)
+                {
+                    if (next() != *p) failAt(bim_offset, std::string("expect '") + _word + "'!");
+                }
+            }
+
+            void expect(char _c)
+            {
+                if (peek() != _c)
+                {
+                    fail(std::string("expect '") + _c + "'!");
+                }
+                next();
+            }
+
+            void skipSpaces()
+            {
+                while (true)
+                {
+                    const int c = peek();
+                    if (c != ' ' && c != '\t' && c != '\n' && c != '\r') return;
+                    next();
+                }
+            }
+
+            inline int peek()
+            {
+                if (position == buffer_end)
+                {
+                    buffer_offset += buffer_end;
+                    position = 0;
+                    buffer_end = 0;
+                    if (input->good())
+                    {
+                        input->read(&buffer[0], static_cast<std::streamsize>(buffer.size()));
+                        buffer_end = static_cast<size_t>(input->gcount());
+                    }
+                    if (buffer_end == 0) return EOF;
+                }
+                return static_cast<unsigned char>(buffer[position]);
+            }
+
+            inline int next()
+            {
+                const int c = peek();
+                if (c != EOF) ++position;
+                return c;
+            }
+
+            /// the offset of the next byte
+            inline size_t offset() const
+            {
+                return buffer_offset + position;
+            }
+
+            /// fail at the next byte, or at some bytes before it
+            void fail(const std::string& _message, size_t _back = 0)
+            {
+                failAt(offset() - std::min(_back, offset()), _message);
+            }
+
+            void failAt(size_t _offset, const std::string& _message)
+            {
+                error_offset = _offset;
+                error_message = _message;
+                throw parse_error();
+            }
+
+        private:
+            std::istream*       input;
+            std::vector<char>   buffer;
+            size_t              position;
+            size_t              buffer_end;
+            size_t              buffer_offset;  ///< The offset of the first byte of the buffer
+            size_t              error_offset;
+            std::string         error_message;
+            std::string         key;            ///< The key which is just read
+            std::string         text;
+            std::istringstream  number_input;   ///< Parse the numbers in the classic locale
+        };
+
+        /*!
+         * Write a house or a project into a JSON stream, the format is same as `json_reader`.
+         */
+        template<typename TConstant = constant<>>
+        class json_writer
+        {
+        public:
+            typedef typename TConstant::precision_type  precision_type;
+            typedef typename TConstant::id_type         id_type;
+            typedef house<TConstant>                    house_type;
+            typedef building<TConstant>                 building_type;
+            typedef site<TConstant>                     site_type;
+            typedef project<TConstant>                  project_type;
+
+        public:
+            static void write(std::ostream& _output, const house_type& _house)
+            {
+                _output << '{';
+                writeHouseFields(_output, _house);
+                _output << '}';
+            }
+
+            static void write(std::ostream& _output, const project_type& _project)
+            {
+                _output << "{\"name\":";
+                writeString(_output, _project.name);
+                _output << ",\"sites\":[";
+                for (typename project_type::site_map::const_iterator cit_site = _project.sites.cbegin(); cit_site != _project.sites.cend(); ++cit_site)
+                {
+                    if (cit_site != _project.sites.cbegin()) _output << ',';
+                    _output << "\n{\"id\":";
+                    writeId(_output, cit_site->first);
+                    _output << ",\"name\":";
+                    writeString(_output, cit_site->second.name);
+                    _output << ",\"buildings\":[";
+                    const typename site_type::building_map& bim_buildings = cit_site->second.buildings;
+                    for (typename site_type::building_map::const_iterator cit_building = bim_buildings.cbegin(); cit_building != bim_buildings.cend(); ++cit_building)
+                    {
+                        if (cit_building != bim_buildings.cbegin()) _output << ',';
+                        _output << "\n{\"id\":";
+                        writeId(_output, cit_building->first);
+                        _output << ",\"houses\":[";
+                        const typename building_type::house_map& bim_houses = cit_building->second.houses;
+                        for (typename building_type::house_map::const_iterator cit_house = bim_houses.cbegin(); cit_house != bim_houses.cend(); ++cit_house)
+                        {
+                            if (cit_house != bim_houses.cbegin()) _output << ',';
+                            _output << "\n{\"id\":";
+                            writeId(_output, cit_house->first);
+                            _output << ',';
+                            writeHouseFields(_output, cit_house->second);
+                            _output << '}';
+                        }
+                        _output << "],\"positions\":[";
+                        const typename building_type::potision_map& bim_positions = cit_building->second.positions;
+                        for (typename building_type::potision_map::const_iterator cit_position = bim_positions.cbegin(); cit_position != bim_positions.cend(); ++cit_position)
+                        {
+                            if (cit_position != bim_positions.cbegin()) _output << ',';
+                            _output << "{\"x\":";
+                            writeNumber(_output, cit_position->first.x());
+                            _output << ",\"y\":";
+                            writeNumber(_output, cit_position->first.y());
+                            _output << ",\"house_id\":";
+                            writeId(_output, cit_position->second);
+                            _output << '}';
+                        }
+                        _output << "]}";
+                    }
+                    _output << "]}";
+                }
+                _output << "]}";
+            }
+
+        private:
+            static void writeHouseFields(std::ostream& _output, const house_type& _house)
+            {
+                _output << "\"name\":";
+                writeString(_output, _house.name);
+                _output << ",\"nodes\":[";
+                for (typename house_type::node_map::const_iterator cit = _house.nodes.cbegin(); cit != _house.nodes.cend(); ++cit)
+                {
+                    if (cit != _house.nodes.cbegin()) _output << ',';
+                    _output << "\n{\"id\":";
+                    writeId(_output, cit->first);
+                    _output << ",\"x\":";
+                    writeNumber(_output, cit->second.x());
+                    _output << ",\"y\":";
+                    writeNumber(_output, cit->second.y());
+                    _output << '}';
+                }
+                _output << "],\"walls\":[";
+                for (typename house_type::wall_map::const_iterator cit = _house.walls.cbegin(); cit != _house.walls.cend(); ++cit)
+                {
+                    if (cit != _house.walls.cbegin()) _output << ',';
+                    _output << "\n{\"id\":";
+                    writeId(_output, cit->first);
+                    _output << ",\"start_node_id\":";
+                    writeId(_output, cit->second.start_node_id);
+                    _output << ",\"end_node_id\":";
+                    writeId(_output, cit->second.end_node_id);
+                    _output << ",\"thickness\":";
+                    writeNumber(_output, cit->second.thickness);
+                    _output << ",\"kind\":";
+                    writeString(_output, cit->second.kind);
+                    _output << '}';
+                }
+                _output << "],\"holes\":[";
+                for (typename house_type::hole_map::const_iterator cit = _house.holes.cbegin(); cit != _house.holes.cend(); ++cit)
+                {
+                    if (cit != _house.holes.cbegin()) _output << ',';
+                    _output << "\n{\"id\":";
+                    writeId(_output, cit->first);
+                    _output << ",\"wall_id\":";
+                    writeId(_output, cit->second.wall_id);
+                    _output << ",\"distance\":";
+                    writeNumber(_output, cit->second.distance);
+                    _output << ",\"width\":";
+                    writeNumber(_output, cit->second.width);
+                    _output << ",\"kind\":";
+                    writeString(_output, cit->second.kind);
+                    _output << ",\"direction\":";
+                    writeString(_output, cit->second.direction);
+                    _output << '}';
+                }
+                _output << "],\"rooms\":[";
+                for (typename house_type::room_map::const_iterator cit = _house.rooms.cbegin(); cit != _house.rooms.cend(); ++cit)
+                {
+                    if (cit != _house.rooms.cbegin()) _output << ',';
+                    _output << "\n{\"id\":";
+                    writeId(_output, cit->first);
+                    _output << ",\"kind\":";
+                    writeString(_output, cit->second.kind);
+                    _output << ",\"wall_ids\":[";
+                    for (size_t i = 0, ic = cit->second.wall_ids.size(); i < ic; ++i)
+                    {
+                        if (i > 0) _output << ',';
+                        writeId(_output, cit->second.wall_ids[i]);
+                    }
+                    _output << "]}";
+                }
+                _output << ']';
+            }
+
+            static void writeId(std::ostream& _output, id_type _id)
+            {
+                if (TConstant::isValid(_id))
+                {
+                    char bim_text[32];
+                    std::snprintf(bim_text, sizeof(bim_text), "%llu", static_cast<unsigned long long>(_id));
+                    _output << bim_text;
+                }
+                else
+                {
+                    _output << "null";
+                }
+            }
+
+            /// write the shortest text which is read back to the same value, the decimal point of the C locale is written as '.'
+            static void writeNumber(std::ostream& _output, precision_type _v)
+            {
+                if (!std::isfinite(static_cast<double>(_v)))
+                {
+                    throw std::invalid_argument("contains invalid number!");
+                }
+                char bim_text[40];
+                for (int bim_precision = std::numeric_limits<precision_type>::digits10; ; ++bim_precision)
+                {
+                    std::snprintf(bim_text, sizeof(bim_text), "%.*g", bim_precision, static_cast<double>(_v));
+                    if (bim_precision >= std::numeric_limits<precision_type>::max_digits10
+                        || static_cast<precision_type>(std::strtod(bim_text, nullptr)) == _v) break;
+                }
+                char* bim_end = bim_text;
+                for (const char* p = bim_text; *p != '\0'; ++p)
+                {
+                    if ((*p >= '0' && *p <= '9') || *p == '-' || *p == '+' || *p == 'e') *bim_end++ = *p;
+                    else if (bim_end[-1] != '.') *bim_end++ = '.';
+                }
+                *bim_end = '\0';
+                _output << bim_text;
+            }
+
+        public:
+            /// write a string with the JSON escapes, it can be used by other JSON outputs
+            static void writeString(std::ostream& _output, const std::string& _string)
+            {
+                static const char* const hex_digits = "0123456789abcdef";
+                _output << '"';
+                for (const char c : _string)
+                {
+                    const unsigned char u = static_cast<unsigned char>(c);
+                    if (c == '"') _output << "\\\"";
+                    else if (c == '\\') _output << "\\\\";
+                    else if (c == '\n') _output << "\\n";
+                    else if (c == '\r') _output << "\\r";
+                    else if (c == '\t') _output << "\\t";
+                    else if (u < 0x20) _output << "\\u00" << hex_digits[u >> 4] << hex_digits[u & 0xF];
+                    else _output << c;
+                }
+                _output << '"';
+            }
+        };
+
+        /*!
+         * The SIMD kernels for the batch functions of `algorithm`, they only work for `double`.
+         * 
+         * The kernels use the IEEE `sqrt` and division, and compute in the same order as the scalar functions,
+         * so their results are same as the scalar ones (0 ULP) if neither is compiled with floating-point contraction (FMA).
+         * With contraction, the sine and cosine may differ by the rounding of one product,
+         * which is at most \f$ 2^{-53} \f$ because both lines are normalized.
+         */
+        class simd
+        {
+        public:
+            /*!
+             * An enum, it means the instruction set of the kernels.
+             */
+            enum level
+            {
+                level_none,     ///< Use the scalar functions
+                level_sse2,     ///< 2 lanes by SSE2
+                level_avx2,     ///< 4 lanes by AVX2
+                level_neon,     ///< 2 lanes by NEON
+            };
+
+            /*!
+             * An enum, it means which function the kernel computes.
+             */
+            enum angle_kind
+            {
+                angle_kind_angle,   ///< Same as `algorithm::calculateAngleEx`
+                angle_kind_sin,     ///< Same as `algorithm::calculateSinAngleEx`
+                angle_kind_cos,     ///< Same as `algorithm::calculateCosAngleEx`
+            };
+
+        public:
+            /*!
+             * Detect the best instruction set which is supported by the CPU and the OS.
+             */
+            static level detect()
+            {
+#if defined(BIMPP_PLAN2D_SIMD_X86)
+#if defined(_MSC_VER) && !defined(__clang__)
+                int info[4] = { 0, 0, 0, 0 };
+                __cpuid(info, 0);
+                const int info_count = info[0];
+                if (info_count < 1) return level_none;
+                __cpuid(info, 1);
+                const bool has_sse2 = ((info[3] >> 26) & 1) != 0;
+                const bool has_avx = ((info[2] >> 27) & 1) != 0 && ((info[2] >> 28) & 1) != 0
+                    && (_xgetbv(0) & 6) == 6;
+                bool has_avx2 = false;
+                if (has_avx && info_count >= 7)
+                {
+                    __cpuidex(info, 7, 0);
+                    has_avx2 = ((info[1] >> 5) & 1) != 0;
+                }
+#else
+                __builtin_cpu_init();
+                const bool has_sse2 = __builtin_cpu_supports("sse2") != 0;
+                const bool has_avx2 = __builtin_cpu_supports("avx2") != 0;
+#endif
+                if (has_avx2) return level_avx2;
+                if (has_sse2) return level_sse2;
+#elif defined(BIMPP_PLAN2D_SIMD_NEON)
+                return level_neon;
+#endif
+                return level_none;
+            }
+
+            /*!
+             * The instruction set which is used by the batch functions, it is detected once and can be lowered by the caller.
+             */
+            static level& selected()
+            {
+                static level selected_level = detect();
+                return selected_level;
+            }
+
+            /*!
+             * Compute the increased angles of some \f$ {B} \f$ points.
+             * 
+             * @param _level The instruction set
+             * @param _kind Which function to compute
+             * @param _o The \f$ {O} \f$ point
+             * @param _line_a The normalized \f$ \vec{OA} \f$
+             * @param _bxs The x-axis values of \f$ {B} \f$ points
+             * @param _bys The y-axis values of \f$ {B} \f$ points
+             * @param _count The count of \f$ {B} \f$ points
+             * @param _results Output the results
+             * @return The count of computed points, the rest ones must be computed by the scalar functions
+             */
+            static size_t calculateAngleExs(level _level, angle_kind _kind
+                , const double* _o, const double* _line_a
+                , const double* _bxs, const double* _bys, size_t _count, double* _results)
+            {
+                switch (_level)
+                {
+#if defined(BIMPP_PLAN2D_SIMD_X86)
+                case level_avx2:
+                    return calculateAngleExsByAvx2(_kind, _o, _line_a, _bxs, _bys, _count, _results);
+                case level_sse2:
+                    return calculateAngleExsBySse2(_kind, _o, _line_a, _bxs, _bys, _count, _results);
+#elif defined(BIMPP_PLAN2D_SIMD_NEON)
+                case level_neon:
+                    return calculateAngleExsByNeon(_kind, _o, _line_a, _bxs, _bys, _count, _results);
+#endif
+                default:
+                    return 0;
+                }
+            }
+
+            /*!
+             * Add the sums of the edges of a polygon for its area, centroid and perimeter.
+             * 
+             * The sums are \f$ \sum{c_i} \f$, \f$ \sum{(x_i + x_{i+1}) c_i} \f$, \f$ \sum{(y_i + y_{i+1}) c_i} \f$
+             * and \f$ \sum{|P_i P_{i+1}|} \f$, where \f$ c_i = x_i y_{i+1} - x_{i+1} y_i \f$.
+             * 
+             * @param _level The instruction set
+             * @param _xs The x-axis values of `_count + 1` points, the last one closes the polygon
+             * @param _ys The y-axis values of `_count + 1` points
+             * @param _count The count of edges
+             * @param _sums Add the 4 sums to it
+             * @return The count of computed edges, the rest ones must be computed by the scalar functions
+             */
+            static size_t calculatePolygonSums(level _level
+                , const double* _xs, const double* _ys, size_t _count, double* _sums)
+            {
+                switch (_level)
+                {
+#if defined(BIMPP_PLAN2D_SIMD_X86)
+                case level_avx2:
+                    return calculatePolygonSumsByAvx2(_xs, _ys, _count, _sums);
+                case level_sse2:
+                    return calculatePolygonSumsBySse2(_xs, _ys, _count, _sums);
+#elif defined(BIMPP_PLAN2D_SIMD_NEON)
+                case level_neon:
+                    return calculatePolygonSumsByNeon(_xs, _ys, _count, _sums);
+#endif
+                default:
+                    return 0;
+                }
+            }
+
+        private:
+            /*!
+             * Finish `angle_kind_angle` by the scalar `acos`, it is same as `algorithm::calculateAngleEx`.
+             */
+            static void calculateAngles(const double* _sins, const double* _coss, size_t _count, double* _results)
+            {
+                for (size_t i = 0; i < _count; ++i)
+                {
+                    _results[i] = (_sins[i] >= 0) ? acos(_coss[i]) : M_PI * 2.0 - acos(_coss[i]);
+                }
+            }
+
+#if defined(BIMPP_PLAN2D_SIMD_X86)
+            BIMPP_PLAN2D_TARGET_AVX2
+            static size_t calculateAngleExsByAvx2(angle_kind _kind
+                , const double* _o, const double* _line_a
+                , const double* _bxs, const double* _bys, size_t _count, double* _results)
+            {
+                const __m256d zero = _mm256_setzero_pd();
+                const __m256d one = _mm256_set1_pd(1.0);
+                const __m256d two = _mm256_set1_pd(2.0);
+                const __m256d three = _mm256_set1_pd(3.0);
+                const __m256d four = _mm256_set1_pd(4.0);
+                const __m256d ox = _mm256_set1_pd(_o[0]);
+                const __m256d oy = _mm256_set1_pd(_o[1]);
+                const __m256d ax = _mm256_set1_pd(_line_a[0]);
+                const __m256d ay = _mm256_set1_pd(_line_a[1]);
+                size_t i = 0;
+                for (; i + 4 <= _count; i += 4)
+                {
+                    /// Make the line \f$ \vec{OB} \f$, and normalize it if its length is not zero.
+                    __m256d bx = _mm256_sub_pd(_mm256_loadu_pd(_bxs + i), ox);
+                    __m256d by = _mm256_sub_pd(_mm256_loadu_pd(_bys + i), oy);
+                    __m256d len = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(bx, bx), _mm256_mul_pd(by, by)));
+                    len = _mm256_blendv_pd(len, one, _mm256_cmp_pd(len, zero, _CMP_EQ_OQ));
+                    bx = _mm256_div_pd(bx, len);
+                    by = _mm256_div_pd(by, len);
+                    const __m256d sin_res = _mm256_sub_pd(_mm256_mul_pd(ax, by), _mm256_mul_pd(ay, bx));
+                    const __m256d cos_res = _mm256_add_pd(_mm256_mul_pd(ax, bx), _mm256_mul_pd(ay, by));
+                    const __m256d sin_is_positive = _mm256_cmp_pd(sin_res, zero, _CMP_GE_OQ);
+                    switch (_kind)
+                    {
+                    case angle_kind_sin:
+                        {
+                            const __m256d cos_is_positive = _mm256_cmp_pd(cos_res, zero, _CMP_GE_OQ);
+                            const __m256d res = _mm256_blendv_pd(_mm256_add_pd(four, sin_res), sin_res, sin_is_positive);
+                            _mm256_storeu_pd(_results + i, _mm256_blendv_pd(_mm256_sub_pd(two, sin_res), res, cos_is_positive));
+                        }
+                        break;
+                    case angle_kind_cos:
+                        _mm256_storeu_pd(_results + i, _mm256_blendv_pd(_mm256_add_pd(three, cos_res), _mm256_sub_pd(one, cos_res), sin_is_positive));
+                        break;
+                    default:
+                        {
+                            double sins[4];
+                            double coss[4];
+                            _mm256_storeu_pd(sins, sin_res);
+                            _mm256_storeu_pd(coss, cos_res);
+                            calculateAngles(sins, coss, 4, _results + i);
+                        }
+                        break;
+                    }
+                }
+                return i;
+            }
+
+            BIMPP_PLAN2D_TARGET_SSE2
+            static __m128d selectBySse2(__m128d _mask, __m128d _a, __m128d _b)
+            {
+                return _mm_or_pd(_mm_and_pd(_mask, _a), _mm_andnot_pd(_mask, _b));
+            }
+
+            BIMPP_PLAN2D_TARGET_SSE2
+            static size_t calculateAngleExsBySse2(angle_kind _kind
+                , const double* _o, const double* _line_a
+                , const double* _bxs, const double* _bys, size_t _count, double* _results)
+            {
+                const __m128d zero = _mm_setzero_pd();
+                const __m128d one = _mm_set1_pd(1.0);
+                const __m128d two = _mm_set1_pd(2.0);
+                const __m128d three = _mm_set1_pd(3.0);
+                const __m128d four = _mm_set1_pd(4.0);
+                const __m128d ox = _mm_set1_pd(_o[0]);
+                const __m128d oy = _mm_set1_pd(_o[1]);
+                const __m128d ax = _mm_set1_pd(_line_a[0]);
+                const __m128d ay = _mm_set1_pd(_line_a[1]);
+                size_t i = 0;
+                for (; i + 2 <= _count; i += 2)
+                {
+                    /// Make the line \f$ \vec{OB} \f$, and normalize it if its length is not zero.
+                    __m128d bx = _mm_sub_pd(_mm_loadu_pd(_bxs + i), ox);
+                    __m128d by = _mm_sub_pd(_mm_loadu_pd(_bys + i), oy);
+                    __m128d len = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(bx, bx), _mm_mul_pd(by, by)));
+                    len = selectBySse2(_mm_cmpeq_pd(len, zero), one, len);
+                    bx = _mm_div_pd(bx, len);
+                    by = _mm_div_pd(by, len);
+                    const __m128d sin_res = _mm_sub_pd(_mm_mul_pd(ax, by), _mm_mul_pd(ay, bx));
+                    const __m128d cos_res = _mm_add_pd(_mm_mul_pd(ax, bx), _mm_mul_pd(ay, by));
+                    const __m128d sin_is_positive = _mm_cmpge_pd(sin_res, zero);
+                    switch (_kind)
+                    {
+                    case angle_kind_sin:
+                        {
+                            const __m128d cos_is_positive = _mm_cmpge_pd(cos_res, zero);
+                            const __m128d res = selectBySse2(sin_is_positive, sin_res, _mm_add_pd(four, sin_res));
+                            _mm_storeu_pd(_results + i, selectBySse2(cos_is_positive, res, _mm_sub_pd(two, sin_res)));
+                        }
+                        break;
+                    case angle_kind_cos:
+                        _mm_storeu_pd(_results + i, selectBySse2(sin_is_positive, _mm_sub_pd(one, cos_res), _mm_add_pd(three, cos_res)));
+                        break;
+                    default:
+                        {
+                            double sins[2];
+                            double coss[2];
+                            _mm_storeu_pd(sins, sin_res);
+                            _mm_storeu_pd(coss, cos_res);
+                            calculateAngles(sins, coss, 2, _results + i);
+                        }
+                        break;
+                    }
+                }
+                return i;
+            }
+            BIMPP_PLAN2D_TARGET_AVX2
+            static size_t calculatePolygonSumsByAvx2(const double* _xs, const double* _ys, size_t _count, double* _sums)
+            {
+                __m256d area = _mm256_setzero_pd();
+                __m256d cx = _mm256_setzero_pd();
+                __m256d cy = _mm256_setzero_pd();
+                __m256d perimeter = _mm256_setzero_pd();
+                size_t i = 0;
+                for (; i + 4 <= _count; i += 4)
+                {
+                    const __m256d x0 = _mm256_loadu_pd(_xs + i);
+                    const __m256d y0 = _mm256_loadu_pd(_ys + i);
+                    const __m256d x1 = _mm256_loadu_pd(_xs + i + 1);
+                    const __m256d y1 = _mm256_loadu_pd(_ys + i + 1);
+                    const __m256d cross = _mm256_sub_pd(_mm256_mul_pd(x0, y1), _mm256_mul_pd(x1, y0));
+                    const __m256d dx = _mm256_sub_pd(x1, x0);
+                    const __m256d dy = _mm256_sub_pd(y1, y0);
+                    area = _mm256_add_pd(area, cross);
+                    cx = _mm256_add_pd(cx, _mm256_mul_pd(_mm256_add_pd(x0, x1), cross));
+                    cy = _mm256_add_pd(cy, _mm256_mul_pd(_mm256_add_pd(y0, y1), cross));
+                    perimeter = _mm256_add_pd(perimeter, _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy))));
+                }
+                double lanes[4];
+                const __m256d sums[4] = { area, cx, cy, perimeter };
+                for (size_t i_sum = 0; i_sum < 4; ++i_sum)
+                {
+                    _mm256_storeu_pd(lanes, sums[i_sum]);
+                    _sums[i_sum] += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+                }
+                return i;
+            }
+
+            BIMPP_PLAN2D_TARGET_SSE2
+            static size_t calculatePolygonSumsBySse2(const double* _xs, const double* _ys, size_t _count, double* _sums)
+            {
+                __m128d area = _mm_setzero_pd();
+                __m128d cx = _mm_setzero_pd();
+                __m128d cy = _mm_setzero_pd();
+                __m128d perimeter = _mm_setzero_pd();
+                size_t i = 0;
+                for (; i + 2 <= _count; i += 2)
+                {
+                    const __m128d x0 = _mm_loadu_pd(_xs + i);
+                    const __m128d y0 = _mm_loadu_pd(_ys + i);
+                    const __m128d x1 = _mm_loadu_pd(_xs + i + 1);
+                    const __m128d y1 = _mm_loadu_pd(_ys + i + 1);
+                    const __m128d cross = _mm_sub_pd(_mm_mul_pd(x0, y1), _mm_mul_pd(x1, y0));
+                    const __m128d dx = _mm_sub_pd(x1, x0);
+                    const __m128d dy = _mm_sub_pd(y1, y0);
+                    area = _mm_add_pd(area, cross);
+                    cx = _mm_add_pd(cx, _mm_mul_pd(_mm_add_pd(x0, x1), cross));
+                    cy = _mm_add_pd(cy, _mm_mul_pd(_mm_add_pd(y0, y1), cross));
+                    perimeter = _mm_add_pd(perimeter, _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy))));
+                }
+                double lanes[2];
+                const __m128d sums[4] = { area, cx, cy, perimeter };
+                for (size_t i_sum = 0; i_sum < 4; ++i_sum)
+                {
+                    _mm_storeu_pd(lanes, sums[i_sum]);
+                    _sums[i_sum] += lanes[0] + lanes[1];
+                }
+                return i;
+            }
+#elif defined(BIMPP_PLAN2D_SIMD_NEON)
+            static size_t calculateAngleExsByNeon(angle_kind _kind
+                , const double* _o, const double* _line_a
+                , const double* _bxs, const double* _bys, size_t _count, double* _results)
+            {
+                const float64x2_t zero = vdupq_n_f64(0.0);
+                const float64x2_t one = vdupq_n_f64(1.0);
+                const float64x2_t two = vdupq_n_f64(2.0);
+                const float64x2_t three = vdupq_n_f64(3.0);
+                const float64x2_t four = vdupq_n_f64(4.0);
+                const float64x2_t ox = vdupq_n_f64(_o[0]);
+                const float64x2_t oy = vdupq_n_f64(_o[1]);
+                const float64x2_t ax = vdupq_n_f64(_line_a[0]);
+                const float64x2_t ay = vdupq_n_f64(_line_a[1]);
+                size_t i = 0;
+                for (; i + 2 <= _count; i += 2)
+                {
+                    /// Make the line \f$ \vec{OB} \f$, and normalize it if its length is not zero.
+                    float64x2_t bx = vsubq_f64(vld1q_f64(_bxs + i), ox);
+                    float64x2_t by = vsubq_f64(vld1q_f64(_bys + i), oy);
+                    float64x2_t len = vsqrtq_f64(vaddq_f64(vmulq_f64(bx, bx), vmulq_f64(by, by)));
+                    len = vbslq_f64(vceqq_f64(len, zero), one, len);
+                    bx = vdivq_f64(bx, len);
+                    by = vdivq_f64(by, len);
+                    const float64x2_t sin_res = vsubq_f64(vmulq_f64(ax, by), vmulq_f64(ay, bx));
+                    const float64x2_t cos_res = vaddq_f64(vmulq_f64(ax, bx), vmulq_f64(ay, by));
+                    const uint64x2_t sin_is_positive = vcgeq_f64(sin_res, zero);
+                    switch (_kind)
+                    {
+                    case angle_kind_sin:
+                        {
+                            const uint64x2_t cos_is_positive = vcgeq_f64(cos_res, zero);
+                            const float64x2_t res = vbslq_f64(sin_is_positive, sin_res, vaddq_f64(four, sin_res));
+                            vst1q_f64(_results + i, vbslq_f64(cos_is_positive, res, vsubq_f64(two, sin_res)));
+                        }
+                        break;
+                    case angle_kind_cos:
+                        vst1q_f64(_results + i, vbslq_f64(sin_is_positive, vsubq_f64(one, cos_res), vaddq_f64(three, cos_res)));
+                        break;
+                    default:
+                        {
+                            double sins[2];
+                            double coss[2];
+                            vst1q_f64(sins, sin_res);
+                            vst1q_f64(coss, cos_res);
+                            calculateAngles(sins, coss, 2, _results + i);
+                        }
+                        break;
+                    }
+                }
+                return i;
+            }
+            static size_t calculatePolygonSumsByNeon(const double* _xs, const double* _ys, size_t _count, double* _sums)
+            {
+                float64x2_t area = vdupq_n_f64(0.0);
+                float64x2_t cx = vdupq_n_f64(0.0);
+                float64x2_t cy = vdupq_n_f64(0.0);
+                float64x2_t perimeter = vdupq_n_f64(0.0);
+                size_t i = 0;
+                for (; i + 2 <= _count; i += 2)
+                {
+                    const float64x2_t x0 = vld1q_f64(_xs + i);
+                    const float64x2_t y0 = vld1q_f64(_ys + i);
+                    const float64x2_t x1 = vld1q_f64(_xs + i + 1);
+                    const float64x2_t y1 = vld1q_f64(_ys + i + 1);
+                    const float64x2_t cross = vsubq_f64(vmulq_f64(x0, y1), vmulq_f64(x1, y0));
+                    const float64x2_t dx = vsubq_f64(x1, x0);
+                    const float64x2_t dy = vsubq_f64(y1, y0);
+                    area = vaddq_f64(area, cross);
+                    cx = vaddq_f64(cx, vmulq_f64(vaddq_f64(x0, x1), cross));
+                    cy = vaddq_f64(cy, vmulq_f64(vaddq_f64(y0, y1), cross));
+                    perimeter = vaddq_f64(perimeter, vsqrtq_f64(vaddq_f64(vmulq_f64(dx, dx), vmulq_f64(dy, dy))));
+                }
+                _sums[0] += vaddvq_f64(area);
+                _sums[1] += vaddvq_f64(cx);
+                _sums[2] += vaddvq_f64(cy);
+                _sums[3] += vaddvq_f64(perimeter);
+                return i;
+            }
+#endif
+        };
+
+        /*!
+         * A fixed pool of worker threads for the parallel functions of `algorithm`.
+         * 
+         * `parallelFor` splits its items into one range per thread. Every thread takes the items from the front of its own range,
+         * and steals the back half of the range of another thread when its own one is empty, so the uneven items are balanced.
+         * It runs serially if it is called inside a worker or while the pool is busy, so it never deadlocks when nested.
+         */
+        class thread_pool
+        {
+        private:
+            /// The range of items which is owned by a thread
+            class range
+            {
+            public:
+                range()
+                    : mutex()
+                    , begin(0)
+                    , end(0)
+                {}
+
+            public:
+                std::mutex  mutex;
+                size_t      begin;
+                size_t      end;
+            };
+
+        public:
+            /*!
+             * @param _thread_count The count of threads including the calling thread, use all hardware threads if it is 0
+             */
+            explicit thread_pool(size_t _thread_count = 0)
+                : workers()
+                , ranges(_thread_count == 0 ? std::max<size_t>(1, std::thread::hardware_concurrency()) : _thread_count)
+                , job()
+                , job_generation(0)
+                , job_running(0)
+                , job_cancelled(false)
+                , job_exception()
+                , busy(false)
+                , stopping(false)
+                , job_mutex()
+                , job_cv()
+                , done_cv()
+            {
+                for (size_t i = 1, ic = ranges.size(); i < ic; ++i)
+                {
+                    workers.push_back(std::thread(&thread_pool::work, this, i));
+                }
+            }
+
+            ~thread_pool()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(job_mutex);
+                    stopping = true;
+                }
+                job_cv.notify_all();
+                for (std::thread& worker : workers)
+                {
+                    worker.join();
+                }
+            }
+
+        private:
+            thread_pool(const thread_pool&);
+            thread_pool& operator=(const thread_pool&);
+
+        public:
+            /*!
+             * The count of threads including the calling thread
+             */
+            inline size_t threadCount() const
+            {
+                return ranges.size();
+            }
+
+            /*!
+             * Call `_func(i)` for every `i` in `[0, _count)`, and wait for all of them.
+             * 
+             * The first exception thrown by `_func` is rethrown after the running items are finished, the rest items are skipped.
+             */
+            template<typename TFunc>
+            void parallelFor(size_t _count, const TFunc& _func)
+            {
+                if (_count == 0) return;
+                bool expected = false;
+                if (workers.empty() || _count == 1 || isWorker() || !busy.compare_exchange_strong(expected, true))
+                {
+                    for (size_t i = 0; i < _count; ++i)
+                    {
+                        _func(i);
+                    }
+                    return;
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(job_mutex);
+                    job = [&_func](size_t _i) { _func(_i); };
+                    const size_t bim_threads_count = ranges.size();
+                    for (size_t i = 0; i < bim_threads_count; ++i)
+                    {
+                        std::lock_guard<std::mutex> range_lock(ranges[i].mutex);
+                        ranges[i].begin = _count * i / bim_threads_count;
+                        ranges[i].end = _count * (i + 1) / bim_threads_count;
+                    }
+                    job_cancelled = false;
+                    job_exception = std::exception_ptr();
+                    job_running = workers.size();
+                    ++job_generation;
+                }
+                job_cv.notify_all();
+                runJob(0);
+                std::exception_ptr bim_exception;
+                {
+                    std::unique_lock<std::mutex> lock(job_mutex);
+                    done_cv.wait(lock, [this]() { return job_running == 0; });
+                    job = std::function<void(size_t)>();
+                    bim_exception = job_exception;
+                }
+                busy = false;
+                if (bim_exception)
+                {
+                    std::rethrow_exception(bim_exception);
+                }
+            }
+
+            /*!
+             * Is the current thread a worker of any pool?
+             */
+            static bool isWorker()
+            {
+                return workerFlag();
+            }
+
+        private:
+            static bool& workerFlag()
+            {
+                static thread_local bool is_worker = false;
+                return is_worker;
+            }
+
+            /// take an item from the front of the own range, or steal the back half of another range
+            bool takeItem(size_t _thread_index, size_t& _item)
+            {
+                range& own_range = ranges[_thread_index];
+                {
+                    std::lock_guard<std::mutex> lock(own_range.mutex);
+                    if (own_range.begin < own_range.end)
+                    {
+                        _item = own_range.begin++;
+                        return true;
+                    }
+                }
+                const size_t bim_threads_count = ranges.size();
+                for (size_t i = 1; i < bim_threads_count; ++i)
+                {
+                    range& victim_range = ranges[(_thread_index + i) % bim_threads_count];
+                    size_t bim_begin = 0;
+                    size_t bim_end = 0;
+                    {
+                        std::lock_guard<std::mutex> lock(victim_range.mutex);
+                        if (victim_range.begin >= victim_range.end) continue;
+                        bim_begin = victim_range.begin + (victim_range.end - victim_range.begin) / 2;
+                        bim_end = victim_range.end;
+                        victim_range.end = bim_begin;
+                    }
+                    _item = bim_begin;
+                    if (bim_begin + 1 < bim_end)
+                    {
+                        std::lock_guard<std::mutex> lock(own_range.mutex);
+                        own_range.begin = bim_begin + 1;
+                        own_range.end = bim_end;
+                    }
+                    return true;
+                }
+                /// the items only move between the ranges, so the one who holds them will finish them
+                return false;
+            }
+
+            void runJob(size_t _thread_index)
+            {
+                size_t i = 0;
+                while (!job_cancelled && takeItem(_thread_index, i))
+                {
+                    try
+                    {
+                        job(i);
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> lock(job_mutex);
+                        if (!job_exception)
+                        {
+                            job_exception = std::current_exception();
+                        }
+                        job_cancelled = true;
+                    }
+                }
+            }
+
+            void work(size_t _thread_index)
+            {
+                workerFlag() = true;
+                size_t generation = 0;
+                while (true)
+                {
+                    {
+                        std::unique_lock<std::mutex> lock(job_mutex);
+                        job_cv.wait(lock, [this, generation]() { return stopping || job_generation != generation; });
+                        if (stopping) return;
+                        generation = job_generation;
+                    }
+                    runJob(_thread_index);
+                    {
+                        std::lock_guard<std::mutex> lock(job_mutex);
+                        --job_running;
+                    }
+                    done_cv.notify_one();
+                }
+            }
+
+        private:
+            std::vector<std::thread>        workers;
+            std::vector<range>              ranges;         ///< The ranges of items of the calling thread and the workers
+            std::function<void(size_t)>     job;
+            size_t                          job_generation;
+            size_t                          job_running;    ///< The count of workers which are running the job
+            std::atomic<bool>               job_cancelled;
+            std::exception_ptr              job_exception;
+            std::atomic<bool>               busy;
+            bool                            stopping;
+            std::mutex                      job_mutex;
+            std::condition_variable         job_cv;
+            std::condition_variable         done_cv;
+        };
+
+        /*!
+         * A packed static R-tree of boxes, it is built once and only queried after.
+         * 
+         * The boxes are sorted by the Hilbert curve of their centers, and every `node_size` boxes or nodes are packed into a parent node,
+         * so all nodes are stored in flat arrays without any pointer. The items are `[0, size())` in the order of their boxes when building.
+         * The nodes of the level `L` are in `[level_bounds[L - 1], level_bounds[L])`, the level 0 is the items and the last one is the root.
+         */
+        template<typename TPrecision = double>
+        class box_tree
+        {
+        public:
+            typedef TPrecision  precision_type;
+
+            static const size_t node_size = 16;
+
+        public:
+            box_tree()
+                : item_count(0)
+                , boxes()
+                , indices()
+                , level_bounds()
+            {}
+
+        public:
+            inline void clear()
+            {
+                item_count = 0;
+                boxes.clear();
+                indices.clear();
+                level_bounds.clear();
+            }
+
+            inline size_t size() const
+            {
+                return item_count;
+            }
+
+            /*!
+             * Build the tree by the boxes of all items.
+             * 
+             * @param _boxes The min x, min y, max x and max y of every item
+             * @param _pool Compute the Hilbert values in parallel if it is not null
+             */
+            void build(const std::vector<precision_type>& _boxes, thread_pool* _pool = nullptr)
+            {
+                clear();
+                item_count = _boxes.size() / 4;
+                if (item_count == 0) return;
+
+                precision_type bim_min_x = _boxes[0], bim_min_y = _boxes[1], bim_max_x = _boxes[2], bim_max_y = _boxes[3];
+                for (size_t i = 1; i < item_count; ++i)
+                {
+                    bim_min_x = std::min(bim_min_x, _boxes[i * 4]);
+                    bim_min_y = std::min(bim_min_y, _boxes[i * 4 + 1]);
+                    bim_max_x = std::max(bim_max_x, _boxes[i * 4 + 2]);
+                    bim_max_y = std::max(bim_max_y, _boxes[i * 4 + 3]);
+                }
+                const precision_type bim_width = (bim_max_x > bim_min_x) ? (bim_max_x - bim_min_x) : static_cast<precision_type>(1);
+                const precision_type bim_height = (bim_max_y > bim_min_y) ? (bim_max_y - bim_min_y) : static_cast<precision_type>(1);
+
+                /// sort the items by the Hilbert values of their centers on a grid of 65536 * 65536
+                std::vector<std::pair<std::uint32_t, size_t>> bim_orders(item_count);
+                auto compute_order = [&](size_t _index)
+                {
+                    const precision_type bim_x = (_boxes[_index * 4] + _boxes[_index * 4 + 2]) / 2 - bim_min_x;
+                    const precision_type bim_y = (_boxes[_index * 4 + 1] + _boxes[_index * 4 + 3]) / 2 - bim_min_y;
+                    bim_orders[_index] = std::make_pair(hilbert(static_cast<std::uint32_t>(65535 * bim_x / bim_width)
+                        , static_cast<std::uint32_t>(65535 * bim_y / bim_height)), _index);
+                };
+                if (_pool != nullptr)
+                {
+                    _pool->parallelFor(item_count, compute_order);
+                }
+                else
+                {
+                    for (size_t i = 0; i < item_count; ++i)
+                    {
+                        compute_order(i);
+                    }
+                }
+                std::sort(bim_orders.begin(), bim_orders.end());
+
+                size_t bim_nodes_count = item_count;
+                for (size_t bim_count = item_count; bim_count > 1 || bim_nodes_count == item_count; )
+                {
+                    bim_count = (bim_count + node_size - 1) / node_size;
+                    bim_nodes_count += bim_count;
+                }
+                boxes.resize(bim_nodes_count * 4);
+                indices.resize(bim_nodes_count);
+                for (size_t i = 0; i < item_count; ++i)
+                {
+                    const size_t bim_item = bim_orders[i].second;
+                    std::copy(_boxes.begin() + bim_item * 4, _boxes.begin() + bim_item * 4 + 4, boxes.begin() + i * 4);
+                    indices[i] = bim_item;
+                }
+
+                /// every node keeps the position of its first child
+                level_bounds.push_back(item_count);
+                size_t bim_begin = 0;
+                size_t bim_end = item_count;
+                size_t bim_position = item_count;
+                do
+                {
+                    for (size_t i = bim_begin; i < bim_end; i += node_size)
+                    {
+                        const size_t bim_children_end = std::min(i + node_size, bim_end);
+                        precision_type* bim_box = &boxes[bim_position * 4];
+                        std::copy(boxes.begin() + i * 4, boxes.begin() + i * 4 + 4, bim_box);
+                        for (size_t c = i + 1; c < bim_children_end; ++c)
+                        {
+                            bim_box[0] = std::min(bim_box[0], boxes[c * 4]);
+                            bim_box[1] = std::min(bim_box[1], boxes[c * 4 + 1]);
+                            bim_box[2] = std::max(bim_box[2], boxes[c * 4 + 2]);
+                            bim_box[3] = std::max(bim_box[3], boxes[c * 4 + 3]);
+                        }
+                        indices[bim_position++] = i;
+                    }
+                    level_bounds.push_back(bim_position);
+                    bim_begin = bim_end;
+                    bim_end = bim_position;
+                } while (bim_end - bim_begin > 1);
+            }
+
+            /*!
+             * Call `_visit(item)` for every item whose box intersects the box.
+             */
+            template<typename TVisit>
+            void query(precision_type _min_x, precision_type _min_y, precision_type _max_x, precision_type _max_y, const TVisit& _visit) const
+            {
+                if (item_count == 0) return;
+                /// a node pushes at most `node_size` children, and there are at most 16 levels for 64-bit counts
+                std::array<std::pair<size_t, size_t>, node_size * 17> bim_stack;
+                size_t bim_stack_size = 0;
+                bim_stack[bim_stack_size++] = std::make_pair(indices.size() - 1, level_bounds.size() - 1);
+                while (bim_stack_size > 0)
+                {
+                    const std::pair<size_t, size_t> bim_node = bim_stack[--bim_stack_size];
+                    const size_t bim_children_end = std::min(indices[bim_node.first] + node_size, level_bounds[bim_node.second - 1]);
+                    for (size_t c = indices[bim_node.first]; c < bim_children_end; ++c)
+                    {
+                        if (boxes[c * 4] > _max_x || boxes[c * 4 + 1] > _max_y || boxes[c * 4 + 2] < _min_x || boxes[c * 4 + 3] < _min_y) continue;
+                        if (bim_node.second == 1)
+                        {
+                            _visit(indices[c]);
+                        }
+                        else
+                        {
+                            bim_stack[bim_stack_size++] = std::make_pair(c, bim_node.second - 1);
+                        }
+                    }
+                }
+            }
+
+            /*!
+             * Find the nearest item to a point by the branch and bound search, the nearer children are searched first.
+             * 
+             * @param _x The x-axis value of the point
+             * @param _y The y-axis value of the point
+             * @param _distance_2 Get the squared distance from the point to an item, it must not be smaller than the one to its box
+             * @param _max_distance_2 Only find the items which are nearer than it, and output the squared distance to the found item
+             * @return The found item, or `size()` if none is found
+             */
+            template<typename TDistance2>
+            size_t nearest(precision_type _x, precision_type _y, const TDistance2& _distance_2, precision_type& _max_distance_2) const
+            {
+                size_t bim_item = item_count;
+                if (item_count > 0)
+                {
+                    searchNearest(indices.size() - 1, level_bounds.size() - 1, _x, _y, _distance_2, _max_distance_2, bim_item);
+                }
+                return bim_item;
+            }
+
+        private:
+            template<typename TDistance2>
+            void searchNearest(size_t _position, size_t _level, precision_type _x, precision_type _y
+                , const TDistance2& _distance_2, precision_type& _max_distance_2, size_t& _item) const
+            {
+                std::array<std::pair<precision_type, size_t>, node_size> bim_children;
+                size_t bim_children_count = 0;
+                const size_t bim_children_end = std::min(indices[_position] + node_size, level_bounds[_level - 1]);
+                for (size_t c = indices[_position]; c < bim_children_end; ++c)
+                {
+                    const precision_type bim_dx = std::max(std::max(boxes[c * 4] - _x, _x - boxes[c * 4 + 2]), static_cast<precision_type>(0));
+                    const precision_type bim_dy = std::max(std::max(boxes[c * 4 + 1] - _y, _y - boxes[c * 4 + 3]), static_cast<precision_type>(0));
+                    const precision_type bim_box_distance_2 = bim_dx * bim_dx + bim_dy * bim_dy;
+                    if (bim_box_distance_2 >= _max_distance_2) continue;
+                    if (_level == 1)
+                    {
+                        const precision_type bim_distance_2 = _distance_2(indices[c]);
+                        if (bim_distance_2 < _max_distance_2)
+                        {
+                            _max_distance_2 = bim_distance_2;
+                            _item = indices[c];
+                        }
+                        continue;
+                    }
+                    /// insert by the distance
+                    size_t i = bim_children_count++;
+                    for (; i > 0 && bim_children[i - 1].first > bim_box_distance_2; --i)
+                    {
+                        bim_children[i] = bim_children[i - 1];
+                    }
+                    bim_children[i] = std::make_pair(bim_box_distance_2, c);
+                }
+                for (size_t i = 0; i < bim_children_count && bim_children[i].first < _max_distance_2; ++i)
+                {
+                    searchNearest(bim_children[i].second, _level - 1, _x, _y, _distance_2, _max_distance_2, _item);
+                }
+            }
+
+            /// the index on the Hilbert curve of a cell of a grid of 65536 * 65536
+            static std::uint32_t hilbert(std::uint32_t _x, std::uint32_t _y)
+            {
+                std::uint32_t a = _x ^ _y;
+                std::uint32_t b = 0xFFFF ^ a;
+                std::uint32_t c = 0xFFFF ^ (_x | _y);
+                std::uint32_t d = _x & (_y ^ 0xFFFF);
+
+                std::uint32_t A = a | (b >> 1);
+                std::uint32_t B = (a >> 1) ^ a;
+                std::uint32_t C = ((c >> 1) ^ (b & (d >> 1))) ^ c;
+                std::uint32_t D = ((a & (c >> 1)) ^ (d >> 1)) ^ d;
+
+                a = A; b = B; c = C; d = D;
+                A = ((a & (a >> 2)) ^ (b & (b >> 2)));
+                B = ((a & (b >> 2)) ^ (b & ((a ^ b) >> 2)));
+                C ^= ((a & (c >> 2)) ^ (b & (d >> 2)));
+                D ^= ((b & (c >> 2)) ^ ((a ^ b) & (d >> 2)));
+
+                a = A; b = B; c = C; d = D;
+                A = ((a & (a >> 4)) ^ (b & (b >> 4)));
+                B = ((a & (b >> 4)) ^ (b & ((a ^ b) >> 4)));
+                C ^= ((a & (c >> 4)) ^ (b & (d >> 4)));
+                D ^= ((b & (c >> 4)) ^ ((a ^ b) & (d >> 4)));
+
+                a = A; b = B; c = C; d = D;
+                C ^= ((a & (c >> 8)) ^ (b & (d >> 8)));
+                D ^= ((b & (c >> 8)) ^ ((a ^ b) & (d >> 8)));
+
+                a = C ^ (C >> 1);
+                b = D ^ (D >> 1);
+
+                std::uint32_t i0 = _x ^ _y;
+                std::uint32_t i1 = b | (0xFFFF ^ (i0 | a));
+
+                i0 = (i0 | (i0 << 8)) & 0x00FF00FF;
+                i0 = (i0 | (i0 << 4)) & 0x0F0F0F0F;
+                i0 = (i0 | (i0 << 2)) & 0x33333333;
+                i0 = (i0 | (i0 << 1)) & 0x55555555;
+
+                i1 = (i1 | (i1 << 8)) & 0x00FF00FF;
+                i1 = (i1 | (i1 << 4)) & 0x0F0F0F0F;
+                i1 = (i1 | (i1 << 2)) & 0x33333333;
+                i1 = (i1 | (i1 << 1)) & 0x55555555;
+
+                return (i1 << 1) | i0;
+            }
+
+        private:
+            size_t                      item_count;
+            std::vector<precision_type> boxes;          ///< The min x, min y, max x and max y of every item and node
+            std::vector<size_t>         indices;        ///< The item of every leaf, or the position of the first child of every node
+            std::vector<size_t>         level_bounds;   ///< The end position of every level
+        };
+
+        /*!
+         * The original ids of the entities of a house which is renumbered by `algorithm::renumberHouse`.
+         * 
+         * The entity whose new id is `i` has the original id `node_ids[i]`, `wall_ids[i]`, `hole_ids[i]` or `room_ids[i]`.
+         * The original ids are sorted, so the new id of an original id is found by a binary search.
+         */
+        template<typename TId = size_t>
+        class id_renumbering
+        {
+        public:
+            typedef TId                 id_type;
+            typedef std::vector<TId>    id_vector;
+
+            static const size_t none_index = static_cast<size_t>(-1);
+
+        public:
+            id_renumbering()
+                : node_ids()
+                , wall_ids()
+                , hole_ids()
+                , room_ids()
+            {}
+
+        public:
+            inline void clear()
+            {
+                node_ids.clear();
+                wall_ids.clear();
+                hole_ids.clear();
+                room_ids.clear();
+            }
+
+            /// Find the new id of a node, return `none_index` if it is not found
+            inline size_t findNode(id_type _id) const
+            {
+                return find(node_ids, _id);
+            }
+
+            /// Find the new id of a wall, return `none_index` if it is not found
+            inline size_t findWall(id_type _id) const
+            {
+                return find(wall_ids, _id);
+            }
+
+            /// Find the new id of a hole, return `none_index` if it is not found
+            inline size_t findHole(id_type _id) const
+            {
+                return find(hole_ids, _id);
+            }
+
+            /// Find the new id of a room, return `none_index` if it is not found
+            inline size_t findRoom(id_type _id) const
+            {
+                return find(room_ids, _id);
+            }
+
+            static size_t find(const id_vector& _ids, id_type _id)
+            {
+                typename id_vector::const_iterator cit_found = std::lower_bound(_ids.cbegin(), _ids.cend(), _id);
+                if (cit_found == _ids.cend() || *cit_found != _id)
+                {
+                    return none_index;
+                }
+                return static_cast<size_t>(cit_found - _ids.cbegin());
+            }
+
+        public:
+            id_vector   node_ids;
+            id_vector   wall_ids;
+            id_vector   hole_ids;
+            id_vector   room_ids;
+        };
+
+        template<typename TConstant = constant<>>
+        class algorithm
+        {
+        public:
+            typedef typename TConstant::precision_type  precision_type;
+            typedef typename TConstant::point_type      point_type;
+            typedef typename TConstant::id_type         id_type;
+            typedef std::vector<id_type>                id_vector;
+            typedef node<TConstant>                     node_type;
+            typedef wall<TConstant>                     wall_type;
+            typedef hole<TConstant>                     hole_type;
+            typedef room<TConstant>                     room_type;
+            typedef house<TConstant>                    house_type;
+            typedef building<TConstant>                 building_type;
+            typedef site<TConstant>                     site_type;
+            typedef project<TConstant>                  project_type;
+
+        public:
+            class wall_ex
+            {
+            public:
+                wall_ex(id_type _id = TConstant::none_id, bool _inversed = false)
+                    : id(_id)
+                    , inversed(_inversed)
+                    , repeated(false)
+                {}
+
+            public:
+                bool operator==(const wall_ex& _a) const
+                {
+                    return (id == _a.id && inversed == _a.inversed);
+                }
+
+            public:
+                id_type     id;
+                bool        inversed;
+                bool        repeated;
+            };
+
+            /*!
+             * An enum, it means the direction of the room's edges.
+             */
+            enum room_side
+            {
+                room_side_both,     ///< Don't know the room faces inside or outside
+                room_side_in,       ///< The room faces inside
+                room_side_out,      ///< The room faces outside
+            };
+
+            /*!
+             * An enum, it means how to choose the next wall when tracing the room's edges.
+             */
+            enum trace_mode
+            {
+                trace_mode_angle,       ///< Compare the `sin-angle-ex` of all unused next walls at every step
+                trace_mode_rotation,    ///< Look up the next wall from the walls of every node, which are sorted by angle once
+                trace_mode_face,        ///< Walk every half-edge exactly once along the sorted walls, see `extractRoomExs`
+            };
+
+            class room_ex
+            {
+            public:
+                room_ex()
+                    : id(TConstant::none_id)
+                    , walls()
+                    , side(room_side_both)
+                {}
+
+            public:
+                id_type                 id;
+                std::vector<wall_ex>    walls;
+                room_side               side;
+            };
+
+            class node_ex
+            {
+            public:
+                node_ex(id_type _id = TConstant::none_id
+                    , bool _used = false)
+                    : id(_id)
+                    , used(_used)
+                    , with_wall()
+                {}
+
+            public:
+                bool operator==(const node_ex& _a) const
+                {
+                    return (id == _a.id
+                        && used == _a.used
+                        && with_wall == _a.with_wall);
+                }
+
+            public:
+                id_type     id;
+                bool        used;
+                wall_ex     with_wall;
+            };
+
+            /*!
+             * A compact half-edge graph of walls.
+             * 
+             * The nodes are renumbered to dense indices which are sorted by their ids,
+             * and the half-edges which start from the node `i` are stored in `[offsets[i], offsets[i + 1])`.
+             */
+            class half_edge_graph
+            {
+            public:
+                half_edge_graph()
+                    : node_ids()
+                    , nodes()
+                    , offsets()
+                    , targets()
+                    , walls()
+                    , twins()
+                    , rotations()
+                    , nexts()
+                    , used_bits()
+                {}
+
+            public:
+                inline size_t nodeCount() const
+                {
+                    return node_ids.size();
+                }
+
+                inline size_t halfEdgeCount() const
+                {
+                    return targets.size();
+                }
+
+                /*!
+                 * Find the dense index of a node, return `nodeCount()` if it is not found.
+                 */
+                inline size_t findNodeIndex(id_type _node_id) const
+                {
+                    typename id_vector::const_iterator cit_found = std::lower_bound(node_ids.cbegin(), node_ids.cend(), _node_id);
+                    if (cit_found == node_ids.cend() || *cit_found != _node_id)
+                    {
+                        return nodeCount();
+                    }
+                    return static_cast<size_t>(cit_found - node_ids.cbegin());
+                }
+
+                /*!
+                 * Find the first unused half-edge of a node, return `halfEdgeCount()` if it is not found.
+                 */
+                inline size_t findUnusedHalfEdge(size_t _node_index) const
+                {
+                    for (size_t i = offsets[_node_index], ic = offsets[_node_index + 1]; i < ic; ++i)
+                    {
+                        if (!isUsed(i)) return i;
+                    }
+                    return halfEdgeCount();
+                }
+
+                inline bool isUsed(size_t _half_edge) const
+                {
+                    return ((used_bits[_half_edge / 64] >> (_half_edge % 64)) & 1) != 0;
+                }
+
+                /*!
+                 * Get the dense index of the start node of the wall which the half-edge is on.
+                 */
+                inline size_t wallStartNodeIndex(size_t _half_edge) const
+                {
+                    return walls[_half_edge].inversed ? targets[_half_edge] : targets[twins[_half_edge]];
+                }
+
+                /*!
+                 * Get the dense index of the end node of the wall which the half-edge is on.
+                 */
+                inline size_t wallEndNodeIndex(size_t _half_edge) const
+                {
+                    return walls[_half_edge].inversed ? targets[twins[_half_edge]] : targets[_half_edge];
+                }
+
+                inline void setUsed(size_t _half_edge)
+                {
+                    used_bits[_half_edge / 64] |= (static_cast<std::uint64_t>(1) << (_half_edge % 64));
+                }
+
+                inline void resetUsed()
+                {
+                    used_bits.assign((halfEdgeCount() + 63) / 64, 0);
+                }
+
+                inline void clear()
+                {
+                    node_ids.clear();
+                    nodes.clear();
+                    offsets.clear();
+                    targets.clear();
+                    walls.clear();
+                    twins.clear();
+                    rotations.clear();
+                    nexts.clear();
+                    used_bits.clear();
+                }
+
+            public:
+                id_vector                   node_ids;   ///< The sorted ids of nodes
+                std::vector<node_type>      nodes;      ///< The nodes by dense indices
+                std::vector<size_t>         offsets;    ///< The offsets of half-edges by dense indices of nodes
+                std::vector<size_t>         targets;    ///< The dense index of the end node of each half-edge
+                std::vector<wall_ex>        walls;      ///< The wall of each half-edge
+                std::vector<size_t>         twins;      ///< The opposite half-edge of each half-edge
+                std::vector<size_t>         rotations;  ///< The half-edges of every node sorted by angle, same offsets as `targets`
+                std::vector<size_t>         nexts;      ///< The next half-edge of the same room-ex, it is valid after `buildRotationSystem`
+                std::vector<std::uint64_t>  used_bits;  ///< Whether each half-edge is used
+            };
+
+        public:
+            typedef std::vector<room_ex>               room_ex_vector;
+
+            /*!
+             * The geometric metrics of a room-ex, see `computeRoomExMetrics`.
+             */
+            class room_ex_metrics
+            {
+            public:
+                room_ex_metrics()
+                    : area(0)
+                    , net_area(0)
+                    , perimeter(0)
+                    , centroid()
+                    , min()
+                    , max()
+                {}
+
+            public:
+                precision_type  area;       ///< The area of the polygon by the center lines of walls
+                precision_type  net_area;   ///< The area inside the walls, the half thickness of every wall is subtracted
+                precision_type  perimeter;  ///< The perimeter by the center lines of walls
+                point_type      centroid;   ///< The centroid of the polygon
+                point_type      min;        ///< The min point of the bounding box
+                point_type      max;        ///< The max point of the bounding box
+            };
+
+            typedef std::vector<room_ex_metrics>       room_ex_metrics_vector;
+
+            /*!
+             * The containment tree of the room-exs, see `computeRoomExHierarchy`.
+             *
+             * The parent of a room-ex of `room_side_in` is the outer boundary of its connected walls,
+             * and the parent of an outer boundary is the smallest room-ex of `room_side_in` which contains it.
+             * So the children of a room-ex of `room_side_in` are its holes, such as columns or shafts, and they make a polygon with holes.
+             * The children of the room-ex `i` are stored in `[offsets[i], offsets[i + 1])` of `children` by the order of room-exs.
+             */
+            class room_ex_hierarchy
+            {
+            public:
+                static const size_t none_index = static_cast<size_t>(-1);
+
+            public:
+                room_ex_hierarchy()
+                    : parents()
+                    , offsets()
+                    , children()
+                    , roots()
+                {}
+
+            public:
+                inline size_t size() const
+                {
+                    return parents.size();
+                }
+
+                inline size_t childCount(size_t _index) const
+                {
+                    return offsets[_index + 1] - offsets[_index];
+                }
+
+                /// Get the `_i`th child of the room-ex, it is a hole if the room-ex is `room_side_in`
+                inline size_t child(size_t _index, size_t _i) const
+                {
+                    return children[offsets[_index] + _i];
+                }
+
+                inline void clear()
+                {
+                    parents.clear();
+                    offsets.clear();
+                    children.clear();
+                    roots.clear();
+                }
+
+            public:
+                std::vector<size_t>     parents;    ///< The parent of every room-ex, `none_index` if it is not contained by any room-ex
+                std::vector<size_t>     offsets;    ///< The offsets of children by the indices of room-exs
+                std::vector<size_t>     children;   ///< The children of all room-exs
+                std::vector<size_t>     roots;      ///< The room-exs without parent by their orders
+            };
+
+            /*!
+             * The room-exs of a house in a project, it is keyed by the ids of the site, the building and the house.
+             * 
+             * The room-exs are in the coordinates of the house, add one of `positions` to place them in the building.
+             */
+            class house_room_ex
+            {
+            public:
+                house_room_ex(id_type _site_id = TConstant::none_id
+                    , id_type _building_id = TConstant::none_id
+                    , id_type _house_id = TConstant::none_id)
+                    : site_id(_site_id)
+                    , building_id(_building_id)
+                    , house_id(_house_id)
+                    , computed(false)
+                    , error("")
+                    , room_exs()
+                    , positions()
+                {}
+
+            public:
+                bool operator<(const house_room_ex& _a) const
+                {
+                    if (site_id != _a.site_id) return (site_id < _a.site_id);
+                    if (building_id != _a.building_id) return (building_id < _a.building_id);
+                    return (house_id < _a.house_id);
+                }
+
+            public:
+                id_type                 site_id;
+                id_type                 building_id;
+                id_type                 house_id;
+                bool                    computed;   ///< The result of `computeRoomExs`
+                std::string             error;      ///< The message if `computeRoomExs` throws an exception
+                room_ex_vector          room_exs;
+                std::vector<point_type> positions;  ///< The positions of the house in its building by their orders
+            };
+
+            /// The room-exs of all houses, they are sorted by the ids
+            typedef std::vector<house_room_ex>          house_room_ex_vector;
+
+            /*!
+             * A piece of a wall which is split by `nodeWalls`, it keeps the id of the original wall.
+             */
+            class wall_piece
+            {
+            public:
+                wall_piece(id_type _wall_id = TConstant::none_id
+                    , id_type _original_wall_id = TConstant::none_id
+                    , precision_type _start = 0
+                    , precision_type _end = 0)
+                    : wall_id(_wall_id)
+                    , original_wall_id(_original_wall_id)
+                    , start(_start)
+                    , end(_end)
+                {}
+
+            public:
+                id_type         wall_id;            ///< The id of the piece, the first piece keeps the id of the original wall
+                id_type         original_wall_id;
+                precision_type  start;              ///< The distance from the start node of the original wall to the start of the piece
+                precision_type  end;                ///< The distance from the start node of the original wall to the end of the piece
+            };
+
+            typedef std::vector<wall_piece>             wall_piece_vector;
+
+            /*!
+             * An inverted index from the walls to the rooms which use them.
+             * 
+             * The rooms are numbered by their orders in the house, and the rooms of the wall `wall_ids[i]`
+             * are stored in `[offsets[i], offsets[i + 1])` of `room_indices` from small to big.
+             */
+            class wall_room_index
+            {
+            public:
+                wall_room_index()
+                    : room_ids()
+                    , room_sizes()
+                    , wall_ids()
+                    , offsets()
+                    , room_indices()
+                {}
+
+                explicit wall_room_index(const house_type& _house)
+                    : room_ids()
+                    , room_sizes()
+                    , wall_ids()
+                    , offsets()
+                    , room_indices()
+                {
+                    build(_house);
+                }
+
+            public:
+                /*!
+                 * Index all rooms of a house.
+                 */
+                void build(const house_type& _house)
+                {
+                    std::vector<std::pair<id_type, size_t>> bim_walls_2_rooms;
+                    build(_house, bim_walls_2_rooms);
+                }
+
+                /*!
+                 * Index all rooms of a house.
+                 * 
+                 * @param _house The house
+                 * @param _walls_2_rooms The buffer of the pairs of walls and rooms, it can be reused by every build
+                 */
+                void build(const house_type& _house, std::vector<std::pair<id_type, size_t>>& _walls_2_rooms)
+                {
+                    room_ids.clear();
+                    room_sizes.clear();
+                    std::vector<std::pair<id_type, size_t>>& bim_walls_2_rooms = _walls_2_rooms;
+                    bim_walls_2_rooms.clear();
+                    for (typename house_type::room_map::const_iterator cit = _house.rooms.cbegin();
+                        cit != _house.rooms.cend(); ++cit)
+                    {
+                        const size_t bim_room_index = room_ids.size();
+                        room_ids.push_back(cit->first);
+                        room_sizes.push_back(cit->second.wall_ids.size());
+                        for (id_type bim_wall_id : cit->second.wall_ids)
+                        {
+                            bim_walls_2_rooms.push_back(std::make_pair(bim_wall_id, bim_room_index));
+                        }
+                    }
+                    std::sort(bim_walls_2_rooms.begin(), bim_walls_2_rooms.end());
+                    bim_walls_2_rooms.erase(std::unique(bim_walls_2_rooms.begin(), bim_walls_2_rooms.end()), bim_walls_2_rooms.end());
+
+                    wall_ids.clear();
+                    offsets.clear();
+                    room_indices.clear();
+                    room_indices.reserve(bim_walls_2_rooms.size());
+                    for (const std::pair<id_type, size_t>& bim_wall_2_room : bim_walls_2_rooms)
+                    {
+                        if (wall_ids.empty() || wall_ids.back() != bim_wall_2_room.first)
+                        {
+                            wall_ids.push_back(bim_wall_2_room.first);
+                            offsets.push_back(room_indices.size());
+                        }
+                        room_indices.push_back(bim_wall_2_room.second);
+                    }
+                    offsets.push_back(room_indices.size());
+                }
+
+                inline size_t roomCount() const
+                {
+                    return room_ids.size();
+                }
+
+                /*!
+                 * Find the ids of the rooms which use a wall, they are in the same order as the rooms of the house.
+                 * 
+                 * @param _wall_id The id of the wall
+                 * @param _room_ids Output the ids of the rooms
+                 */
+                bool findRoomIds(id_type _wall_id, id_vector& _room_ids) const
+                {
+                    _room_ids.clear();
+                    const size_t bim_wall_index = findWallIndex(_wall_id);
+                    if (bim_wall_index == wall_ids.size())
+                    {
+                        return false;
+                    }
+                    for (size_t i = offsets[bim_wall_index], ic = offsets[bim_wall_index + 1]; i < ic; ++i)
+                    {
+                        _room_ids.push_back(room_ids[room_indices[i]]);
+                    }
+                    return true;
+                }
+
+                /*!
+                 * Find the first room which contains all walls of a room-ex, same as `isContainsForBiggerVector`.
+                 * 
+                 * The rooms of the rarest wall are the candidates, and every candidate is searched in the rooms of the other walls,
+                 * so it costs \f$ O(k \log W + c \, k \log R) \f$ for \f$ k \f$ walls and \f$ c \f$ candidates.
+                 * 
+                 * @param _room_ex The room-ex
+                 * @return The id of the room, or `TConstant::none_id` if it is not found
+                 */
+                id_type findRoomId(const room_ex& _room_ex) const
+                {
+                    std::vector<std::pair<size_t, size_t>> bim_ranges;
+                    return findRoomId(_room_ex, bim_ranges);
+                }
+
+                /*!
+                 * Find the first room which contains all walls of a room-ex.
+                 * 
+                 * @param _room_ex The room-ex
+                 * @param _ranges The buffer of the rooms of every wall, it can be reused by every finding
+                 */
+                id_type findRoomId(const room_ex& _room_ex, std::vector<std::pair<size_t, size_t>>& _ranges) const
+                {
+                    if (_room_ex.walls.empty())
+                    {
+                        return TConstant::none_id;
+                    }
+                    std::vector<std::pair<size_t, size_t>>& bim_ranges = _ranges;
+                    bim_ranges.clear();
+                    for (const wall_ex& bim_wall_ex : _room_ex.walls)
+                    {
+                        const size_t bim_wall_index = findWallIndex(bim_wall_ex.id);
+                        if (bim_wall_index == wall_ids.size())
+                        {
+                            return TConstant::none_id;
+                        }
+                        bim_ranges.push_back(std::make_pair(offsets[bim_wall_index], offsets[bim_wall_index + 1]));
+                    }
+                    std::sort(bim_ranges.begin(), bim_ranges.end());
+                    bim_ranges.erase(std::unique(bim_ranges.begin(), bim_ranges.end()), bim_ranges.end());
+                    std::sort(bim_ranges.begin(), bim_ranges.end()
+                        , [](const std::pair<size_t, size_t>& _a, const std::pair<size_t, size_t>& _b)
+                        {
+                            return (_a.second - _a.first < _b.second - _b.first);
+                        });
+
+                    for (size_t i = bim_ranges.front().first, ic = bim_ranges.front().second; i < ic; ++i)
+                    {
+                        const size_t bim_room_index = room_indices[i];
+                        /// a room which has less walls than the room-ex is never chosen, same as `isContainsForBiggerVector`
+                        if (room_sizes[bim_room_index] < _room_ex.walls.size()) continue;
+                        size_t r = 1;
+                        const size_t rc = bim_ranges.size();
+                        for (; r < rc; ++r)
+                        {
+                            if (!std::binary_search(room_indices.cbegin() + bim_ranges[r].first
+                                , room_indices.cbegin() + bim_ranges[r].second, bim_room_index)) break;
+                        }
+                        if (r == rc)
+                        {
+                            return room_ids[bim_room_index];
+                        }
+                    }
+                    return TConstant::none_id;
+                }
+
+            private:
+                inline size_t findWallIndex(id_type _wall_id) const
+                {
+                    typename id_vector::const_iterator cit_found = std::lower_bound(wall_ids.cbegin(), wall_ids.cend(), _wall_id);
+                    if (cit_found == wall_ids.cend() || *cit_found != _wall_id)
+                    {
+                        return wall_ids.size();
+                    }
+                    return static_cast<size_t>(cit_found - wall_ids.cbegin());
+                }
+
+            public:
+                id_vector               room_ids;       ///< The id of every room
+                std::vector<size_t>     room_sizes;     ///< The count of walls of every room
+                id_vector               wall_ids;       ///< The ids of all used walls, sorted
+                std::vector<size_t>     offsets;
+                std::vector<size_t>     room_indices;
+            };
+
+            /*!
+             * The statistics of `computeRoomExs`, they are only collected if `BIMPP_PLAN2D_STATS` is defined.
+             * 
+             * The counters and times are added up, so the statistics of many calls can be aggregated by `operator+=`.
+             * The times of the tasks of a thread pool are added up too, so they may be longer than the real time.
+             */
+            class room_ex_stats
+            {
+            public:
+                room_ex_stats()
+                    : nodes(0)
+                    , half_edges(0)
+                    , trace_steps(0)
+                    , angle_evaluations(0)
+                    , faces(0)
+                    , open_faces(0)
+                    , repeated_walls(0)
+                    , build_ns(0)
+                    , trace_ns(0)
+                    , side_ns(0)
+                    , assign_ns(0)
+                {}
+
+                void clear()
+                {
+                    *this = room_ex_stats();
+                }
+
+                room_ex_stats& operator+=(const room_ex_stats& _a)
+                {
+                    nodes               += _a.nodes;
+                    half_edges          += _a.half_edges;
+                    trace_steps         += _a.trace_steps;
+                    angle_evaluations   += _a.angle_evaluations;
+                    faces               += _a.faces;
+                    open_faces          += _a.open_faces;
+                    repeated_walls      += _a.repeated_walls;
+                    build_ns            += _a.build_ns;
+                    trace_ns            += _a.trace_ns;
+                    side_ns             += _a.side_ns;
+                    assign_ns           += _a.assign_ns;
+                    return *this;
+                }
+
+                /// the nanoseconds of a steady clock
+                static std::uint64_t now()
+                {
+                    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+                }
+
+            public:
+                size_t          nodes;              ///< The nodes of the half-edge graph
+                size_t          half_edges;         ///< The half-edges of the half-edge graph, two for every wall
+                size_t          trace_steps;        ///< The half-edges which are walked by tracing
+                size_t          angle_evaluations;  ///< The `sin-angle-ex` of `trace_mode_angle`, and the comparisons of directions of `buildRotationSystem`
+                size_t          faces;              ///< The closed room-exs
+                size_t          open_faces;         ///< The paths which are dropped because they are not closed
+                size_t          repeated_walls;     ///< The walls which are marked as repeated in the room-exs
+                std::uint64_t   build_ns;           ///< The time of building the half-edge graph
+                std::uint64_t   trace_ns;           ///< The time of tracing, excluding `side_ns`
+                std::uint64_t   side_ns;            ///< The time of marking the repeated walls and deciding the sides
+                std::uint64_t   assign_ns;          ///< The time of finding the ids of rooms
+            };
+
+            /*!
+             * The buffers of `computeRoomExs`, it can be kept by the caller and reused by every call.
+             * 
+             * The buffers only grow, so computing the houses which are not bigger than before doesn't allocate any memory,
+             * if the room-exs are output into the same vector and they are traced without a thread pool.
+             */
+            class workspace
+            {
+            public:
+                workspace()
+                    : room_ids()
+                    , graph()
+                    , walls_2_orders()
+                    , walls()
+                    , wall_nodes()
+                    , cursors()
+                    , faces()
+                    , half_edges()
+                    , wall_ids()
+                    , room_index()
+                    , walls_2_rooms()
+                    , ranges()
+                    , spare_room_exs()
+                    , stats()
+                {}
+
+            public:
+                id_vector                                   room_ids;
+                half_edge_graph                             graph;
+                std::vector<std::pair<id_type, size_t>>     walls_2_orders;
+                std::vector<const wall_type*>               walls;
+                std::vector<size_t>                         wall_nodes;
+                std::vector<size_t>                         cursors;
+                std::vector<size_t>                         faces;
+                std::vector<size_t>                         half_edges;
+                id_vector                                   wall_ids;
+                wall_room_index                             room_index;
+                std::vector<std::pair<id_type, size_t>>     walls_2_rooms;
+                std::vector<std::pair<size_t, size_t>>      ranges;
+                room_ex_vector                              spare_room_exs; ///< The room-exs which are dropped from the output, to reuse their walls
+                room_ex_stats                               stats;          ///< The statistics of the last call, see `room_ex_stats`
+            };
+
+        public:
+            template<typename TItem>
+            static void addUnique(std::vector<TItem>& _v, const TItem& _i)
+            {
+                typename std::vector<TItem>::iterator it_found = std::find(_v.begin(), _v.end(), _i);
+                if (it_found != _v.end()) return;
+                _v.push_back(_i);
+            }
+
+            /*!
+             * Is the `_all` contains `_sub`?
+             * 
+             * **Importance**: The `_all` and `_sub` must be sorted from small to big.
+             * 
+             * @param _all A vector contains all items
+             * @param _sub A vector contains a part of items
+             */
+            template<typename TItem>
+            static bool isContainsForBiggerVector(const std::vector<TItem>& _all, const std::vector<TItem>& _sub)
+            {
+                if (_all.empty() || _sub.empty()) return false;
+                if (_all.size() < _sub.size()) return false;
+                size_t a_index = 0;
+                size_t s_index = 0;
+                const size_t a_size = _all.size();
+                const size_t s_size = _sub.size();
+                while (a_index < a_size
+                    && s_index < s_size
+                    && _all[a_index] <= _sub[s_index])
+                {
+                    if (_all[a_index] == _sub[s_index])
+                    {
+                        ++s_index;
+                    }
+                    else
+                    {
+                        ++a_index;
+                    }
+                }
+                return (s_index == s_size);
+            }
+
+            /*!
+             * Calculate the angle \f$ \alpha \f$ between \f$ \vec{OA} \f$ and \f$ \vec{OB} \f$.
+             * @f[
+             * f(\vec{OA}, \vec{OB}) =
+             * \begin{cases}
+             * \cos^{-1}(\vec{OA} \cdot \vec{OB})               & \quad \text{if } 0^{\circ} \leq \alpha \leq 180^{\circ}\\
+             * \pi * 2 - \cos^{-1}(\vec{OA} \cdot \vec{OB})     & \quad \text{if } 180^{\circ} < \alpha < 360^{\circ}
+             * \end{cases}
+             * @f]
+             *
+             * @param _o The \f$ {O} \f$ node(point)
+             * @param _a The \f$ {A} \f$ node(point)
+             * @param _b The \f$ {B} \f$ node(point)
+             */
+            static precision_type calculateAngleEx(const node_type& _o, const node_type& _a, const node_type& _b)
+            {
+                /// Make the line \f$ \vec{OA} \f$, and normalize it.
+                point_type line_a(_a.p() - _o.p()); line_a.normalize();
+                /// Make the line \f$ \vec{OB} \f$, and normalize it.
+                point_type line_b(_b.p() - _o.p()); line_b.normalize();
+                /// Compute the dot product and the cross product between \f$ \vec{OA} \f$ and \f$ \vec{OB} \f$
+                precision_type sin_res = line_a.dot(line_b);
+                precision_type cos_res = line_a.cross(line_b);
+                precision_type res = static_cast<precision_type>(0);
+                if (sin_res >= 0)
+                {
+                    res = static_cast<precision_type>(acos(cos_res));
+                }
+                else
+                {
+                    res = static_cast<precision_type>(M_PI * 2.0 - acos(cos_res));
+                }
+                return res;
+            }
+
+            /*!
+             * Calculate the increased sine of a angle \f$ \alpha \f$ between \f$ \vec{OA} \f$ and \f$ \vec{OB} \f$.
+             * @f[
+             * f(\vec{OA}, \vec{OB}) =
+             * \begin{cases}
+             * \vert\vec{OA} \times \vec{OB}\vert         & \quad \text{if } 0^{\circ} \leq \alpha \leq 90^{\circ}\\
+             * 2 - \vert\vec{OA} \times \vec{OB}\vert     & \quad \text{if } 90^{\circ} < \alpha < 270^{\circ}\\
+             * 4 + \vert\vec{OA} \times \vec{OB}\vert     & \quad \text{if } 270^{\circ} \leq \alpha < 360^{\circ}
+             * \end{cases}
+             * @f]
+             * 
+             * @param _o The \f$ {O} \f$ node(point)
+             * @param _a The \f$ {A} \f$ node(point)
+             * @param _b The \f$ {B} \f$ node(point)
+             */
+            static precision_type calculateSinAngleEx(const node_type& _o, const node_type& _a, const node_type& _b)
+            {
+                /// Make the line \f$ \vec{OA} \f$, and normalize it.
+                point_type line_a(_a.p() - _o.p()); line_a.normalize();
+                /// Make the line \f$ \vec{OB} \f$, and normalize it.
+                point_type line_b(_b.p() - _o.p()); line_b.normalize();
+                /// Compute the dot product and the cross product between \f$ \vec{OA} \f$ and \f$ \vec{OB} \f$
+                precision_type sin_res = line_a.dot(line_b);
+                precision_type cos_res = line_a.cross(line_b);
+                precision_type res = static_cast<precision_type>(0);
+                if (cos_res >= static_cast<precision_type>(0))
+                {
+                    if (sin_res >= static_cast<precision_type>(0))
+                    {
+                        res = sin_res;
+                    }
+                    else
+                    {
+                        res = static_cast<precision_type>(4) + sin_res;
+                    }
+                }
+                else
+                {
+                    res = static_cast<precision_type>(2) - sin_res;
+                }
+                return res;
+            }
+
+            /*!
+             * Calculate the increased cosine of a angle \f$ \alpha \f$ between \f$ \vec{OA} \f$ and \f$ \vec{OB} \f$.
+             * @f[
+             * f(\vec{OA}, \vec{OB}) =
+             * \begin{cases}
+             * 1 - \vec{OA} \cdot \vec{OB}      & \quad \text{if } 0^{\circ} \leq \alpha \leq 180^{\circ}\\
+             * 3 + \vec{OA} \cdot \vec{OB}      & \quad \text{if } 180^{\circ} < \alpha < 360^{\circ}
+             * \end{cases}
+             * @f]
+             *
+             * @param _o The \f$ {O} \f$ node(point)
+             * @param _a The \f$ {A} \f$ node(point)
+             * @param _b The \f$ {B} \f$ node(point)
+             */
+            static precision_type calculateCosAngleEx(const node_type& _o, const node_type& _a, const node_type& _b)
+            {
+                /// Make the line \f$ \vec{OA} \f$, and normalize it.
+                point_type line_a(_a.p() - _o.p()); line_a.normalize();
+                /// Make the line \f$ \vec{OB} \f$, and normalize it.
+                point_type line_b(_b.p() - _o.p()); line_b.normalize();
+                /// Compute the dot product and the cross product between \f$ \vec{OA} \f$ and \f$ \vec{OB} \f$
+                precision_type sin_res = line_a.dot(line_b);
+                precision_type cos_res = line_a.cross(line_b);
+                precision_type res = static_cast<precision_type>(0);
+                if (sin_res >= static_cast<precision_type>(0))
+                {
+                    res = static_cast<precision_type>(1) - cos_res;
+                }
+                else
+                {
+                    res = static_cast<precision_type>(3) + cos_res;
+                }
+                return res;
+            }
+
+            /*!
+             * Calculate `calculateAngleEx` between \f$ \vec{OA} \f$ and many \f$ \vec{OB} \f$ at once.
+             * 
+             * The \f$ {B} \f$ nodes are given as a structure of arrays. For `double`, it runs the SIMD kernel which is
+             * selected by `simd::selected()` at runtime, and its results are same as `calculateAngleEx` (see `simd`).
+             * Other precisions and the rest nodes of the kernel use the scalar function.
+             * 
+             * @param _o The \f$ {O} \f$ node(point)
+             * @param _a The \f$ {A} \f$ node(point)
+             * @param _bxs The x-axis values of \f$ {B} \f$ nodes
+             * @param _bys The y-axis values of \f$ {B} \f$ nodes
+             * @param _count The count of \f$ {B} \f$ nodes
+             * @param _results Output the results, it must have `_count` items
+             */
+            static void calculateAngleExs(const node_type& _o, const node_type& _a
+                , const precision_type* _bxs, const precision_type* _bys, size_t _count, precision_type* _results)
+            {
+                calculateAngleExsByKind(simd::angle_kind_angle, _o, _a, _bxs, _bys, _count, _results);
+            }
+
+            /*!
+             * Calculate `calculateSinAngleEx` between \f$ \vec{OA} \f$ and many \f$ \vec{OB} \f$ at once, see `calculateAngleExs`.
+             */
+            static void calculateSinAngleExs(const node_type& _o, const node_type& _a
+                , const precision_type* _bxs, const precision_type* _bys, size_t _count, precision_type* _results)
+            {
+                calculateAngleExsByKind(simd::angle_kind_sin, _o, _a, _bxs, _bys, _count, _results);
+            }
+
+            /*!
+             * Calculate `calculateCosAngleEx` between \f$ \vec{OA} \f$ and many \f$ \vec{OB} \f$ at once, see `calculateAngleExs`.
+             */
+            static void calculateCosAngleExs(const node_type& _o, const node_type& _a
+                , const precision_type* _bxs, const precision_type* _bys, size_t _count, precision_type* _results)
+            {
+                calculateAngleExsByKind(simd::angle_kind_cos, _o, _a, _bxs, _bys, _count, _results);
+            }
+
+            /*!
+             * Build the half-edge graph by the walls of some rooms.
+             * 
+             * Every wall is only added once even if it is used by some rooms,
+             * and the half-edges of a node keep the order of the walls.
+             * 
+             * @param _house The house
+             * @param _room_ids The ids of rooms
+             * @param _graph Output the half-edge graph
+             * @param _workspace Reuse its buffers if it is not null
+             */
+            static bool buildHalfEdgeGraph(const house_type& _house
+                , const id_vector& _room_ids
+                , half_edge_graph& _graph
+                , workspace* _workspace = nullptr)
+            {
+                _graph.clear();
+                workspace bim_local_workspace;
+                workspace& bim_workspace = (_workspace != nullptr) ? *_workspace : bim_local_workspace;
+
+                /// collect the walls, and only keep the first one of the same walls
+                std::vector<std::pair<id_type, size_t>>& bim_walls_2_orders = bim_workspace.walls_2_orders;
+                bim_walls_2_orders.clear();
+                for (id_type bim_room_id : _room_ids)
+                {
+                    const typename house_type::room_map::const_iterator cit_found_room = _house.rooms.find(bim_room_id);
+                    if (cit_found_room == _house.rooms.cend()) continue;
+                    for (const id_type wall_id : cit_found_room->second.wall_ids)
+                    {
+                        bim_walls_2_orders.push_back(std::make_pair(wall_id, bim_walls_2_orders.size()));
+                    }
+                }
+                std::sort(bim_walls_2_orders.begin(), bim_walls_2_orders.end());
+                bim_walls_2_orders.erase(std::unique(bim_walls_2_orders.begin(), bim_walls_2_orders.end()
+                    , [](const std::pair<id_type, size_t>& _a, const std::pair<id_type, size_t>& _b) { return _a.first == _b.first; })
+                    , bim_walls_2_orders.end());
+                std::sort(bim_walls_2_orders.begin(), bim_walls_2_orders.end()
+                    , [](const std::pair<id_type, size_t>& _a, const std::pair<id_type, size_t>& _b) { return _a.second < _b.second; });
+                if (bim_walls_2_orders.empty())
+                {
+                    return false;
+                }
+
+                /// make the dense indices of nodes, they are sorted by the ids of nodes
+                std::vector<const wall_type*>& bim_walls = bim_workspace.walls;
+                bim_walls.clear();
+                bim_walls.reserve(bim_walls_2_orders.size());
+                _graph.node_ids.reserve(bim_walls_2_orders.size() * 2);
+                for (const std::pair<id_type, size_t>& bim_wall_2_order : bim_walls_2_orders)
+                {
+                    const typename house_type::wall_map::const_iterator cit_found_wall = _house.walls.find(bim_wall_2_order.first);
+                    if (cit_found_wall == _house.walls.cend())
+                    {
+                        throw std::invalid_argument("contains invalid wall!");
+                    }
+                    bim_walls.push_back(&cit_found_wall->second);
+                    _graph.node_ids.push_back(cit_found_wall->second.start_node_id);
+                    _graph.node_ids.push_back(cit_found_wall->second.end_node_id);
+                }
+                std::sort(_graph.node_ids.begin(), _graph.node_ids.end());
+                _graph.node_ids.erase(std::unique(_graph.node_ids.begin(), _graph.node_ids.end()), _graph.node_ids.end());
+
+                const size_t bim_nodes_count = _graph.node_ids.size();
+                _graph.nodes.reserve(bim_nodes_count);
+                for (const id_type bim_node_id : _graph.node_ids)
+                {
+                    const typename house_type::node_map::const_iterator cit_found_node = _house.nodes.find(bim_node_id);
+                    if (cit_found_node == _house.nodes.cend())
+                    {
+                        throw std::invalid_argument("contains invalid node!");
+                    }
+                    _graph.nodes.push_back(cit_found_node->second);
+                }
+
+                /// count the half-edges of every node, and fill them by the order of walls
+                std::vector<size_t>& bim_wall_nodes = bim_workspace.wall_nodes;
+                bim_wall_nodes.clear();
+                bim_wall_nodes.reserve(bim_walls.size() * 2);
+                _graph.offsets.assign(bim_nodes_count + 1, 0);
+                for (const wall_type* bim_wall : bim_walls)
+                {
+                    const size_t bim_start_node_index = _graph.findNodeIndex(bim_wall->start_node_id);
+                    const size_t bim_end_node_index = _graph.findNodeIndex(bim_wall->end_node_id);
+                    bim_wall_nodes.push_back(bim_start_node_index);
+                    bim_wall_nodes.push_back(bim_end_node_index);
+                    ++_graph.offsets[bim_start_node_index + 1];
+                    ++_graph.offsets[bim_end_node_index + 1];
+                }
+                for (size_t i = 0; i < bim_nodes_count; ++i)
+                {
+                    _graph.offsets[i + 1] += _graph.offsets[i];
+                }
+
+                const size_t bim_half_edges_count = _graph.offsets[bim_nodes_count];
+                std::vector<size_t>& bim_cursors = bim_workspace.cursors;
+                bim_cursors.assign(_graph.offsets.begin(), _graph.offsets.end() - 1);
+                _graph.targets.resize(bim_half_edges_count);
+                _graph.walls.resize(bim_half_edges_count);
+                _graph.twins.resize(bim_half_edges_count);
+                for (size_t i = 0, ic = bim_walls_2_orders.size(); i < ic; ++i)
+                {
+                    const id_type bim_wall_id = bim_walls_2_orders[i].first;
+                    const size_t bim_start_node_index = bim_wall_nodes[i * 2];
+                    const size_t bim_end_node_index = bim_wall_nodes[i * 2 + 1];
+                    const size_t bim_half_edge = bim_cursors[bim_start_node_index]++;
+                    const size_t bim_twin_half_edge = bim_cursors[bim_end_node_index]++;
+                    _graph.targets[bim_half_edge] = bim_end_node_index;
+                    _graph.walls[bim_half_edge] = wall_ex(bim_wall_id, false);
+                    _graph.twins[bim_half_edge] = bim_twin_half_edge;
+                    _graph.targets[bim_twin_half_edge] = bim_start_node_index;
+                    _graph.walls[bim_twin_half_edge] = wall_ex(bim_wall_id, true);
+                    _graph.twins[bim_twin_half_edge] = bim_half_edge;
+                }
+                _graph.resetUsed();
+                return true;
+            }
+
+            /*!
+             * Split a half-edge graph by its connected components.
+             * 
+             * Every component keeps the order of nodes and half-edges in `_graph`,
+             * so tracing a component gives the same room-exs as tracing them in `_graph`.
+             * The components are sorted by their first half-edges.
+             * 
+             * @param _graph The half-edge graph
+             * @param _components Output the half-edge graphs of the components
+             * @param _half_edges Output the indices in `_graph` of the half-edges of every component
+             */
+            static void splitHalfEdgeGraph(const half_edge_graph& _graph
+                , std::vector<half_edge_graph>& _components
+                , std::vector<std::vector<size_t>>& _half_edges)
+            {
+                _components.clear();
+                _half_edges.clear();
+
+                /// label the nodes by the components, the first node of a component decides its order
+                const size_t bim_nodes_count = _graph.nodeCount();
+                std::vector<size_t> bim_node_components(bim_nodes_count, bim_nodes_count);
+                std::vector<size_t> bim_node_locals(bim_nodes_count, 0);
+                std::vector<size_t> bim_stack;
+                size_t bim_components_count = 0;
+                for (size_t bim_node_index = 0; bim_node_index < bim_nodes_count; ++bim_node_index)
+                {
+                    if (bim_node_components[bim_node_index] != bim_nodes_count) continue;
+                    bim_node_components[bim_node_index] = bim_components_count;
+                    bim_stack.push_back(bim_node_index);
+                    while (!bim_stack.empty())
+                    {
+                        const size_t bim_top = bim_stack.back();
+                        bim_stack.pop_back();
+                        for (size_t i = _graph.offsets[bim_top], ic = _graph.offsets[bim_top + 1]; i < ic; ++i)
+                        {
+                            const size_t bim_target = _graph.targets[i];
+                            if (bim_node_components[bim_target] != bim_nodes_count) continue;
+                            bim_node_components[bim_target] = bim_components_count;
+                            bim_stack.push_back(bim_target);
+                        }
+                    }
+                    ++bim_components_count;
+                }
+
+                _components.resize(bim_components_count);
+                _half_edges.resize(bim_components_count);
+                for (size_t bim_node_index = 0; bim_node_index < bim_nodes_count; ++bim_node_index)
+                {
+                    half_edge_graph& bim_component = _components[bim_node_components[bim_node_index]];
+                    std::vector<size_t>& bim_half_edges = _half_edges[bim_node_components[bim_node_index]];
+                    bim_node_locals[bim_node_index] = bim_component.node_ids.size();
+                    bim_component.node_ids.push_back(_graph.node_ids[bim_node_index]);
+                    bim_component.nodes.push_back(_graph.nodes[bim_node_index]);
+                    if (bim_component.offsets.empty())
+                    {
+                        bim_component.offsets.push_back(0);
+                    }
+                    for (size_t i = _graph.offsets[bim_node_index], ic = _graph.offsets[bim_node_index + 1]; i < ic; ++i)
+                    {
+                        bim_half_edges.push_back(i);
+                    }
+                    bim_component.offsets.push_back(bim_half_edges.size());
+                }
+
+                /// map the half-edges into the components
+                std::vector<size_t> bim_half_edge_locals(_graph.halfEdgeCount(), 0);
+                for (const std::vector<size_t>& bim_half_edges : _half_edges)
+                {
+                    for (size_t i = 0, ic = bim_half_edges.size(); i < ic; ++i)
+                    {
+                        bim_half_edge_locals[bim_half_edges[i]] = i;
+                    }
+                }
+                for (size_t c = 0; c < bim_components_count; ++c)
+                {
+                    half_edge_graph& bim_component = _components[c];
+                    const std::vector<size_t>& bim_half_edges = _half_edges[c];
+                    const size_t bim_half_edges_count = bim_half_edges.size();
+                    bim_component.targets.resize(bim_half_edges_count);
+                    bim_component.walls.resize(bim_half_edges_count);
+                    bim_component.twins.resize(bim_half_edges_count);
+                    if (!_graph.rotations.empty())
+                    {
+                        bim_component.rotations.resize(bim_half_edges_count);
+                        bim_component.nexts.resize(bim_half_edges_count);
+                    }
+                    bim_component.resetUsed();
+                    for (size_t i = 0; i < bim_half_edges_count; ++i)
+                    {
+                        const size_t bim_half_edge = bim_half_edges[i];
+                        bim_component.targets[i] = bim_node_locals[_graph.targets[bim_half_edge]];
+                        bim_component.walls[i] = _graph.walls[bim_half_edge];
+                        bim_component.twins[i] = bim_half_edge_locals[_graph.twins[bim_half_edge]];
+                        if (!_graph.rotations.empty())
+                        {
+                            bim_component.rotations[i] = bim_half_edge_locals[_graph.rotations[bim_half_edge]];
+                            bim_component.nexts[i] = bim_half_edge_locals[_graph.nexts[bim_half_edge]];
+                        }
+                        if (_graph.isUsed(bim_half_edge))
+                        {
+                            bim_component.setUsed(i);
+                        }
+                    }
+                }
+            }
+
+            /*!
+             * Is the direction \f$ \vec{A} \f$ before the direction \f$ \vec{B} \f$ when turning counterclockwise from the x-axis?
+             * 
+             * It only uses the half-plane and the sign of the cross product, so it doesn't need `sqrt` or `atan2`.
+             * The directions are compared exactly, but they may have been rounded when they were made from points,
+             * so compare the points by `predicates::isLessAngle` instead.
+             * 
+             * @param _a The direction \f$ \vec{A} \f$, it must not be zero
+             * @param _b The direction \f$ \vec{B} \f$, it must not be zero
+             */
+            static bool isLessAngle(const point_type& _a, const point_type& _b)
+            {
+                return predicates::isLessAngle(TConstant::zero_point, _a, _b);
+            }
+
+            /*!
+             * Sort the half-edges of every node by angle once, and link every half-edge to its next one.
+             * 
+             * The next half-edge of \f$ \vec{UV} \f$ is the first one before \f$ \vec{VU} \f$ in the counterclockwise order of \f$ {V} \f$,
+             * it is same as the one with the biggest `sin-angle-ex` which is chosen by `computeRoomExs`.
+             * The half-edges in the same direction keep the order of walls, so none of them are dropped.
+             * The directions are compared by the exact `predicates`, so the order is same for nearly collinear walls.
+             * 
+             * @param _graph The half-edge graph
+             * @param _workspace Add the comparisons of directions to its statistics if it is not null, see `room_ex_stats`
+             */
+            static void buildRotationSystem(half_edge_graph& _graph, workspace* _workspace = nullptr)
+            {
+                (void)_workspace;
+                BIMPP_PLAN2D_STATS_ONLY(size_t bim_comparisons = 0;)
+                const size_t bim_half_edges_count = _graph.halfEdgeCount();
+                _graph.rotations.resize(bim_half_edges_count);
+                _graph.nexts.resize(bim_half_edges_count);
+                for (size_t bim_node_index = 0, ic = _graph.nodeCount(); bim_node_index < ic; ++bim_node_index)
+                {
+                    const size_t bim_begin = _graph.offsets[bim_node_index];
+                    const size_t bim_end = _graph.offsets[bim_node_index + 1];
+                    const point_type& bim_node_point = _graph.nodes[bim_node_index].p();
+                    for (size_t i = bim_begin; i < bim_end; ++i)
+                    {
+                        _graph.rotations[i] = i;
+                    }
+                    std::sort(_graph.rotations.begin() + bim_begin, _graph.rotations.begin() + bim_end
+                        , [&](size_t _a, size_t _b)
+                        {
+                            BIMPP_PLAN2D_STATS_ONLY(++bim_comparisons;)
+                            const point_type& bim_point_a = _graph.nodes[_graph.targets[_a]].p();
+                            const point_type& bim_point_b = _graph.nodes[_graph.targets[_b]].p();
+                            if (predicates::isLessAngle(bim_node_point, bim_point_a, bim_point_b)) return true;
+                            if (predicates::isLessAngle(bim_node_point, bim_point_b, bim_point_a)) return false;
+                            return _a < _b;
+                        });
+                    /// the walls in the same direction are sorted by their orders, so the first one of them is the last one when turning clockwise
+                    for (size_t i = bim_begin; i < bim_end; ++i)
+                    {
+                        size_t bim_prev = (i == bim_begin ? bim_end : i) - 1;
+                        _graph.nexts[_graph.twins[_graph.rotations[i]]] = _graph.rotations[bim_prev];
+                    }
+                }
+                BIMPP_PLAN2D_STATS_ONLY(if (_workspace != nullptr) _workspace->stats.angle_evaluations += bim_comparisons;)
+            }
+
+            /*!
+             * Mark all repeated walls of a room-ex, and decide whether the room-ex is inside or outside.
+             * 
+             * @param _house The house
+             * @param _room_ex The room-ex, it must be closed
+             */
+            static void computeRoomExSide(const house_type& _house, room_ex& _room_ex)
+            {
+                id_vector bim_wall_ids;
+                computeRoomExSide(_house, _room_ex, bim_wall_ids);
+            }
+
+            /*!
+             * Mark all repeated walls of a room-ex, and decide whether the room-ex is inside or outside.
+             * 
+             * @param _house The house
+             * @param _room_ex The room-ex, it must be closed
+             * @param _wall_ids The buffer of the sorted ids of walls, it can be reused by every room-ex
+             */
+            static void computeRoomExSide(const house_type& _house, room_ex& _room_ex, id_vector& _wall_ids)
+            {
+                /// mark all repeated walls
+                _wall_ids.clear();
+                for (const wall_ex& bim_wall_ex : _room_ex.walls)
+                {
+                    _wall_ids.push_back(bim_wall_ex.id);
+                }
+                std::sort(_wall_ids.begin(), _wall_ids.end());
+                for (wall_ex& bim_wall_ex : _room_ex.walls)
+                {
+                    typename id_vector::const_iterator cit_found = std::lower_bound(_wall_ids.cbegin(), _wall_ids.cend(), bim_wall_ex.id);
+                    bim_wall_ex.repeated = ((cit_found + 1) != _wall_ids.cend() && *(cit_found + 1) == bim_wall_ex.id);
+                }
+
+                computeRoomExSideBy(_room_ex
+                    , [&_house, &_room_ex](size_t _index)
+                    {
+                        const wall_type& bim_wall = _house.walls.find(_room_ex.walls[_index].id)->second;
+                        return std::make_pair(bim_wall.start_node_id, bim_wall.end_node_id);
+                    }
+                    , [&_house](id_type _node_id) -> const node_type& { return _house.nodes.find(_node_id)->second; });
+            }
+
+            /*!
+             * Mark all repeated walls of a room-ex, and decide whether the room-ex is inside or outside.
+             * 
+             * It is same as the other `computeRoomExSide`, but it reads the nodes from the half-edge graph.
+             * 
+             * @param _graph The half-edge graph
+             * @param _half_edges The half-edges of the room-ex, they are in the same order as its walls
+             * @param _faces The room-ex index of every half-edge, the half-edges of this room-ex must be set
+             * @param _room_ex The room-ex, it must be closed
+             */
+            static void computeRoomExSide(const half_edge_graph& _graph
+                , const std::vector<size_t>& _half_edges
+                , const std::vector<size_t>& _faces
+                , room_ex& _room_ex)
+            {
+                /// a wall is repeated if both of its half-edges are in this room-ex
+                for (size_t i = 0, ic = _half_edges.size(); i < ic; ++i)
+                {
+                    const size_t bim_half_edge = _half_edges[i];
+                    _room_ex.walls[i].repeated = (_faces[_graph.twins[bim_half_edge]] == _faces[bim_half_edge]);
+                }
+                computeRoomExSideBy(_room_ex
+                    , [&_graph, &_half_edges](size_t _index)
+                    {
+                        return std::make_pair(_graph.wallStartNodeIndex(_half_edges[_index]), _graph.wallEndNodeIndex(_half_edges[_index]));
+                    }
+                    , [&_graph](size_t _node_index) -> const node_type& { return _graph.nodes[_node_index]; });
+            }
+
+            /*!
+             * Decide whether the room-ex is inside or outside, its repeated walls must be marked.
+             * 
+             * @param _room_ex The room-ex, it must be closed
+             * @param _wall_nodes Get the indices of the start node and the end node of a wall by its index in the room-ex
+             * @param _node_point Get the node by its index
+             */
+            template<typename TWallNodes, typename TNodePoint>
+            static void computeRoomExSideBy(room_ex& _room_ex
+                , const TWallNodes& _wall_nodes
+                , const TNodePoint& _node_point)
+            {
+                const size_t bim_walls_count = _room_ex.walls.size();
+
+                /// find the most left node from all unrepeated walls
+                size_t bim_wall_ex_index = bim_walls_count;
+                for (size_t i = 0; i < bim_walls_count; ++i)
+                {
+                    if (_room_ex.walls[i].repeated) continue;
+                    if (bim_wall_ex_index == bim_walls_count
+                        || _node_point(_wall_nodes(i).first).p() < _node_point(_wall_nodes(bim_wall_ex_index).first).p())
+                    {
+                        bim_wall_ex_index = i;
+                    }
+                }
+                if (bim_wall_ex_index == bim_walls_count)
+                {
+                    return;
+                }
+
+                const size_t bim_start_index = bim_wall_ex_index;
+                const bool bim_start_inversed = _room_ex.walls[bim_start_index].inversed;
+                do
+                {
+                    bim_wall_ex_index = (bim_wall_ex_index + (bim_start_inversed ? 1 : bim_walls_count - 1)) % bim_walls_count;
+                } while (bim_wall_ex_index != bim_start_index && _room_ex.walls[bim_wall_ex_index].repeated);
+                if (bim_wall_ex_index == bim_start_index)
+                {
+                    return;
+                }
+
+                const std::pair<size_t, size_t> bim_start_wall_nodes = _wall_nodes(bim_start_index);
+                const std::pair<size_t, size_t> bim_next_wall_nodes = _wall_nodes(bim_wall_ex_index);
+                const node_type& bim_left_node = _node_point(bim_start_wall_nodes.first);
+                const node_type& bim_start_node = _node_point(bim_start_wall_nodes.second);
+                const node_type& bim_next_node = _node_point(bim_start_wall_nodes.first == bim_next_wall_nodes.second
+                    ? bim_next_wall_nodes.first : bim_next_wall_nodes.second);
+                /// same as the `cos-angle-ex` is 0, not bigger than 2 or bigger, but decided by the exact orientation
+                const point_type& bim_point_a = (bim_start_inversed ? bim_next_node : bim_start_node).p();
+                const point_type& bim_point_b = (bim_start_inversed ? bim_start_node : bim_next_node).p();
+                const int bim_orientation = predicates::orientation(bim_left_node.p(), bim_point_a, bim_point_b);
+                if (bim_orientation == 0)
+                {
+                    _room_ex.side = predicates::isSameDirection(bim_left_node.p(), bim_point_a, bim_point_b) ? room_side_both : room_side_in;
+                }
+                else
+                {
+                    _room_ex.side = (bim_orientation > 0) ? room_side_in : room_side_out;
+                }
+            }
+
+            /*!
+             * Extract all room's edges from a half-edge graph, every half-edge is walked exactly once.
+             * 
+             * The room-exs and their walls are in the same order as `computeRoomExs`,
+             * it costs \f$ O(E \log d) \f$ with `buildRotationSystem`, and \f$ O(E) \f$ after it.
+             * 
+             * @param _graph The half-edge graph, `buildRotationSystem` must be called before
+             * @param _room_exs Output the room's edge list
+             * @param _room_id The id of all room-exs
+             * @param _first_half_edges Output the first half-edge of every room-ex if it is not null
+             * @param _workspace Reuse its buffers if it is not null
+             */
+            static bool extractRoomExs(const half_edge_graph& _graph
+                , room_ex_vector& _room_exs
+                , id_type _room_id = TConstant::none_id
+                , std::vector<size_t>* _first_half_edges = nullptr
+                , workspace* _workspace = nullptr)
+            {
+                if (_first_half_edges != nullptr)
+                {
+                    _first_half_edges->clear();
+                }
+                workspace bim_local_workspace;
+                workspace& bim_workspace = (_workspace != nullptr) ? *_workspace : bim_local_workspace;
+
+                const size_t bim_half_edges_count = _graph.halfEdgeCount();
+                /// the half-edges are stored by the ids of their start nodes,
+                /// so the first unused one is where `computeRoomExs` starts the next room-ex.
+                std::vector<size_t>& bim_faces = bim_workspace.faces;
+                bim_faces.assign(bim_half_edges_count, bim_half_edges_count);
+                std::vector<size_t>& bim_half_edges = bim_workspace.half_edges;
+                size_t bim_room_exs_count = 0;
+                for (size_t bim_first_half_edge = 0; bim_first_half_edge < bim_half_edges_count; ++bim_first_half_edge)
+                {
+                    if (bim_faces[bim_first_half_edge] != bim_half_edges_count) continue;
+
+                    const size_t bim_face = bim_room_exs_count;
+                    if (_first_half_edges != nullptr)
+                    {
+                        _first_half_edges->push_back(bim_first_half_edge);
+                    }
+                    room_ex& bim_room_ex = reuseRoomEx(_room_exs, bim_room_exs_count++, bim_workspace);
+                    bim_room_ex.id = _room_id;
+                    bim_half_edges.clear();
+                    size_t bim_half_edge = bim_first_half_edge;
+                    do
+                    {
+                        bim_half_edge = _graph.nexts[bim_half_edge];
+                        bim_faces[bim_half_edge] = bim_face;
+                        bim_half_edges.push_back(bim_half_edge);
+                        bim_room_ex.walls.push_back(_graph.walls[bim_half_edge]);
+                    } while (bim_half_edge != bim_first_half_edge);
+
+                    BIMPP_PLAN2D_STATS_ONLY(bim_workspace.stats.trace_steps += bim_half_edges.size();)
+                    BIMPP_PLAN2D_STATS_ONLY(const std::uint64_t bim_side_start = room_ex_stats::now();)
+                    computeRoomExSide(_graph, bim_half_edges, bim_faces, bim_room_ex);
+                    BIMPP_PLAN2D_STATS_ONLY(addFaceStats(bim_room_ex, bim_side_start, bim_workspace.stats);)
+                }
+                truncateRoomExs(_room_exs, bim_room_exs_count, bim_workspace);
+                return !_room_exs.empty();
+            }
+
+            /*!
+             * Trace all room's edges in a half-edge graph step by step, see `trace_mode_angle` and `trace_mode_rotation`.
+             * 
+             * @param _house The house
+             * @param _graph The half-edge graph, all half-edges are marked as used after tracing
+             * @param _room_exs Output the room's edge list
+             * @param _room_id The id of all room-exs
+             * @param _mode How to choose the next wall, `buildRotationSystem` must be called before if it is `trace_mode_rotation`
+             * @param _first_half_edges Output the first half-edge of every room-ex if it is not null
+             * @param _workspace Reuse its buffers if it is not null
+             */
+            static void traceRoomExs(const house_type& _house
+                , half_edge_graph& _graph
+                , room_ex_vector& _room_exs
+                , id_type _room_id
+                , trace_mode _mode
+                , std::vector<size_t>* _first_half_edges = nullptr
+                , workspace* _workspace = nullptr)
+            {
+                if (_first_half_edges != nullptr)
+                {
+                    _first_half_edges->clear();
+                }
+                workspace bim_local_workspace;
+                workspace& bim_workspace = (_workspace != nullptr) ? *_workspace : bim_local_workspace;
+                size_t bim_room_exs_count = 0;
+
+                /// Compute the path/edges of the room
+                const size_t bim_nodes_count = _graph.nodeCount();
+                while (true)
+                {
+                    /// start from the first node which has any unused half-edge
+                    size_t bim_first_half_edge = _graph.halfEdgeCount();
+                    size_t bim_start_node_index = 0;
+                    for (; bim_start_node_index < bim_nodes_count; ++bim_start_node_index)
+                    {
+                        bim_first_half_edge = _graph.findUnusedHalfEdge(bim_start_node_index);
+                        if (bim_first_half_edge != _graph.halfEdgeCount()) break;
+                    }
+                    if (bim_start_node_index == bim_nodes_count)
+                    {
+                        break;
+                    }
+
+                    /// the room-ex is traced in place, and it is dropped if the path isn't closed
+                    room_ex& bim_room_ex = reuseRoomEx(_room_exs, bim_room_exs_count, bim_workspace);
+                    bim_room_ex.id  = _room_id;
+                    bool bim_path_is_closed     = false;
+
+                    size_t bim_last_node_index = bim_start_node_index;
+                    size_t bim_last_half_edge = bim_first_half_edge;
+                    bim_start_node_index = _graph.targets[bim_first_half_edge];
+                    while (true)
+                    {
+                        assert(bim_start_node_index != bim_last_node_index);
+                        if (bim_start_node_index == bim_last_node_index)
+                        {
+                            throw std::invalid_argument("contains invalid wall!");
+                        }
+
+                        size_t bim_next_half_edge = _graph.halfEdgeCount();
+                        if (_mode == trace_mode_rotation)
+                        {
+                            /// the next node has been sorted
+                            const size_t bim_half_edge = _graph.nexts[bim_last_half_edge];
+                            if (!_graph.isUsed(bim_half_edge))
+                            {
+                                bim_next_half_edge = bim_half_edge;
+                            }
+                        }
+                        else
+                        {
+                            /// choose the next node by the biggest `sin-angle-ex` exactly, the first one wins if they are same
+                            const point_type& bim_start_point = _graph.nodes[bim_start_node_index].p();
+                            const point_type& bim_last_point = _graph.nodes[bim_last_node_index].p();
+                            const point_type* bim_max_point = nullptr;
+                            for (size_t i = _graph.offsets[bim_start_node_index], ic = _graph.offsets[bim_start_node_index + 1]; i < ic; ++i)
+                            {
+                                if (_graph.isUsed(i)) continue;
+                                const point_type& bim_point = _graph.nodes[_graph.targets[i]].p();
+                                BIMPP_PLAN2D_STATS_ONLY(++bim_workspace.stats.angle_evaluations;)
+                                if (bim_max_point == nullptr
+                                    || predicates::isLessTurn(bim_start_point, bim_last_point, *bim_max_point, bim_point))
+                                {
+                                    bim_next_half_edge = i;
+                                    bim_max_point = &bim_point;
+                                }
+                            }
+                        }
+                        if (bim_next_half_edge == _graph.halfEdgeCount())
+                        {
+                            break;
+                        }
+
+                        _graph.setUsed(bim_next_half_edge);
+                        bim_room_ex.walls.push_back(_graph.walls[bim_next_half_edge]);
+                        BIMPP_PLAN2D_STATS_ONLY(++bim_workspace.stats.trace_steps;)
+
+                        if (bim_next_half_edge == bim_first_half_edge)
+                        {
+                            bim_path_is_closed = true;
+                            break;
+                        }
+
+                        bim_last_node_index = bim_start_node_index;
+                        bim_last_half_edge = bim_next_half_edge;
+                        bim_start_node_index = _graph.targets[bim_next_half_edge];
+                    }
+
+                    if (bim_path_is_closed)
+                    {
+                        BIMPP_PLAN2D_STATS_ONLY(const std::uint64_t bim_side_start = room_ex_stats::now();)
+                        computeRoomExSide(_house, bim_room_ex, bim_workspace.wall_ids);
+                        BIMPP_PLAN2D_STATS_ONLY(addFaceStats(bim_room_ex, bim_side_start, bim_workspace.stats);)
+                        ++bim_room_exs_count;
+                        if (_first_half_edges != nullptr)
+                        {
+                            _first_half_edges->push_back(bim_first_half_edge);
+                        }
+                    }
+                    else
+                    {
+                        BIMPP_PLAN2D_STATS_ONLY(++bim_workspace.stats.open_faces;)
+                        if (bim_room_ex.walls.empty())
+                        {
+                            /// nothing can be walked from the first half-edge, drop it to avoid tracing it forever
+                            _graph.setUsed(bim_first_half_edge);
+                        }
+                    }
+                }
+                truncateRoomExs(_room_exs, bim_room_exs_count, bim_workspace);
+            }
+
+            /*!
+             * Compute all room's edges by all walls, and don't use recursion.
+             * 
+             * @param _house The house
+             * @param _room_exs Output the room's edge list
+             * @param _room_id The special id of room, find all rooms if it is none
+             * @param _mode How to choose the next wall, see `trace_mode`
+             * @param _pool Trace the connected components of walls in parallel if it is not null,
+             *              the result is same as the serial one
+             * @param _workspace Reuse its buffers if it is not null, see `workspace`
+             * @param _stats Add the statistics to it if it is not null, see `room_ex_stats`
+             */
+            static bool computeRoomExs(const house_type& _house
+                , room_ex_vector& _room_exs
+                , id_type _room_id = TConstant::none_id
+                , trace_mode _mode = trace_mode_angle
+                , thread_pool* _pool = nullptr
+                , workspace* _workspace = nullptr
+                , room_ex_stats* _stats = nullptr)
+            {
+                (void)_stats;
+                workspace bim_local_workspace;
+                workspace& bim_workspace = (_workspace != nullptr) ? *_workspace : bim_local_workspace;
+                id_vector& bim_room_ids = bim_workspace.room_ids;
+                bim_room_ids.clear();
+                if (_room_id != TConstant::none_id)
+                {
+                    const typename house_type::room_map::const_iterator cit_found_room = _house.rooms.find(_room_id);
+                    if (cit_found_room == _house.rooms.cend())
+                    {
+                        return false;
+                    }
+                    bim_room_ids.push_back(_room_id);
+                }
+                else
+                {
+                    for (typename house_type::room_map::const_iterator cit = _house.rooms.cbegin(); cit != _house.rooms.cend(); ++cit)
+                    {
+                        bim_room_ids.push_back(cit->first);
+                    }
+                }
+
+                BIMPP_PLAN2D_STATS_ONLY(room_ex_stats& bim_stats = bim_workspace.stats;)
+                BIMPP_PLAN2D_STATS_ONLY(bim_stats.clear();)
+                BIMPP_PLAN2D_STATS_ONLY(std::uint64_t bim_phase_start = room_ex_stats::now();)
+
+                half_edge_graph& bim_graph = bim_workspace.graph;
+                if (!buildHalfEdgeGraph(_house, bim_room_ids, bim_graph, &bim_workspace))
+                {
+                    truncateRoomExs(_room_exs, 0, bim_workspace);
+                    BIMPP_PLAN2D_STATS_ONLY(bim_stats.build_ns = room_ex_stats::now() - bim_phase_start;)
+                    BIMPP_PLAN2D_STATS_ONLY(if (_stats != nullptr) *_stats += bim_stats;)
+                    return false;
+                }
+                BIMPP_PLAN2D_STATS_ONLY(bim_stats.nodes = bim_graph.nodeCount();)
+                BIMPP_PLAN2D_STATS_ONLY(bim_stats.half_edges = bim_graph.halfEdgeCount();)
+                BIMPP_PLAN2D_STATS_ONLY(bim_stats.build_ns = room_ex_stats::now() - bim_phase_start;)
+
+                if (_pool != nullptr && _pool->threadCount() > 1)
+                {
+                    traceRoomExsInParallel(_house, bim_graph, _room_exs, _room_id, _mode, *_pool, bim_workspace);
+                }
+                else
+                {
+                    traceRoomExsByMode(_house, bim_graph, _room_exs, _room_id, _mode, nullptr, &bim_workspace);
+                }
+
+                if (!TConstant::isValid(_room_id))
+                {
+                    BIMPP_PLAN2D_STATS_ONLY(bim_phase_start = room_ex_stats::now();)
+                    bim_workspace.room_index.build(_house, bim_workspace.walls_2_rooms);
+                    assignRoomExIds(bim_workspace.room_index, _room_exs, _pool, &bim_workspace);
+                    BIMPP_PLAN2D_STATS_ONLY(bim_stats.assign_ns = room_ex_stats::now() - bim_phase_start;)
+                }
+
+                BIMPP_PLAN2D_STATS_ONLY(if (_stats != nullptr) *_stats += bim_stats;)
+                return !_room_exs.empty();
+            }
+
+            /*!
+             * Find the id of room for every room-ex, the first room which contains all walls of a room-ex is chosen.
+             * 
+             * @param _house The house
+             * @param _room_exs The room's edge list
+             * @param _pool Find them in parallel if it is not null
+             */
+            static void assignRoomExIds(const house_type& _house
+                , room_ex_vector& _room_exs
+                , thread_pool* _pool = nullptr)
+            {
+                /// make sure the room id
+                const wall_room_index bim_index(_house);
+                assignRoomExIds(bim_index, _room_exs, _pool);
+            }
+
+            /*!
+             * Find the id of room for every room-ex by an index which is built before.
+             * 
+             * @param _index The index of the rooms of a house
+             * @param _room_exs The room's edge list
+             * @param _pool Find them in parallel if it is not null
+             * @param _workspace Reuse its buffers if it is not null, it is only used when they are found serially
+             */
+            static void assignRoomExIds(const wall_room_index& _index
+                , room_ex_vector& _room_exs
+                , thread_pool* _pool = nullptr
+                , workspace* _workspace = nullptr)
+            {
+                if (_pool == nullptr && _workspace != nullptr)
+                {
+                    for (room_ex& each_room_ex : _room_exs)
+                    {
+                        const id_type bim_room_id = _index.findRoomId(each_room_ex, _workspace->ranges);
+                        if (TConstant::isValid(bim_room_id))
+                        {
+                            each_room_ex.id = bim_room_id;
+                        }
+                    }
+                    return;
+                }
+
+                auto assign_room_ex_id = [&_room_exs, &_index](size_t _room_ex_index)
+                {
+                    room_ex& each_room_ex = _room_exs[_room_ex_index];
+                    const id_type bim_room_id = _index.findRoomId(each_room_ex);
+                    if (TConstant::isValid(bim_room_id))
+                    {
+                        each_room_ex.id = bim_room_id;
+                    }
+                };
+                if (_pool != nullptr)
+                {
+                    _pool->parallelFor(_room_exs.size(), assign_room_ex_id);
+                }
+                else
+                {
+                    for (size_t i = 0, ic = _room_exs.size(); i < ic; ++i)
+                    {
+                        assign_room_ex_id(i);
+                    }
+                }
+            }
+
+            /*!
+             * Compute the area, the perimeter, the centroid and the bounding box of every room-ex.
+             * 
+             * The points of all room-exs are gathered into flat arrays once, and the sums of their edges are computed by the SIMD kernels.
+             * The net area of a room-ex of `room_side_in` is the area of the polygon whose every edge is moved inside by the half thickness of its wall,
+             * the net area of the other room-exs is same as the area.
+             * 
+             * @param _house The house
+             * @param _room_exs The room's edge list
+             * @param _metrics Output the metrics of every room-ex by the same order
+             * @param _pool Compute them in parallel if it is not null
+             */
+            static void computeRoomExMetrics(const house_type& _house
+                , const room_ex_vector& _room_exs
+                , room_ex_metrics_vector& _metrics
+                , thread_pool* _pool = nullptr)
+            {
+                _metrics.assign(_room_exs.size(), room_ex_metrics());
+
+                /// the polygon `i` is closed by its first point, and the net one may have 2 points at every corner
+                std::vector<size_t> bim_offsets(_room_exs.size() + 1, 0);
+                std::vector<size_t> bim_net_offsets(_room_exs.size() + 1, 0);
+                for (size_t i = 0, ic = _room_exs.size(); i < ic; ++i)
+                {
+                    const size_t bim_count = _room_exs[i].walls.size();
+                    bim_offsets[i + 1] = bim_offsets[i] + (bim_count == 0 ? 0 : bim_count + 1);
+                    bim_net_offsets[i + 1] = bim_net_offsets[i] + ((bim_count == 0 || _room_exs[i].side != room_side_in) ? 0 : bim_count * 2 + 1);
+                }
+                std::vector<precision_type> bim_xs(bim_offsets.back());
+                std::vector<precision_type> bim_ys(bim_offsets.back());
+                std::vector<precision_type> bim_half_thicknesses(bim_offsets.back());
+                std::vector<precision_type> bim_net_xs(bim_net_offsets.back());
+                std::vector<precision_type> bim_net_ys(bim_net_offsets.back());
+
+                auto compute_metrics = [&](size_t _index)
+                {
+                    const room_ex& bim_room_ex = _room_exs[_index];
+                    const size_t bim_count = bim_room_ex.walls.size();
+                    if (bim_count == 0) return;
+                    room_ex_metrics& bim_metrics = _metrics[_index];
+                    precision_type* bim_room_xs = &bim_xs[bim_offsets[_index]];
+                    precision_type* bim_room_ys = &bim_ys[bim_offsets[_index]];
+                    precision_type* bim_room_half_thicknesses = &bim_half_thicknesses[bim_offsets[_index]];
+
+                    /// the points are relative to the first one to keep the precision of the sums
+                    point_type bim_origin;
+                    for (size_t i = 0; i < bim_count; ++i)
+                    {
+                        const wall_ex& bim_wall_ex = bim_room_ex.walls[i];
+                        const typename house_type::wall_map::const_iterator cit_found_wall = _house.walls.find(bim_wall_ex.id);
+                        if (cit_found_wall == _house.walls.cend())
+                        {
+                            throw std::invalid_argument("contains invalid wall!");
+                        }
+                        const id_type bim_node_id = bim_wall_ex.inversed ? cit_found_wall->second.end_node_id : cit_found_wall->second.start_node_id;
+                        const typename house_type::node_map::const_iterator cit_found_node = _house.nodes.find(bim_node_id);
+                        if (cit_found_node == _house.nodes.cend())
+                        {
+                            throw std::invalid_argument("contains invalid node!");
+                        }
+                        const point_type& bim_point = cit_found_node->second.p();
+                        if (i == 0)
+                        {
+                            bim_origin = bim_point;
+                            bim_metrics.min = bim_point;
+                            bim_metrics.max = bim_point;
+                        }
+                        bim_metrics.min = point_type(std::min(bim_metrics.min.x(), bim_point.x()), std::min(bim_metrics.min.y(), bim_point.y()));
+                        bim_metrics.max = point_type(std::max(bim_metrics.max.x(), bim_point.x()), std::max(bim_metrics.max.y(), bim_point.y()));
+                        bim_room_xs[i] = bim_point.x() - bim_origin.x();
+                        bim_room_ys[i] = bim_point.y() - bim_origin.y();
+                        bim_room_half_thicknesses[i] = cit_found_wall->second.thickness / 2;
+                    }
+                    bim_room_xs[bim_count] = bim_room_xs[0];
+                    bim_room_ys[bim_count] = bim_room_ys[0];
+
+                    precision_type bim_sums[4] = { 0, 0, 0, 0 };
+                    calculatePolygonSums(bim_room_xs, bim_room_ys, bim_count, bim_sums);
+                    const precision_type bim_area_2 = bim_sums[0];
+                    bim_metrics.area = std::abs(bim_area_2) / 2;
+                    bim_metrics.net_area = bim_metrics.area;
+                    bim_metrics.perimeter = bim_sums[3];
+                    if (std::abs(bim_area_2) > std::numeric_limits<precision_type>::epsilon() * bim_sums[3] * bim_sums[3])
+                    {
+                        bim_metrics.centroid = point_type(bim_origin.x() + bim_sums[1] / (bim_area_2 * 3), bim_origin.y() + bim_sums[2] / (bim_area_2 * 3));
+                    }
+                    else
+                    {
+                        /// the polygon has no area, use the average of its points
+                        precision_type bim_sum_x = 0;
+                        precision_type bim_sum_y = 0;
+                        for (size_t i = 0; i < bim_count; ++i)
+                        {
+                            bim_sum_x += bim_room_xs[i];
+                            bim_sum_y += bim_room_ys[i];
+                        }
+                        bim_metrics.centroid = point_type(bim_origin.x() + bim_sum_x / bim_count, bim_origin.y() + bim_sum_y / bim_count);
+                        return;
+                    }
+                    if (bim_room_ex.side != room_side_in) return;
+
+                    /// move every edge inside along its normal, and put every corner at the intersection of the moved edges
+                    const precision_type bim_inside = (bim_area_2 > 0) ? 1 : -1;
+                    precision_type* bim_room_net_xs = &bim_net_xs[bim_net_offsets[_index]];
+                    precision_type* bim_room_net_ys = &bim_net_ys[bim_net_offsets[_index]];
+                    size_t bim_net_count = 0;
+                    for (size_t i = 0; i < bim_count; ++i)
+                    {
+                        const size_t bim_previous = (i == 0) ? bim_count - 1 : i - 1;
+                        point_type bim_previous_line(bim_room_xs[i] - bim_room_xs[bim_previous], bim_room_ys[i] - bim_room_ys[bim_previous]);
+                        point_type bim_line(bim_room_xs[i + 1] - bim_room_xs[i], bim_room_ys[i + 1] - bim_room_ys[i]);
+                        bim_previous_line.normalize();
+                        bim_line.normalize();
+                        const precision_type bim_previous_nx = -bim_previous_line.y() * bim_inside;
+                        const precision_type bim_previous_ny = bim_previous_line.x() * bim_inside;
+                        const precision_type bim_nx = -bim_line.y() * bim_inside;
+                        const precision_type bim_ny = bim_line.x() * bim_inside;
+                        const precision_type bim_previous_offset = bim_room_half_thicknesses[bim_previous];
+                        const precision_type bim_offset = bim_room_half_thicknesses[i];
+                        const precision_type bim_det = bim_previous_nx * bim_ny - bim_previous_ny * bim_nx;
+                        const precision_type bim_max_offset = std::max(bim_previous_offset, bim_offset);
+                        precision_type bim_dx = 0;
+                        precision_type bim_dy = 0;
+                        if (std::abs(bim_det) > 1e-9)
+                        {
+                            bim_dx = (bim_previous_offset * bim_ny - bim_previous_ny * bim_offset) / bim_det;
+                            bim_dy = (bim_previous_nx * bim_offset - bim_previous_offset * bim_nx) / bim_det;
+                        }
+                        if (std::abs(bim_det) > 1e-9 && bim_dx * bim_dx + bim_dy * bim_dy <= bim_max_offset * bim_max_offset * 16)
+                        {
+                            bim_room_net_xs[bim_net_count] = bim_room_xs[i] + bim_dx;
+                            bim_room_net_ys[bim_net_count] = bim_room_ys[i] + bim_dy;
+                            ++bim_net_count;
+                        }
+                        else
+                        {
+                            /// the edges are almost parallel, or they are the two sides of a wall which ends here, cut the corner
+                            bim_room_net_xs[bim_net_count] = bim_room_xs[i] + bim_previous_nx * bim_previous_offset;
+                            bim_room_net_ys[bim_net_count] = bim_room_ys[i] + bim_previous_ny * bim_previous_offset;
+                            ++bim_net_count;
+                            bim_room_net_xs[bim_net_count] = bim_room_xs[i] + bim_nx * bim_offset;
+                            bim_room_net_ys[bim_net_count] = bim_room_ys[i] + bim_ny * bim_offset;
+                            ++bim_net_count;
+                        }
+                    }
+                    bim_room_net_xs[bim_net_count] = bim_room_net_xs[0];
+                    bim_room_net_ys[bim_net_count] = bim_room_net_ys[0];
+                    precision_type bim_net_sums[4] = { 0, 0, 0, 0 };
+                    calculatePolygonSums(bim_room_net_xs, bim_room_net_ys, bim_net_count, bim_net_sums);
+                    bim_metrics.net_area = std::max(bim_net_sums[0] * bim_inside / 2, static_cast<precision_type>(0));
+                };
+                if (_pool != nullptr)
+                {
+                    _pool->parallelFor(_room_exs.size(), compute_metrics);
+                }
+                else
+                {
+                    for (size_t i = 0, ic = _room_exs.size(); i < ic; ++i)
+                    {
+                        compute_metrics(i);
+                    }
+                }
+            }
+
+            /*!
+             * Build the containment tree of the room-exs, see `room_ex_hierarchy`.
+             * 
+             * The room-exs which share walls are the faces of the same connected walls, and the first one which isn't `room_side_in` is their outer boundary.
+             * Only the outer boundaries are located: the room-exs of `room_side_in` are kept in a `box_tree`,
+             * and a point of every outer boundary is tested by the exact `predicates` only in the ones whose boxes contain it,
+             * so it costs \f$ O(n \log n) \f$ unless the room-exs are deeply nested.
+             * The walls must not cross or touch each other without a node, see `nodeWalls` and `snapNodes`.
+             * 
+             * @param _house The house
+             * @param _room_exs The room's edge list, it is usually all room-exs of a house which are computed by `computeRoomExs`
+             * @param _hierarchy Output the containment tree
+             * @param _pool Locate the outer boundaries in parallel if it is not null
+             */
+            static void computeRoomExHierarchy(const house_type& _house
+                , const room_ex_vector& _room_exs
+                , room_ex_hierarchy& _hierarchy
+                , thread_pool* _pool = nullptr)
+            {
+                const size_t bim_room_exs_count = _room_exs.size();
+                const size_t bim_none_index = room_ex_hierarchy::none_index;
+                _hierarchy.clear();
+                _hierarchy.parents.assign(bim_room_exs_count, bim_none_index);
+
+                /// join the room-exs which share walls by a union-find
+                std::vector<std::pair<id_type, size_t>> bim_walls_2_room_exs;
+                for (size_t i = 0; i < bim_room_exs_count; ++i)
+                {
+                    for (const wall_ex& each_wall_ex : _room_exs[i].walls)
+                    {
+                        bim_walls_2_room_exs.push_back(std::make_pair(each_wall_ex.id, i));
+                    }
+                }
+                std::sort(bim_walls_2_room_exs.begin(), bim_walls_2_room_exs.end());
+                std::vector<size_t> bim_groups(bim_room_exs_count);
+                for (size_t i = 0; i < bim_room_exs_count; ++i)
+                {
+                    bim_groups[i] = i;
+                }
+                auto find_group = [&bim_groups](size_t _index)
+                {
+                    while (bim_groups[_index] != _index)
+                    {
+                        bim_groups[_index] = bim_groups[bim_groups[_index]];
+                        _index = bim_groups[_index];
+                    }
+                    return _index;
+                };
+                for (size_t i = 1, ic = bim_walls_2_room_exs.size(); i < ic; ++i)
+                {
+                    if (bim_walls_2_room_exs[i].first != bim_walls_2_room_exs[i - 1].first) continue;
+                    const size_t bim_a = find_group(bim_walls_2_room_exs[i - 1].second);
+                    const size_t bim_b = find_group(bim_walls_2_room_exs[i].second);
+                    bim_groups[std::max(bim_a, bim_b)] = std::min(bim_a, bim_b);
+                }
+                for (size_t i = 0; i < bim_room_exs_count; ++i)
+                {
+                    bim_groups[i] = find_group(i);
+                }
+
+                /// the room-exs of `room_side_in` are inside the outer boundary of their group
+                std::vector<size_t> bim_outers(bim_room_exs_count, bim_none_index);
+                for (size_t i = 0; i < bim_room_exs_count; ++i)
+                {
+                    if (_room_exs[i].walls.empty() || _room_exs[i].side == room_side_in) continue;
+                    if (bim_outers[bim_groups[i]] == bim_none_index)
+                    {
+                        bim_outers[bim_groups[i]] = i;
+                    }
+                }
+                for (size_t i = 0; i < bim_room_exs_count; ++i)
+                {
+                    if (_room_exs[i].walls.empty() || _room_exs[i].side != room_side_in) continue;
+                    _hierarchy.parents[i] = bim_outers[bim_groups[i]];
+                }
+
+                /// gather the polygons of the room-exs of `room_side_in`, which may contain the others
+                std::vector<size_t> bim_inners;
+                std::vector<size_t> bim_offsets(1, 0);
+                for (size_t i = 0; i < bim_room_exs_count; ++i)
+                {
+                    if (_room_exs[i].walls.empty() || _room_exs[i].side != room_side_in) continue;
+                    bim_inners.push_back(i);
+                    bim_offsets.push_back(bim_offsets.back() + _room_exs[i].walls.size());
+                }
+                std::vector<point_type> bim_points(bim_offsets.back());
+                std::vector<precision_type> bim_areas(bim_inners.size());
+                std::vector<precision_type> bim_boxes(bim_inners.size() * 4);
+                auto gather_polygon = [&](size_t _index)
+                {
+                    bim_areas[_index] = gatherRoomExPolygon(_house, _room_exs[bim_inners[_index]], &bim_points[bim_offsets[_index]], &bim_boxes[_index * 4]);
+                };
+                box_tree<precision_type> bim_tree;
+                if (_pool != nullptr)
+                {
+                    _pool->parallelFor(bim_inners.size(), gather_polygon);
+                }
+                else
+                {
+                    for (size_t i = 0, ic = bim_inners.size(); i < ic; ++i)
+                    {
+                        gather_polygon(i);
+                    }
+                }
+                bim_tree.build(bim_boxes, _pool);
+
+                /// the boundaries of different groups don't touch, so any point of an outer boundary is inside or outside of the others
+                auto locate_room_ex = [&](size_t _index)
+                {
+                    const room_ex& bim_room_ex = _room_exs[_index];
+                    if (bim_room_ex.walls.empty() || _hierarchy.parents[_index] != bim_none_index) return;
+                    point_type bim_point;
+                    gatherRoomExPoints(_house, bim_room_ex, &bim_point, 1);
+                    size_t bim_found = bim_none_index;
+                    bim_tree.query(bim_point.x(), bim_point.y(), bim_point.x(), bim_point.y(), [&](size_t _inner)
+                    {
+                        if (bim_groups[bim_inners[_inner]] == bim_groups[_index]) return;
+                        if (bim_found != bim_none_index
+                            && (bim_areas[bim_found] < bim_areas[_inner] || (bim_areas[bim_found] == bim_areas[_inner] && bim_found < _inner))) return;
+                        if (isInPolygon(&bim_points[bim_offsets[_inner]], bim_offsets[_inner + 1] - bim_offsets[_inner], bim_point))
+                        {
+                            bim_found = _inner;
+                        }
+                    });
+                    if (bim_found != bim_none_index)
+                    {
+                        _hierarchy.parents[_index] = bim_inners[bim_found];
+                    }
+                };
+                if (_pool != nullptr)
+                {
+                    _pool->parallelFor(bim_room_exs_count, locate_room_ex);
+                }
+                else
+                {
+                    for (size_t i = 0; i < bim_room_exs_count; ++i)
+                    {
+                        locate_room_ex(i);
+                    }
+                }
+
+                /// the children are sorted by the order of room-exs
+                _hierarchy.offsets.assign(bim_room_exs_count + 1, 0);
+                for (size_t i = 0; i < bim_room_exs_count; ++i)
+                {
+                    if (_hierarchy.parents[i] == bim_none_index)
+                    {
+                        _hierarchy.roots.push_back(i);
+                        continue;
+                    }
+                    ++_hierarchy.offsets[_hierarchy.parents[i] + 1];
+                }
+                for (size_t i = 0; i < bim_room_exs_count; ++i)
+                {
+                    _hierarchy.offsets[i + 1] += _hierarchy.offsets[i];
+                }
+                _hierarchy.children.resize(_hierarchy.offsets.back());
+                std::vector<size_t> bim_cursors(_hierarchy.offsets.begin(), _hierarchy.offsets.end() - 1);
+                for (size_t i = 0; i < bim_room_exs_count; ++i)
+                {
+                    if (_hierarchy.parents[i] == bim_none_index) continue;
+                    _hierarchy.children[bim_cursors[_hierarchy.parents[i]]++] = i;
+                }
+            }
+
+            /*!
+             * Compute the room-exs of all houses in a project, every house is a task of the pool.
+             * 
+             * The results are sorted by the ids of sites, buildings and houses, and every task only writes its own result,
+             * so the houses are scheduled by the work-stealing of `thread_pool` without any lock.
+             * An exception of a house is kept in its result and doesn't stop the others.
+             * The room-exs of a house are computed once even if it is placed at many positions of its building,
+             * and the positions are kept in its result.
+             * 
+             * @param _project The project
+             * @param _results Output the room-exs of all houses
+             * @param _pool The thread pool
+             * @param _mode How to choose the next wall, see `trace_mode`
+             */
+            static bool computeProjectRoomExs(const project_type& _project
+                , house_room_ex_vector& _results
+                , thread_pool& _pool
+                , trace_mode _mode = trace_mode_face)
+            {
+                _results.clear();
+                std::vector<const house_type*> bim_houses;
+                for (typename project_type::site_map::const_iterator cit_site = _project.sites.cbegin(); cit_site != _project.sites.cend(); ++cit_site)
+                {
+                    const site_type& bim_site = cit_site->second;
+                    for (typename site_type::building_map::const_iterator cit_building = bim_site.buildings.cbegin(); cit_building != bim_site.buildings.cend(); ++cit_building)
+                    {
+                        const building_type& bim_building = cit_building->second;
+                        const size_t bim_first = _results.size();
+                        for (typename building_type::house_map::const_iterator cit_house = bim_building.houses.cbegin(); cit_house != bim_building.houses.cend(); ++cit_house)
+                        {
+                            _results.push_back(house_room_ex(cit_site->first, cit_building->first, cit_house->first));
+                            bim_houses.push_back(&cit_house->second);
+                        }
+                        for (typename building_type::potision_map::const_iterator cit_position = bim_building.positions.cbegin(); cit_position != bim_building.positions.cend(); ++cit_position)
+                        {
+                            const house_room_ex bim_key(cit_site->first, cit_building->first, cit_position->second);
+                            typename house_room_ex_vector::iterator it_found = std::lower_bound(_results.begin() + bim_first, _results.end(), bim_key);
+                            if (it_found != _results.end() && !(bim_key < *it_found))
+                            {
+                                it_found->positions.push_back(cit_position->first);
+                            }
+                        }
+                    }
+                }
+
+                _pool.parallelFor(_results.size(), [&_results, &bim_houses, _mode](size_t _index)
+                {
+                    house_room_ex& bim_result = _results[_index];
+                    try
+                    {
+                        bim_result.computed = computeRoomExs(*bim_houses[_index], bim_result.room_exs, TConstant::none_id, _mode);
+                    }
+                    catch (const std::exception& e)
+                    {
+                        bim_result.computed = false;
+                        bim_result.error = e.what();
+                        bim_result.room_exs.clear();
+                    }
+                });
+
+                for (const house_room_ex& bim_result : _results)
+                {
+                    if (!bim_result.computed) return false;
+                }
+                return true;
+            }
+
+            /*!
+             * Find the room-exs of a house from the results of `computeProjectRoomExs`, return `nullptr` if it is not found.
+             */
+            static const house_room_ex* findHouseRoomEx(const house_room_ex_vector& _results
+                , id_type _site_id, id_type _building_id, id_type _house_id)
+            {
+                const house_room_ex bim_key(_site_id, _building_id, _house_id);
+                typename house_room_ex_vector::const_iterator cit_found = std::lower_bound(_results.cbegin(), _results.cend(), bim_key);
+                if (cit_found == _results.cend() || bim_key < *cit_found)
+                {
+                    return nullptr;
+                }
+                return &*cit_found;
+            }
+
+            /*!
+             * Split the walls of a house at all of their intersections, so the walls only meet at their nodes.
+             * 
+             * The walls are put into a uniform grid, and only the walls in the same cell are tested,
+             * so it costs about \f$ O(n + k) \f$ for \f$ n \f$ walls with \f$ k \f$ intersections if the walls are not much longer than the others.
+             * A crossing adds a new node which is shared by both walls, and a node which lies on another wall (T-junction) splits that wall by itself,
+             * so the overlapped parts of collinear walls are split at the ends of each other too.
+             * A crossing reuses the node of a wall or an earlier crossing within `_tolerance`, so the walls crossing at one point share one node,
+             * and the split points of a wall closer than `_tolerance` are merged, so no piece is shorter than it.
+             * 
+             * A split wall keeps its id for its first piece and the other pieces get new ids, all of them copy its kind and thickness.
+             * The rooms use its pieces instead of it, but if an end of it is open in a room (no other wall of the room meets it there),
+             * the pieces from that end to the nearest node where another wall of the room meets it are not used by the room.
+             * Its holes are moved to the pieces which overlap them most, and clipped by the pieces, the distance of a hole stays positive.
+             * 
+             * @param _house The house
+             * @param _pieces Output all pieces of the split walls, sorted by the ids of their original walls and their distances
+             * @param _tolerance A node lies on a wall if their distance is not bigger than it
+             * @return The count of the split walls
+             */
+            static size_t nodeWalls(house_type& _house
+                , wall_piece_vector& _pieces
+                , precision_type _tolerance = static_cast<precision_type>(1e-9))
+            {
+                _pieces.clear();
+
+                /// collect the valid walls, the nodes of the wall `i` are `bim_points[i * 2]` and `bim_points[i * 2 + 1]`
+                id_vector bim_wall_ids;
+                id_vector bim_node_ids;
+                std::vector<point_type> bim_points;
+                id_type bim_next_wall_id = 0;
+                id_type bim_next_node_id = 0;
+                for (typename house_type::node_map::const_iterator cit = _house.nodes.cbegin(); cit != _house.nodes.cend(); ++cit)
+                {
+                    if (!TConstant::isValid(cit->first)) continue;
+                    bim_next_node_id = std::max(bim_next_node_id, static_cast<id_type>(cit->first + 1));
+                }
+                for (typename house_type::wall_map::const_iterator cit = _house.walls.cbegin(); cit != _house.walls.cend(); ++cit)
+                {
+                    if (TConstant::isValid(cit->first))
+                    {
+                        bim_next_wall_id = std::max(bim_next_wall_id, static_cast<id_type>(cit->first + 1));
+                    }
+                    const wall_type& bim_wall = cit->second;
+                    if (!bim_wall.isValid()) continue;
+                    const typename house_type::node_map::const_iterator cit_start_node = _house.nodes.find(bim_wall.start_node_id);
+                    const typename house_type::node_map::const_iterator cit_end_node = _house.nodes.find(bim_wall.end_node_id);
+                    if (cit_start_node == _house.nodes.cend() || cit_end_node == _house.nodes.cend())
+                    {
+                        throw std::invalid_argument("contains invalid node!");
+                    }
+                    bim_wall_ids.push_back(cit->first);
+                    bim_node_ids.push_back(bim_wall.start_node_id);
+                    bim_node_ids.push_back(bim_wall.end_node_id);
+                    bim_points.push_back(cit_start_node->second.p());
+                    bim_points.push_back(cit_end_node->second.p());
+                }
+                const size_t bim_walls_count = bim_wall_ids.size();
+                if (bim_walls_count < 2)
+                {
+                    return 0;
+                }
+
+                /// the cells are not smaller than the average wall, and there are at most about 12 cells for every wall
+                std::vector<precision_type> bim_boxes(bim_walls_count * 4);
+                precision_type bim_extents = 0;
+                for (size_t i = 0; i < bim_walls_count; ++i)
+                {
+                    const point_type& bim_a = bim_points[i * 2];
+                    const point_type& bim_b = bim_points[i * 2 + 1];
+                    bim_boxes[i * 4] = std::min(bim_a.x(), bim_b.x()) - _tolerance;
+                    bim_boxes[i * 4 + 1] = std::min(bim_a.y(), bim_b.y()) - _tolerance;
+                    bim_boxes[i * 4 + 2] = std::max(bim_a.x(), bim_b.x()) + _tolerance;
+                    bim_boxes[i * 4 + 3] = std::max(bim_a.y(), bim_b.y()) + _tolerance;
+                    bim_extents += std::max(bim_boxes[i * 4 + 2] - bim_boxes[i * 4], bim_boxes[i * 4 + 3] - bim_boxes[i * 4 + 1]);
+                }
+                precision_type bim_min_x = bim_boxes[0], bim_min_y = bim_boxes[1], bim_max_x = bim_boxes[2], bim_max_y = bim_boxes[3];
+                for (size_t i = 1; i < bim_walls_count; ++i)
+                {
+                    bim_min_x = std::min(bim_min_x, bim_boxes[i * 4]);
+                    bim_min_y = std::min(bim_min_y, bim_boxes[i * 4 + 1]);
+                    bim_max_x = std::max(bim_max_x, bim_boxes[i * 4 + 2]);
+                    bim_max_y = std::max(bim_max_y, bim_boxes[i * 4 + 3]);
+                }
+                const precision_type bim_width = bim_max_x - bim_min_x;
+                const precision_type bim_height = bim_max_y - bim_min_y;
+                const precision_type bim_count = static_cast<precision_type>(bim_walls_count);
+                precision_type bim_cell = std::max(bim_extents / bim_count
+                    , std::max(std::sqrt(bim_width * bim_height / (4 * bim_count)), std::max(bim_width, bim_height) / (4 * bim_count)));
+                if (!(bim_cell > 0))
+                {
+                    bim_cell = 1;
+                }
+                const size_t bim_cells_x = static_cast<size_t>(bim_width / bim_cell) + 1;
+                const size_t bim_cells_y = static_cast<size_t>(bim_height / bim_cell) + 1;
+                auto cell_x = [&](precision_type _x) { return std::min(bim_cells_x - 1, static_cast<size_t>(std::max(_x - bim_min_x, static_cast<precision_type>(0)) / bim_cell)); };
+                auto cell_y = [&](precision_type _y) { return std::min(bim_cells_y - 1, static_cast<size_t>(std::max(_y - bim_min_y, static_cast<precision_type>(0)) / bim_cell)); };
+
+                /// the walls of the cell `c` are `bim_cell_walls[bim_offsets[c], bim_offsets[c + 1])`
+                std::vector<size_t> bim_offsets(bim_cells_x * bim_cells_y + 1, 0);
+                for (size_t i = 0; i < bim_walls_count; ++i)
+                {
+                    for (size_t y = cell_y(bim_boxes[i * 4 + 1]), yc = cell_y(bim_boxes[i * 4 + 3]); y <= yc; ++y)
+                    {
+                        for (size_t x = cell_x(bim_boxes[i * 4]), xc = cell_x(bim_boxes[i * 4 + 2]); x <= xc; ++x)
+                        {
+                            ++bim_offsets[y * bim_cells_x + x + 1];
+                        }
+                    }
+                }
+                for (size_t c = 0, cc = bim_cells_x * bim_cells_y; c < cc; ++c)
+                {
+                    bim_offsets[c + 1] += bim_offsets[c];
+                }
+                std::vector<size_t> bim_cell_walls(bim_offsets.back());
+                {
+                    std::vector<size_t> bim_cursors(bim_offsets.begin(), bim_offsets.end() - 1);
+                    for (size_t i = 0; i < bim_walls_count; ++i)
+                    {
+                        for (size_t y = cell_y(bim_boxes[i * 4 + 1]), yc = cell_y(bim_boxes[i * 4 + 3]); y <= yc; ++y)
+                        {
+                            for (size_t x = cell_x(bim_boxes[i * 4]), xc = cell_x(bim_boxes[i * 4 + 2]); x <= xc; ++x)
+                            {
+                                bim_cell_walls[bim_cursors[y * bim_cells_x + x]++] = i;
+                            }
+                        }
+                    }
+                }
+
+                /// the new nodes are in a hash grid like `snapNodes`, so a crossing reuses the node of a wall or an earlier crossing within `_tolerance`
+                const precision_type bim_node_cell = (_tolerance > 0) ? _tolerance * 2 : static_cast<precision_type>(1);
+                const precision_type bim_tolerance_2 = _tolerance * _tolerance;
+                auto node_cell_key = [](std::int64_t _x, std::int64_t _y)
+                {
+                    return (static_cast<std::uint64_t>(_x) * 0x9E3779B97F4A7C15ull) ^ static_cast<std::uint64_t>(_y);
+                };
+                std::unordered_map<std::uint64_t, std::vector<std::pair<id_type, point_type>>> bim_node_cells;
+                auto add_node = [&](id_type _node_id, const point_type& _point)
+                {
+                    bim_node_cells[node_cell_key(static_cast<std::int64_t>(std::floor(_point.x() / bim_node_cell))
+                        , static_cast<std::int64_t>(std::floor(_point.y() / bim_node_cell)))].push_back(std::make_pair(_node_id, _point));
+                };
+                /// return the nearest node within `_tolerance`, or `none_id` if there is none,
+                /// a wall whose node is within `_tolerance` is in the cell of the point, because its box is expanded by `_tolerance`
+                auto find_node = [&](const point_type& _point)
+                {
+                    id_type bim_found_id = TConstant::none_id;
+                    precision_type bim_min_distance_2 = bim_tolerance_2;
+                    auto visit_node = [&](id_type _node_id, const point_type& _node_point)
+                    {
+                        const point_type bim_line(_node_point - _point);
+                        const precision_type bim_distance_2 = bim_line.x() * bim_line.x() + bim_line.y() * bim_line.y();
+                        if (bim_distance_2 < bim_min_distance_2 || (bim_distance_2 == bim_min_distance_2 && !TConstant::isValid(bim_found_id)))
+                        {
+                            bim_found_id = _node_id;
+                            bim_min_distance_2 = bim_distance_2;
+                        }
+                    };
+                    const size_t bim_cell_index = cell_y(_point.y()) * bim_cells_x + cell_x(_point.x());
+                    for (size_t i = bim_offsets[bim_cell_index], ic = bim_offsets[bim_cell_index + 1]; i < ic; ++i)
+                    {
+                        visit_node(bim_node_ids[bim_cell_walls[i] * 2], bim_points[bim_cell_walls[i] * 2]);
+                        visit_node(bim_node_ids[bim_cell_walls[i] * 2 + 1], bim_points[bim_cell_walls[i] * 2 + 1]);
+                    }
+
+                    const precision_type bim_cell_x = std::floor(_point.x() / bim_node_cell);
+                    const precision_type bim_cell_y = std::floor(_point.y() / bim_node_cell);
+                    const std::int64_t bim_x = static_cast<std::int64_t>(bim_cell_x);
+                    const std::int64_t bim_y = static_cast<std::int64_t>(bim_cell_y);
+                    const std::int64_t bim_other_x = (_point.x() / bim_node_cell - bim_cell_x < static_cast<precision_type>(0.5)) ? bim_x - 1 : bim_x + 1;
+                    const std::int64_t bim_other_y = (_point.y() / bim_node_cell - bim_cell_y < static_cast<precision_type>(0.5)) ? bim_y - 1 : bim_y + 1;
+                    for (const std::int64_t y : { bim_y, bim_other_y })
+                    {
+                        for (const std::int64_t x : { bim_x, bim_other_x })
+                        {
+                            typename std::unordered_map<std::uint64_t, std::vector<std::pair<id_type, point_type>>>::const_iterator cit_found = bim_node_cells.find(node_cell_key(x, y));
+                            if (cit_found == bim_node_cells.cend()) continue;
+                            for (const std::pair<id_type, point_type>& bim_node : cit_found->second)
+                            {
+                                visit_node(bim_node.first, bim_node.second);
+                            }
+                        }
+                    }
+                    return bim_found_id;
+                };
+
+                /// the split points of every wall, they are (the index of wall, (the parameter on the wall, the id of node))
+                std::vector<std::pair<size_t, std::pair<precision_type, id_type>>> bim_splits;
+                std::vector<std::pair<id_type, point_type>> bim_new_nodes;
+                const id_type bim_first_new_node_id = bim_next_node_id;
+                /// split the wall `_a` if the node `_node_index` of the wall `_b` lies on it, return true if they touch
+                auto split_at_node = [&](size_t _a, size_t _node_index) -> bool
+                {
+                    const id_type bim_node_id = bim_node_ids[_node_index];
+                    if (bim_node_id == bim_node_ids[_a * 2] || bim_node_id == bim_node_ids[_a * 2 + 1]) return true;
+                    const point_type& bim_start = bim_points[_a * 2];
+                    const point_type& bim_end = bim_points[_a * 2 + 1];
+                    const point_type& bim_point = bim_points[_node_index];
+                    const precision_type bim_dx = bim_end.x() - bim_start.x();
+                    const precision_type bim_dy = bim_end.y() - bim_start.y();
+                    const precision_type bim_px = bim_point.x() - bim_start.x();
+                    const precision_type bim_py = bim_point.y() - bim_start.y();
+                    const precision_type bim_length = std::sqrt(bim_dx * bim_dx + bim_dy * bim_dy);
+                    if (bim_px * bim_px + bim_py * bim_py <= _tolerance * _tolerance) return true;
+                    const precision_type bim_ex = bim_point.x() - bim_end.x();
+                    const precision_type bim_ey = bim_point.y() - bim_end.y();
+                    if (bim_ex * bim_ex + bim_ey * bim_ey <= _tolerance * _tolerance) return true;
+                    if (!(bim_length > 0)) return false;
+                    const precision_type bim_t = (bim_px * bim_dx + bim_py * bim_dy) / (bim_length * bim_length);
+                    if (bim_t <= 0 || bim_t >= 1) return false;
+                    if (std::abs(bim_px * bim_dy - bim_py * bim_dx) / bim_length > _tolerance) return false;
+                    bim_splits.push_back(std::make_pair(_a, std::make_pair(bim_t, bim_node_id)));
+                    return true;
+                };
+                for (size_t y = 0; y < bim_cells_y; ++y)
+                {
+                    for (size_t x = 0; x < bim_cells_x; ++x)
+                    {
+                        const size_t bim_cell_index = y * bim_cells_x + x;
+                        for (size_t i = bim_offsets[bim_cell_index], ic = bim_offsets[bim_cell_index + 1]; i < ic; ++i)
+                        {
+                            const size_t bim_a = bim_cell_walls[i];
+                            for (size_t j = i + 1; j < ic; ++j)
+                            {
+                                const size_t bim_b = bim_cell_walls[j];
+                                const precision_type bim_overlap_x = std::max(bim_boxes[bim_a * 4], bim_boxes[bim_b * 4]);
+                                const precision_type bim_overlap_y = std::max(bim_boxes[bim_a * 4 + 1], bim_boxes[bim_b * 4 + 1]);
+                                if (bim_overlap_x > std::min(bim_boxes[bim_a * 4 + 2], bim_boxes[bim_b * 4 + 2])
+                                    || bim_overlap_y > std::min(bim_boxes[bim_a * 4 + 3], bim_boxes[bim_b * 4 + 3]))
+                                {
+                                    continue;
+                                }
+                                /// a pair of walls is only tested in the cell of the bottom-left corner of their overlapped box
+                                if (cell_x(bim_overlap_x) != x || cell_y(bim_overlap_y) != y) continue;
+
+                                bool bim_touched = split_at_node(bim_a, bim_b * 2);
+                                bim_touched = split_at_node(bim_a, bim_b * 2 + 1) || bim_touched;
+                                bim_touched = split_at_node(bim_b, bim_a * 2) || bim_touched;
+                                bim_touched = split_at_node(bim_b, bim_a * 2 + 1) || bim_touched;
+                                if (bim_touched) continue;
+
+                                /// both walls cross if the nodes of every wall are on the different sides of the other one exactly
+                                const point_type& bim_p = bim_points[bim_a * 2];
+                                const point_type& bim_q = bim_points[bim_b * 2];
+                                if (predicates::orientation(bim_p, bim_points[bim_a * 2 + 1], bim_q) * predicates::orientation(bim_p, bim_points[bim_a * 2 + 1], bim_points[bim_b * 2 + 1]) >= 0
+                                    || predicates::orientation(bim_q, bim_points[bim_b * 2 + 1], bim_p) * predicates::orientation(bim_q, bim_points[bim_b * 2 + 1], bim_points[bim_a * 2 + 1]) >= 0)
+                                {
+                                    continue;
+                                }
+                                const precision_type bim_rx = bim_points[bim_a * 2 + 1].x() - bim_p.x();
+                                const precision_type bim_ry = bim_points[bim_a * 2 + 1].y() - bim_p.y();
+                                const precision_type bim_sx = bim_points[bim_b * 2 + 1].x() - bim_q.x();
+                                const precision_type bim_sy = bim_points[bim_b * 2 + 1].y() - bim_q.y();
+                                const precision_type bim_denominator = bim_rx * bim_sy - bim_ry * bim_sx;
+                                const precision_type bim_qpx = bim_q.x() - bim_p.x();
+                                const precision_type bim_qpy = bim_q.y() - bim_p.y();
+                                /// the rounded parameters may be out of `(0, 1)` a little, or not a number if the rounded denominator is 0
+                                precision_type bim_t = (bim_qpx * bim_sy - bim_qpy * bim_sx) / bim_denominator;
+                                precision_type bim_u = (bim_qpx * bim_ry - bim_qpy * bim_rx) / bim_denominator;
+                                if (!std::isfinite(bim_t) || !std::isfinite(bim_u)) continue;
+                                bim_t = std::min(std::max(bim_t, static_cast<precision_type>(0)), static_cast<precision_type>(1));
+                                bim_u = std::min(std::max(bim_u, static_cast<precision_type>(0)), static_cast<precision_type>(1));
+                                /// the crossing reuses a node within `_tolerance`, so the walls crossing at the same point share one node
+                                const point_type bim_crossing(bim_p.x() + bim_rx * bim_t, bim_p.y() + bim_ry * bim_t);
+                                id_type bim_node_id = find_node(bim_crossing);
+                                if (!TConstant::isValid(bim_node_id))
+                                {
+                                    bim_node_id = bim_next_node_id++;
+                                    bim_new_nodes.push_back(std::make_pair(bim_node_id, bim_crossing));
+                                    add_node(bim_node_id, bim_crossing);
+                                }
+                                bim_splits.push_back(std::make_pair(bim_a, std::make_pair(bim_t, bim_node_id)));
+                                bim_splits.push_back(std::make_pair(bim_b, std::make_pair(bim_u, bim_node_id)));
+                            }
+                        }
+                    }
+                }
+                if (bim_splits.empty())
+                {
+                    return 0;
+                }
+
+                /// replace every split wall by its pieces
+                std::sort(bim_splits.begin(), bim_splits.end());
+                size_t bim_split_walls_count = 0;
+                std::vector<bool> bim_used_new_nodes(bim_new_nodes.size(), false);
+                std::vector<std::pair<precision_type, id_type>> bim_wall_nodes;
+                for (size_t i = 0, ic = bim_splits.size(); i < ic; )
+                {
+                    const size_t bim_wall_index = bim_splits[i].first;
+                    const id_type bim_wall_id = bim_wall_ids[bim_wall_index];
+                    const id_type bim_end_node_id = bim_node_ids[bim_wall_index * 2 + 1];
+                    point_type bim_direction(bim_points[bim_wall_index * 2 + 1] - bim_points[bim_wall_index * 2]);
+                    const precision_type bim_length = bim_direction.normalize();
+                    /// the split points closer than `_tolerance` to the previous one or the end node make no piece
+                    const precision_type bim_min_step = (bim_length > 0) ? _tolerance / bim_length : static_cast<precision_type>(1);
+                    bim_wall_nodes.clear();
+                    bim_wall_nodes.push_back(std::make_pair(static_cast<precision_type>(0), bim_node_ids[bim_wall_index * 2]));
+                    for (; i < ic && bim_splits[i].first == bim_wall_index; ++i)
+                    {
+                        const std::pair<precision_type, id_type>& bim_split = bim_splits[i].second;
+                        if (bim_split.second == bim_wall_nodes.back().second || bim_split.second == bim_wall_nodes.front().second || bim_split.second == bim_end_node_id) continue;
+                        if (bim_split.first - bim_wall_nodes.back().first <= bim_min_step || 1 - bim_split.first <= bim_min_step) continue;
+                        bim_wall_nodes.push_back(bim_split);
+                    }
+                    if (bim_wall_nodes.size() == 1) continue;
+                    for (size_t n = 1, nc = bim_wall_nodes.size(); n < nc; ++n)
+                    {
+                        if (bim_wall_nodes[n].second >= bim_first_new_node_id)
+                        {
+                            bim_used_new_nodes[static_cast<size_t>(bim_wall_nodes[n].second - bim_first_new_node_id)] = true;
+                        }
+                    }
+                    bim_wall_nodes.push_back(std::make_pair(static_cast<precision_type>(1), bim_end_node_id));
+
+                    ++bim_split_walls_count;
+                    const wall_type bim_wall = _house.walls.find(bim_wall_id)->second;
+                    for (size_t n = 1, nc = bim_wall_nodes.size(); n < nc; ++n)
+                    {
+                        wall_type bim_piece(bim_wall);
+                        bim_piece.start_node_id = bim_wall_nodes[n - 1].second;
+                        bim_piece.end_node_id = bim_wall_nodes[n].second;
+                        const id_type bim_piece_id = (n == 1) ? bim_wall_id : bim_next_wall_id++;
+                        if (n == 1)
+                        {
+                            _house.walls.find(bim_wall_id)->second = bim_piece;
+                        }
+                        else
+                        {
+                            _house.walls.insert(std::make_pair(bim_piece_id, bim_piece));
+                        }
+                        _pieces.push_back(wall_piece(bim_piece_id, bim_wall_id, bim_wall_nodes[n - 1].first * bim_length, bim_wall_nodes[n].first * bim_length));
+                    }
+                }
+                for (size_t n = 0, nc = bim_new_nodes.size(); n < nc; ++n)
+                {
+                    if (bim_used_new_nodes[n])
+                    {
+                        _house.nodes.insert(std::make_pair(bim_new_nodes[n].first, node_type(bim_new_nodes[n].second)));
+                    }
+                }
+
+                /// a room uses the pieces of its split walls, except the pieces at an open end of a wall after the last node where its other walls meet it
+                id_vector bim_room_wall_ids;
+                id_vector bim_room_node_ids;
+                auto piece_node = [&_house](typename wall_piece_vector::const_iterator _first_piece, size_t _pieces_count, size_t _index)
+                {
+                    return (_index < _pieces_count) ? _house.walls.find((_first_piece + _index)->wall_id)->second.start_node_id
+                        : _house.walls.find((_first_piece + (_pieces_count - 1))->wall_id)->second.end_node_id;
+                };
+                for (typename house_type::room_map::iterator it = _house.rooms.begin(); it != _house.rooms.end(); ++it)
+                {
+                    bim_room_node_ids.clear();
+                    for (const id_type bim_wall_id : it->second.wall_ids)
+                    {
+                        const std::pair<typename wall_piece_vector::const_iterator, typename wall_piece_vector::const_iterator> bim_range = findWallPieces(_pieces, bim_wall_id);
+                        if (bim_range.first == bim_range.second)
+                        {
+                            const typename house_type::wall_map::const_iterator cit_found_wall = _house.walls.find(bim_wall_id);
+                            if (cit_found_wall == _house.walls.cend()) continue;
+                            bim_room_node_ids.push_back(cit_found_wall->second.start_node_id);
+                            bim_room_node_ids.push_back(cit_found_wall->second.end_node_id);
+                            continue;
+                        }
+                        for (size_t k = 0, kc = static_cast<size_t>(bim_range.second - bim_range.first); k < kc; ++k)
+                        {
+                            bim_room_node_ids.push_back(piece_node(bim_range.first, kc, k));
+                            bim_room_node_ids.push_back(piece_node(bim_range.first, kc, k + 1));
+                        }
+                    }
+                    std::sort(bim_room_node_ids.begin(), bim_room_node_ids.end());
+                    auto degree = [&bim_room_node_ids](id_type _node_id)
+                    {
+                        const std::pair<typename id_vector::const_iterator, typename id_vector::const_iterator> bim_nodes = std::equal_range(bim_room_node_ids.cbegin(), bim_room_node_ids.cend(), _node_id);
+                        return static_cast<size_t>(bim_nodes.second - bim_nodes.first);
+                    };
+
+                    bim_room_wall_ids.clear();
+                    for (const id_type bim_wall_id : it->second.wall_ids)
+                    {
+                        const std::pair<typename wall_piece_vector::const_iterator, typename wall_piece_vector::const_iterator> bim_range = findWallPieces(_pieces, bim_wall_id);
+                        if (bim_range.first == bim_range.second)
+                        {
+                            bim_room_wall_ids.push_back(bim_wall_id);
+                            continue;
+                        }
+                        /// the pieces in `[bim_first, bim_last)` are kept, an open end is cut at the nearest node which has another wall of the room
+                        const size_t bim_pieces_count = static_cast<size_t>(bim_range.second - bim_range.first);
+                        size_t bim_first = 0;
+                        size_t bim_last = bim_pieces_count;
+                        if (degree(piece_node(bim_range.first, bim_pieces_count, 0)) == 1)
+                        {
+                            for (size_t k = 1; k < bim_pieces_count; ++k)
+                            {
+                                if (degree(piece_node(bim_range.first, bim_pieces_count, k)) > 2)
+                                {
+                                    bim_first = k;
+                                    break;
+                                }
+                            }
+                        }
+                        if (degree(piece_node(bim_range.first, bim_pieces_count, bim_pieces_count)) == 1)
+                        {
+                            for (size_t k = bim_pieces_count - 1; k > 0; --k)
+                            {
+                                if (degree(piece_node(bim_range.first, bim_pieces_count, k)) > 2)
+                                {
+                                    bim_last = k;
+                                    break;
+                                }
+                            }
+                        }
+                        if (bim_first >= bim_last)
+                        {
+                            bim_first = 0;
+                            bim_last = bim_pieces_count;
+                        }
+                        for (size_t k = bim_first; k < bim_last; ++k)
+                        {
+                            bim_room_wall_ids.push_back((bim_range.first + k)->wall_id);
+                        }
+                    }
+                    it->second.wall_ids.swap(bim_room_wall_ids);
+                }
+
+                /// every hole is moved to the piece which overlaps it most, and clipped by the piece
+                for (typename house_type::hole_map::iterator it = _house.holes.begin(); it != _house.holes.end(); ++it)
+                {
+                    hole_type& bim_hole = it->second;
+                    const std::pair<typename wall_piece_vector::const_iterator, typename wall_piece_vector::const_iterator> bim_range = findWallPieces(_pieces, bim_hole.wall_id);
+                    if (bim_range.first == bim_range.second) continue;
+                    const precision_type bim_hole_start = bim_hole.distance;
+                    const precision_type bim_hole_end = bim_hole.distance + bim_hole.width;
+                    typename wall_piece_vector::const_iterator cit_piece = bim_range.first;
+                    if (bim_hole.width > 0)
+                    {
+                        precision_type bim_max_overlap = -std::numeric_limits<precision_type>::infinity();
+                        for (typename wall_piece_vector::const_iterator cit = bim_range.first; cit != bim_range.second; ++cit)
+                        {
+                            const precision_type bim_overlap = std::min(bim_hole_end, cit->end) - std::max(bim_hole_start, cit->start);
+                            if (bim_overlap > bim_max_overlap)
+                            {
+                                bim_max_overlap = bim_overlap;
+                                cit_piece = cit;
+                            }
+                        }
+                    }
+                    else
+                    {
+                        while ((cit_piece + 1) != bim_range.second && (cit_piece + 1)->start < bim_hole_start)
+                        {
+                            ++cit_piece;
+                        }
+                    }
+                    bim_hole.wall_id = cit_piece->wall_id;
+                    bim_hole.distance = bim_hole_start - cit_piece->start;
+                    if (bim_hole.width > 0)
+                    {
+                        const precision_type bim_end = std::min(bim_hole_end, cit_piece->end) - cit_piece->start;
+                        bim_hole.distance = std::max(bim_hole.distance, static_cast<precision_type>(0));
+                        bim_hole.width = bim_end - bim_hole.distance;
+                    }
+                    /// a hole at the start of a piece is not valid, so it is moved a little
+                    if (bim_hole.distance <= 0)
+                    {
+                        const precision_type bim_min_distance = (_tolerance > 0) ? _tolerance
+                            : std::numeric_limits<precision_type>::epsilon() * (cit_piece->end - cit_piece->start);
+                        if (bim_hole.width > bim_min_distance)
+                        {
+                            bim_hole.width -= bim_min_distance - bim_hole.distance;
+                        }
+                        bim_hole.distance = bim_min_distance;
+                    }
+                }
+                return bim_split_walls_count;
+            }
+
+            /*!
+             * Find the pieces of a wall from the result of `nodeWalls`, the range is empty if the wall is not split.
+             */
+            static std::pair<typename wall_piece_vector::const_iterator, typename wall_piece_vector::const_iterator> findWallPieces(const wall_piece_vector& _pieces
+                , id_type _original_wall_id)
+            {
+                typename wall_piece_vector::const_iterator cit_begin = std::lower_bound(_pieces.cbegin(), _pieces.cend(), _original_wall_id
+                    , [](const wall_piece& _a, id_type _id) { return _a.original_wall_id < _id; });
+                typename wall_piece_vector::const_iterator cit_end = cit_begin;
+                while (cit_end != _pieces.cend() && cit_end->original_wall_id == _original_wall_id)
+                {
+                    ++cit_end;
+                }
+                return std::make_pair(cit_begin, cit_end);
+            }
+
+            /*!
+             * Merge the nodes of a house which are not farther than a tolerance, so the walls meet at the same node.
+             * 
+             * The nodes are visited in the order of ids, and every node is merged into the nearest kept node within `_tolerance`,
+             * or it is kept if there is none, so a kept node never moves and the nodes are not chained farther than `_tolerance`.
+             * The kept nodes are looked up in a hash grid of cells of `2 * _tolerance`, so only the cell of a node and 3 cells next to
+             * the nearest corner of it are searched, and it costs \f$ O(n) \f$ expectedly.
+             * The walls use the kept nodes, the walls whose nodes are merged into one are erased with their holes,
+             * and the rooms don't use them any more.
+             * 
+             * @param _house The house
+             * @param _tolerance The max distance between the merged nodes, only the same points are merged if it is 0
+             * @param _erased_wall_ids Output the ids of the erased walls if it is not null
+             * @return The count of the merged nodes
+             */
+            static size_t snapNodes(house_type& _house
+                , precision_type _tolerance
+                , id_vector* _erased_wall_ids = nullptr)
+            {
+                if (_erased_wall_ids != nullptr)
+                {
+                    _erased_wall_ids->clear();
+                }
+                const precision_type bim_cell = (_tolerance > 0) ? _tolerance * 2 : static_cast<precision_type>(1);
+                const precision_type bim_tolerance_2 = _tolerance * _tolerance;
+                auto cell_key = [](std::int64_t _x, std::int64_t _y)
+                {
+                    return (static_cast<std::uint64_t>(_x) * 0x9E3779B97F4A7C15ull) ^ static_cast<std::uint64_t>(_y);
+                };
+
+                /// the kept nodes of every cell, different cells may share a key, so the distances are always checked
+                std::unordered_map<std::uint64_t, std::vector<std::pair<id_type, point_type>>> bim_cells;
+                bim_cells.reserve(_house.nodes.size());
+                std::vector<std::pair<id_type, id_type>> bim_merged_nodes;
+                for (typename house_type::node_map::const_iterator cit = _house.nodes.cbegin(); cit != _house.nodes.cend(); ++cit)
+                {
+                    const point_type& bim_point = cit->second.p();
+                    if (!std::isfinite(bim_point.x()) || !std::isfinite(bim_point.y())) continue;
+                    const precision_type bim_cell_x = std::floor(bim_point.x() / bim_cell);
+                    const precision_type bim_cell_y = std::floor(bim_point.y() / bim_cell);
+                    const std::int64_t bim_x = static_cast<std::int64_t>(bim_cell_x);
+                    const std::int64_t bim_y = static_cast<std::int64_t>(bim_cell_y);
+                    /// the other cell of every axis is on the side of the nearer border
+                    const std::int64_t bim_other_x = (bim_point.x() / bim_cell - bim_cell_x < static_cast<precision_type>(0.5)) ? bim_x - 1 : bim_x + 1;
+                    const std::int64_t bim_other_y = (bim_point.y() / bim_cell - bim_cell_y < static_cast<precision_type>(0.5)) ? bim_y - 1 : bim_y + 1;
+                    id_type bim_kept_id = TConstant::none_id;
+                    precision_type bim_min_distance_2 = bim_tolerance_2;
+                    for (const std::int64_t y : { bim_y, bim_other_y })
+                    {
+                        for (const std::int64_t x : { bim_x, bim_other_x })
+                        {
+                            typename std::unordered_map<std::uint64_t, std::vector<std::pair<id_type, point_type>>>::const_iterator cit_found = bim_cells.find(cell_key(x, y));
+                            if (cit_found == bim_cells.cend()) continue;
+                            for (const std::pair<id_type, point_type>& bim_kept : cit_found->second)
+                            {
+                                const point_type bim_line(bim_kept.second - bim_point);
+                                const precision_type bim_distance_2 = bim_line.x() * bim_line.x() + bim_line.y() * bim_line.y();
+                                if (bim_distance_2 < bim_min_distance_2
+                                    || (bim_distance_2 == bim_min_distance_2 && (!TConstant::isValid(bim_kept_id) || bim_kept.first < bim_kept_id)))
+                                {
+                                    bim_kept_id = bim_kept.first;
+                                    bim_min_distance_2 = bim_distance_2;
+                                }
+                            }
+                        }
+                    }
+                    if (TConstant::isValid(bim_kept_id))
+                    {
+                        bim_merged_nodes.push_back(std::make_pair(cit->first, bim_kept_id));
+                    }
+                    else
+                    {
+                        bim_cells[cell_key(bim_x, bim_y)].push_back(std::make_pair(cit->first, bim_point));
+                    }
+                }
+                if (bim_merged_nodes.empty())
+                {
+                    return 0;
+                }
+
+                /// the merged nodes are sorted by their ids
+                auto find_kept_node = [&bim_merged_nodes](id_type _node_id)
+                {
+                    typename std::vector<std::pair<id_type, id_type>>::const_iterator cit_found = std::lower_bound(bim_merged_nodes.cbegin(), bim_merged_nodes.cend()
+                        , std::make_pair(_node_id, static_cast<id_type>(0)));
+                    return (cit_found != bim_merged_nodes.cend() && cit_found->first == _node_id) ? cit_found->second : _node_id;
+                };
+                id_vector bim_erased_wall_ids;
+                for (typename house_type::wall_map::iterator it = _house.walls.begin(); it != _house.walls.end(); ++it)
+                {
+                    wall_type& bim_wall = it->second;
+                    bim_wall.start_node_id = find_kept_node(bim_wall.start_node_id);
+                    bim_wall.end_node_id = find_kept_node(bim_wall.end_node_id);
+                    if (bim_wall.start_node_id == bim_wall.end_node_id)
+                    {
+                        bim_erased_wall_ids.push_back(it->first);
+                    }
+                }
+                for (const std::pair<id_type, id_type>& bim_merged_node : bim_merged_nodes)
+                {
+                    _house.nodes.erase(bim_merged_node.first);
+                }
+
+                if (!bim_erased_wall_ids.empty())
+                {
+                    for (const id_type bim_wall_id : bim_erased_wall_ids)
+                    {
+                        _house.walls.erase(bim_wall_id);
+                    }
+                    id_vector bim_hole_ids;
+                    for (typename house_type::hole_map::const_iterator cit = _house.holes.cbegin(); cit != _house.holes.cend(); ++cit)
+                    {
+                        if (std::binary_search(bim_erased_wall_ids.cbegin(), bim_erased_wall_ids.cend(), cit->second.wall_id))
+                        {
+                            bim_hole_ids.push_back(cit->first);
+                        }
+                    }
+                    for (const id_type bim_hole_id : bim_hole_ids)
+                    {
+                        _house.holes.erase(bim_hole_id);
+                    }
+                    for (typename house_type::room_map::iterator it = _house.rooms.begin(); it != _house.rooms.end(); ++it)
+                    {
+                        id_vector& bim_wall_ids = it->second.wall_ids;
+                        bim_wall_ids.erase(std::remove_if(bim_wall_ids.begin(), bim_wall_ids.end()
+                            , [&bim_erased_wall_ids](id_type _wall_id) { return std::binary_search(bim_erased_wall_ids.cbegin(), bim_erased_wall_ids.cend(), _wall_id); })
+                            , bim_wall_ids.end());
+                    }
+                }
+                if (_erased_wall_ids != nullptr)
+                {
+                    _erased_wall_ids->swap(bim_erased_wall_ids);
+                }
+                return bim_merged_nodes.size();
+            }
+
+            /*!
+             * Copy a house, and renumber its nodes, walls, holes and rooms to `0, 1, 2...` by the order of their original ids.
+             * 
+             * The source house can use another `constant`, so the sparse ids of a house can be renumbered to the dense ids of
+             * a house whose `id_type` is `std::uint32_t`. The ids of missing entities become `none_id`.
+             * The room-exs of the new house are same as the ones of the source house except the ids, because the order of ids is kept.
+             * 
+             * @param _source The source house
+             * @param _house Output the renumbered house
+             * @param _renumbering Output the original ids if it is not null
+             */
+            template<typename TSourceConstant>
+            static void renumberHouse(const house<TSourceConstant>& _source
+                , house_type& _house
+                , id_renumbering<typename TSourceConstant::id_type>* _renumbering = nullptr)
+            {
+                typedef house<TSourceConstant>                              source_house_type;
+                typedef id_renumbering<typename TSourceConstant::id_type>   renumbering_type;
+                const size_t bim_max_count = static_cast<size_t>(TConstant::none_id);
+                if (_source.nodes.size() > bim_max_count || _source.walls.size() > bim_max_count
+                    || _source.holes.size() > bim_max_count || _source.rooms.size() > bim_max_count)
+                {
+                    throw std::invalid_argument("too many entities for id_type!");
+                }
+
+                renumbering_type bim_local_renumbering;
+                renumbering_type& bim_renumbering = (_renumbering != nullptr) ? *_renumbering : bim_local_renumbering;
+                bim_renumbering.clear();
+                for (typename source_house_type::node_map::const_iterator cit = _source.nodes.cbegin(); cit != _source.nodes.cend(); ++cit)
+                {
+                    bim_renumbering.node_ids.push_back(cit->first);
+                }
+                for (typename source_house_type::wall_map::const_iterator cit = _source.walls.cbegin(); cit != _source.walls.cend(); ++cit)
+                {
+                    bim_renumbering.wall_ids.push_back(cit->first);
+                }
+                for (typename source_house_type::hole_map::const_iterator cit = _source.holes.cbegin(); cit != _source.holes.cend(); ++cit)
+                {
+                    bim_renumbering.hole_ids.push_back(cit->first);
+                }
+                for (typename source_house_type::room_map::const_iterator cit = _source.rooms.cbegin(); cit != _source.rooms.cend(); ++cit)
+                {
+                    bim_renumbering.room_ids.push_back(cit->first);
+                }
+
+                auto renumber_id = [](const typename renumbering_type::id_vector& _ids, typename TSourceConstant::id_type _id)
+                {
+                    const size_t bim_index = renumbering_type::find(_ids, _id);
+                    return (bim_index == renumbering_type::none_index) ? TConstant::none_id : static_cast<id_type>(bim_index);
+                };
+
+                /// the new ids are appended in increasing order
+                _house.reset();
+                _house.name = _source.name;
+                id_type bim_id = 0;
+                for (typename source_house_type::node_map::const_iterator cit = _source.nodes.cbegin(); cit != _source.nodes.cend(); ++cit)
+                {
+                    _house.nodes.insert(std::make_pair(bim_id++, node_type(TConstant::convert(cit->second.x()), TConstant::convert(cit->second.y()))));
+                }
+                bim_id = 0;
+                for (typename source_house_type::wall_map::const_iterator cit = _source.walls.cbegin(); cit != _source.walls.cend(); ++cit)
+                {
+                    wall_type bim_wall(renumber_id(bim_renumbering.node_ids, cit->second.start_node_id)
+                        , renumber_id(bim_renumbering.node_ids, cit->second.end_node_id)
+                        , TConstant::convert(cit->second.thickness));
+                    bim_wall.kind = typename wall_type::kind_type(cit->second.kind);
+                    _house.walls.insert(std::make_pair(bim_id++, bim_wall));
+                }
+                bim_id = 0;
+                for (typename source_house_type::hole_map::const_iterator cit = _source.holes.cbegin(); cit != _source.holes.cend(); ++cit)
+                {
+                    hole_type bim_hole(renumber_id(bim_renumbering.wall_ids, cit->second.wall_id)
+                        , TConstant::convert(cit->second.distance)
+                        , TConstant::convert(cit->second.width));
+                    bim_hole.kind = typename hole_type::kind_type(cit->second.kind);
+                    bim_hole.direction = typename hole_type::kind_type(cit->second.direction);
+                    _house.holes.insert(std::make_pair(bim_id++, bim_hole));
+                }
+                bim_id = 0;
+                for (typename source_house_type::room_map::const_iterator cit = _source.rooms.cbegin(); cit != _source.rooms.cend(); ++cit)
+                {
+                    room_type bim_room;
+                    bim_room.kind = typename room_type::kind_type(cit->second.kind);
+                    bim_room.wall_ids.reserve(cit->second.wall_ids.size());
+                    for (typename TSourceConstant::id_type each_wall_id : cit->second.wall_ids)
+                    {
+                        bim_room.wall_ids.push_back(renumber_id(bim_renumbering.wall_ids, each_wall_id));
+                    }
+                    _house.rooms.insert(std::make_pair(bim_id++, bim_room));
+                }
+            }
+
+            /*!
+             * Gather the polygon of a room-ex, it starts from the start node of every wall in its direction.
+             * 
+             * @param _house The house
+             * @param _room_ex The room-ex, it must have walls
+             * @param _points Output the points of the polygon, one for every wall
+             * @param _box Output the box of the polygon as min x, min y, max x and max y
+             * @return The area of the polygon
+             */
+            static precision_type gatherRoomExPolygon(const house_type& _house, const room_ex& _room_ex, point_type* _points, precision_type* _box)
+            {
+                gatherRoomExPoints(_house, _room_ex, _points);
+                const size_t bim_count = _room_ex.walls.size();
+                precision_type bim_area = 0;
+                _box[0] = _box[2] = _points[0].x();
+                _box[1] = _box[3] = _points[0].y();
+                for (size_t i = 0, j = bim_count - 1; i < bim_count; j = i++)
+                {
+                    bim_area += _points[j].x() * _points[i].y() - _points[i].x() * _points[j].y();
+                    _box[0] = std::min(_box[0], _points[i].x());
+                    _box[1] = std::min(_box[1], _points[i].y());
+                    _box[2] = std::max(_box[2], _points[i].x());
+                    _box[3] = std::max(_box[3], _points[i].y());
+                }
+                return std::abs(bim_area) / 2;
+            }
+
+            /*!
+             * The crossing number test by the exact orientations.
+             * 
+             * @param _points The points of the polygon
+             * @param _count The count of the points
+             * @param _point The point, it must not be on the edges
+             * @return Whether the point is inside the polygon
+             */
+            static bool isInPolygon(const point_type* _points, size_t _count, const point_type& _point)
+            {
+                bool bim_inside = false;
+                for (size_t i = 0, j = _count - 1; i < _count; j = i++)
+                {
+                    const bool bim_a_is_upper = (_points[j].y() > _point.y());
+                    const bool bim_b_is_upper = (_points[i].y() > _point.y());
+                    if (bim_a_is_upper != bim_b_is_upper
+                        && (predicates::orientation(_points[j], _points[i], _point) > 0) == bim_b_is_upper)
+                    {
+                        bim_inside = !bim_inside;
+                    }
+                }
+                return bim_inside;
+            }
+
+        private:
+            /// reuse the room-ex at `_index` and the memory of its walls, or append a spare one of the workspace
+            static room_ex& reuseRoomEx(room_ex_vector& _room_exs, size_t _index, workspace& _workspace)
+            {
+                if (_index == _room_exs.size())
+                {
+                    if (_workspace.spare_room_exs.empty())
+                    {
+                        _room_exs.push_back(room_ex());
+                        return _room_exs.back();
+                    }
+                    _room_exs.push_back(std::move(_workspace.spare_room_exs.back()));
+                    _workspace.spare_room_exs.pop_back();
+                }
+                room_ex& bim_room_ex = _room_exs[_index];
+                bim_room_ex.id = TConstant::none_id;
+                bim_room_ex.walls.clear();
+                bim_room_ex.side = room_side_both;
+                return bim_room_ex;
+            }
+
+            /// keep the first `_count` room-exs, and move the others into the workspace to reuse their memory
+            static void truncateRoomExs(room_ex_vector& _room_exs, size_t _count, workspace& _workspace)
+            {
+                while (_room_exs.size() > _count)
+                {
+                    _workspace.spare_room_exs.push_back(std::move(_room_exs.back()));
+                    _room_exs.pop_back();
+                }
+            }
+
+            /// add a closed room-ex to the statistics, after its side is decided from `_side_start`
+            static void addFaceStats(const room_ex& _room_ex, std::uint64_t _side_start, room_ex_stats& _stats)
+            {
+                _stats.side_ns += room_ex_stats::now() - _side_start;
+                ++_stats.faces;
+                for (const wall_ex& bim_wall_ex : _room_ex.walls)
+                {
+                    if (bim_wall_ex.repeated) ++_stats.repeated_walls;
+                }
+            }
+
+            static void traceRoomExsByMode(const house_type& _house
+                , half_edge_graph& _graph
+                , room_ex_vector& _room_exs
+                , id_type _room_id
+                , trace_mode _mode
+                , std::vector<size_t>* _first_half_edges
+                , workspace* _workspace = nullptr)
+            {
+                BIMPP_PLAN2D_STATS_ONLY(const std::uint64_t bim_trace_start = room_ex_stats::now();)
+                BIMPP_PLAN2D_STATS_ONLY(const std::uint64_t bim_side_ns = (_workspace != nullptr) ? _workspace->stats.side_ns : 0;)
+                if (_mode == trace_mode_rotation
+                    || _mode == trace_mode_face)
+                {
+                    buildRotationSystem(_graph, _workspace);
+                }
+
+                if (_mode == trace_mode_face)
+                {
+                    extractRoomExs(_graph, _room_exs, _room_id, _first_half_edges, _workspace);
+                }
+                else
+                {
+                    traceRoomExs(_house, _graph, _room_exs, _room_id, _mode, _first_half_edges, _workspace);
+                }
+                BIMPP_PLAN2D_STATS_ONLY(if (_workspace != nullptr)
+                {
+                    _workspace->stats.trace_ns += room_ex_stats::now() - bim_trace_start - (_workspace->stats.side_ns - bim_side_ns);
+                })
+            }
+
+            /*!
+             * Trace every connected component in parallel, and sort the room-exs by their first half-edges like the serial one.
+             * 
+             * Only the statistics of `_workspace` are used, every component has its own buffers.
+             */
+            static void traceRoomExsInParallel(const house_type& _house
+                , const half_edge_graph& _graph
+                , room_ex_vector& _room_exs
+                , id_type _room_id
+                , trace_mode _mode
+                , thread_pool& _pool
+                , workspace& _workspace)
+            {
+                (void)_workspace;
+                BIMPP_PLAN2D_STATS_ONLY(const std::uint64_t bim_trace_start = room_ex_stats::now();)
+                std::vector<half_edge_graph> bim_components;
+                std::vector<std::vector<size_t>> bim_components_half_edges;
+                splitHalfEdgeGraph(_graph, bim_components, bim_components_half_edges);
+
+                const size_t bim_components_count = bim_components.size();
+                std::vector<room_ex_vector> bim_components_room_exs(bim_components_count);
+                std::vector<std::vector<size_t>> bim_components_first_half_edges(bim_components_count);
+                BIMPP_PLAN2D_STATS_ONLY(std::vector<workspace> bim_components_workspaces(bim_components_count);)
+                BIMPP_PLAN2D_STATS_ONLY(_workspace.stats.trace_ns += room_ex_stats::now() - bim_trace_start;)
+                _pool.parallelFor(bim_components_count, [&](size_t _index)
+                {
+                    workspace* bim_workspace = nullptr;
+                    BIMPP_PLAN2D_STATS_ONLY(bim_workspace = &bim_components_workspaces[_index];)
+                    traceRoomExsByMode(_house, bim_components[_index], bim_components_room_exs[_index], _room_id, _mode
+                        , &bim_components_first_half_edges[_index], bim_workspace);
+                    for (size_t& bim_first_half_edge : bim_components_first_half_edges[_index])
+                    {
+                        bim_first_half_edge = bim_components_half_edges[_index][bim_first_half_edge];
+                    }
+                });
+
+                BIMPP_PLAN2D_STATS_ONLY(const std::uint64_t bim_merge_start = room_ex_stats::now();)
+                /// a component may start some room-exs from the same half-edge, so keep their orders in the component
+                std::vector<std::pair<std::pair<size_t, size_t>, std::pair<size_t, size_t>>> bim_orders;
+                for (size_t c = 0; c < bim_components_count; ++c)
+                {
+                    for (size_t i = 0, ic = bim_components_first_half_edges[c].size(); i < ic; ++i)
+                    {
+                        bim_orders.push_back(std::make_pair(std::make_pair(bim_components_first_half_edges[c][i], i), std::make_pair(c, i)));
+                    }
+                }
+                std::sort(bim_orders.begin(), bim_orders.end());
+                _room_exs.clear();
+                _room_exs.reserve(bim_orders.size());
+                for (const std::pair<std::pair<size_t, size_t>, std::pair<size_t, size_t>>& bim_order : bim_orders)
+                {
+                    _room_exs.push_back(room_ex());
+                    std::swap(_room_exs.back(), bim_components_room_exs[bim_order.second.first][bim_order.second.second]);
+                }
+                BIMPP_PLAN2D_STATS_ONLY(_workspace.stats.trace_ns += room_ex_stats::now() - bim_merge_start;)
+                BIMPP_PLAN2D_STATS_ONLY(for (const workspace& bim_component_workspace : bim_components_workspaces)
+                {
+                    _workspace.stats += bim_component_workspace.stats;
+                })
+            }
+
+            static void calculateAngleExsByKind(simd::angle_kind _kind
+                , const node_type& _o, const node_type& _a
+                , const precision_type* _bxs, const precision_type* _bys, size_t _count, precision_type* _results)
+            {
+                size_t i = calculateAngleExsBySimd(std::is_same<precision_type, double>(), _kind, _o, _a, _bxs, _bys, _count, _results);
+                for (; i < _count; ++i)
+                {
+                    const node_type bim_node_b(_bxs[i], _bys[i]);
+                    switch (_kind)
+                    {
+                    case simd::angle_kind_sin:
+                        _results[i] = calculateSinAngleEx(_o, _a, bim_node_b);
+                        break;
+                    case simd::angle_kind_cos:
+                        _results[i] = calculateCosAngleEx(_o, _a, bim_node_b);
+                        break;
+                    default:
+                        _results[i] = calculateAngleEx(_o, _a, bim_node_b);
+                        break;
+                    }
+                }
+            }
+
+            static size_t calculateAngleExsBySimd(std::true_type, simd::angle_kind _kind
+                , const node_type& _o, const node_type& _a
+                , const double* _bxs, const double* _bys, size_t _count, double* _results)
+            {
+                point_type line_a(_a.p() - _o.p()); line_a.normalize();
+                return simd::calculateAngleExs(simd::selected(), _kind
+                    , _o.p().data.data(), line_a.data.data(), _bxs, _bys, _count, _results);
+            }
+
+            static size_t calculateAngleExsBySimd(std::false_type, simd::angle_kind
+                , const node_type&, const node_type&
+                , const precision_type*, const precision_type*, size_t, precision_type*)
+            {
+                return 0;
+            }
+
+            /// get the start node of every wall of a room-ex in its direction, only the first `_count` ones if it isn't zero
+            static void gatherRoomExPoints(const house_type& _house, const room_ex& _room_ex, point_type* _points, size_t _count = 0)
+            {
+                const size_t bim_count = (_count == 0) ? _room_ex.walls.size() : std::min(_count, _room_ex.walls.size());
+                for (size_t i = 0; i < bim_count; ++i)
+                {
+                    const wall_ex& bim_wall_ex = _room_ex.walls[i];
+                    const typename house_type::wall_map::const_iterator cit_found_wall = _house.walls.find(bim_wall_ex.id);
+                    if (cit_found_wall == _house.walls.cend())
+                    {
+                        throw std::invalid_argument("contains invalid wall!");
+                    }
+                    const id_type bim_node_id = bim_wall_ex.inversed ? cit_found_wall->second.end_node_id : cit_found_wall->second.start_node_id;
+                    const typename house_type::node_map::const_iterator cit_found_node = _house.nodes.find(bim_node_id);
+                    if (cit_found_node == _house.nodes.cend())
+                    {
+                        throw std::invalid_argument("contains invalid node!");
+                    }
+                    _points[i] = cit_found_node->second.p();
+                }
+            }
+
+            /*!
+             * Add the sums of the edges of a polygon, see `simd::calculatePolygonSums`.
+             */
+            static void calculatePolygonSums(const precision_type* _xs, const precision_type* _ys, size_t _count, precision_type* _sums)
+            {
+                size_t i = calculatePolygonSumsBySimd(std::is_same<precision_type, double>(), _xs, _ys, _count, _sums);
+                for (; i < _count; ++i)
+                {
+                    const precision_type bim_cross = _xs[i] * _ys[i + 1] - _xs[i + 1] * _ys[i];
+                    const precision_type bim_dx = _xs[i + 1] - _xs[i];
+                    const precision_type bim_dy = _ys[i + 1] - _ys[i];
+                    _sums[0] += bim_cross;
+                    _sums[1] += (_xs[i] + _xs[i + 1]) * bim_cross;
+                    _sums[2] += (_ys[i] + _ys[i + 1]) * bim_cross;
+                    _sums[3] += std::sqrt(bim_dx * bim_dx + bim_dy * bim_dy);
+                }
+            }
+
+            static size_t calculatePolygonSumsBySimd(std::true_type, const double* _xs, const double* _ys, size_t _count, double* _sums)
+            {
+                return simd::calculatePolygonSums(simd::selected(), _xs, _ys, _count, _sums);
+            }
+
+            static size_t calculatePolygonSumsBySimd(std::false_type, const precision_type*, const precision_type*, size_t, precision_type*)
+            {
+                return 0;
+            }
+        };
+
+        /*!
+         * Keep the room-exs of a house, and only trace the changed ones again after editing its nodes and walls.
+         * 
+         * It traces all walls of the house like `algorithm::extractRoomExs`, and gives every room-ex a stable id.
+         * The edits only mark the room-exs whose half-edges are changed, and `update` traces them again and reports
+         * which room-exs are created, destroyed or modified.
+         */
+        template<typename TConstant = constant<>>
+        class room_ex_tracker
+        {
+        public:
+            typedef algorithm<TConstant>                        algorithm_type;
+            typedef typename TConstant::precision_type          precision_type;
+            typedef typename TConstant::point_type              point_type;
+            typedef typename TConstant::id_type                 id_type;
+            typedef typename algorithm_type::node_type          node_type;
+            typedef typename algorithm_type::wall_type          wall_type;
+            typedef typename algorithm_type::room_type          room_type;
+            typedef typename algorithm_type::house_type         house_type;
+            typedef typename algorithm_type::wall_ex            wall_ex;
+            typedef typename algorithm_type::room_ex            room_ex;
+            typedef typename algorithm_type::room_ex_vector     room_ex_vector;
+            typedef typename algorithm_type::wall_room_index    wall_room_index;
+            typedef std::map<size_t, room_ex>                   room_ex_map;
+
+            /*!
+             * The ids of the room-exs which are changed by `update`
+             */
+            class change_set
+            {
+            public:
+                change_set()
+                    : created()
+                    , destroyed()
+                    , modified()
+                {}
+
+            public:
+                inline void clear()
+                {
+                    created.clear();
+                    destroyed.clear();
+                    modified.clear();
+                }
+
+                inline bool empty() const
+                {
+                    return (created.empty() && destroyed.empty() && modified.empty());
+                }
+
+            public:
+                std::vector<size_t>     created;
+                std::vector<size_t>     destroyed;
+                std::vector<size_t>     modified;
+            };
+
+        private:
+            static const size_t none_index = static_cast<size_t>(-1);
+
+            /// The half-edges of a wall are `2 * i` and `2 * i + 1`
+            class half_edge
+            {
+            public:
+                half_edge()
+                    : source(TConstant::none_id)
+                    , target(TConstant::none_id)
+                    , wall()
+                    , face(none_index)
+                    , next(none_index)
+                    , alive(false)
+                {}
+
+            public:
+                id_type     source;
+                id_type     target;
+                wall_ex     wall;
+                size_t      face;   ///< The id of its room-ex
+                size_t      next;   ///< The next half-edge when it was traced
+                bool        alive;
+            };
+
+        public:
+            room_ex_tracker()
+                : house()
+                , room_index()
+                , room_exs()
+                , half_edges()
+                , free_half_edges()
+                , wall_half_edges()
+                , node_rotations()
+                , face_half_edges()
+                , dirty_faces()
+                , touched_nodes()
+                , moved_nodes()
+                , new_half_edges()
+                , rooms_dirty(false)
+                , next_face_id(0)
+            {}
+
+        public:
+            /*!
+             * The house with all edits
+             */
+            inline const house_type& model() const
+            {
+                return house;
+            }
+
+            /*!
+             * The room-exs by their ids, they are valid after `update`
+             */
+            inline const room_ex_map& roomExs() const
+            {
+                return room_exs;
+            }
+
+            /*!
+             * The index of the rooms of the house, it is valid after `update`
+             */
+            inline const wall_room_index& roomIndex() const
+            {
+                return room_index;
+            }
+
+            /*!
+             * Trace all walls of a house, and forget all room-exs before.
+             * 
+             * @param _house The house
+             */
+            bool reset(const house_type& _house)
+            {
+                house = _house;
+                room_index.build(house);
+                room_exs.clear();
+                half_edges.clear();
+                free_half_edges.clear();
+                wall_half_edges.clear();
+                node_rotations.clear();
+                face_half_edges.clear();
+                clearDirty();
+                next_face_id = 0;
+                for (typename house_type::wall_map::const_iterator cit = house.walls.cbegin(); cit != house.walls.cend(); ++cit)
+                {
+                    if (!attachWall(cit->first, cit->second))
+                    {
+                        throw std::invalid_argument("contains invalid wall!");
+                    }
+                }
+                change_set bim_changes;
+                update(bim_changes);
+                return !room_exs.empty();
+            }
+
+            bool insertNode(id_type _node_id, const node_type& _node)
+            {
+                return house.nodes.insert(std::make_pair(_node_id, _node)).second;
+            }
+
+            /*!
+             * Move a node, all room-exs around it are modified.
+             */
+            bool moveNode(id_type _node_id, const point_type& _point)
+            {
+                typename house_type::node_map::iterator it_found = house.nodes.find(_node_id);
+                if (it_found == house.nodes.end())
+                {
+                    return false;
+                }
+                it_found->second.x(_point.x()).y(_point.y());
+                moved_nodes.insert(_node_id);
+                touched_nodes.insert(_node_id);
+                typename std::map<id_type, std::vector<size_t>>::iterator it_rotation = node_rotations.find(_node_id);
+                if (it_rotation == node_rotations.end())
+                {
+                    return true;
+                }
+                sortRotation(_node_id, it_rotation->second);
+                for (size_t bim_half_edge : it_rotation->second)
+                {
+                    const id_type bim_target = half_edges[bim_half_edge].target;
+                    touched_nodes.insert(bim_target);
+                    sortRotation(bim_target, node_rotations[bim_target]);
+                    markFace(bim_half_edge);
+                    markFace(bim_half_edge ^ 1);
+                }
+                return true;
+            }
+
+            /*!
+             * Erase a node and all walls on it.
+             */
+            bool eraseNode(id_type _node_id)
+            {
+                if (house.nodes.find(_node_id) == house.nodes.end())
+                {
+                    return false;
+                }
+                typename std::map<id_type, std::vector<size_t>>::iterator it_rotation = node_rotations.find(_node_id);
+                if (it_rotation != node_rotations.end())
+                {
+                    const std::vector<size_t> bim_half_edges = it_rotation->second;
+                    for (size_t bim_half_edge : bim_half_edges)
+                    {
+                        eraseWall(half_edges[bim_half_edge].wall.id);
+                    }
+                    node_rotations.erase(_node_id);
+                }
+                touched_nodes.erase(_node_id);
+                moved_nodes.erase(_node_id);
+                house.nodes.erase(_node_id);
+                return true;
+            }
+
+            bool insertWall(id_type _wall_id, const wall_type& _wall)
+            {
+                if (house.walls.find(_wall_id) != house.walls.end())
+                {
+                    return false;
+                }
+                if (!attachWall(_wall_id, _wall))
+                {
+                    return false;
+                }
+                house.walls.insert(std::make_pair(_wall_id, _wall));
+                return true;
+            }
+
+            /*!
+             * Erase a wall, and the holes on it.
+             */
+            bool eraseWall(id_type _wall_id)
+            {
+                typename std::map<id_type, size_t>::iterator it_found = wall_half_edges.find(_wall_id);
+                if (it_found == wall_half_edges.end())
+                {
+                    return false;
+                }
+                const size_t bim_half_edge = it_found->second;
+                wall_half_edges.erase(it_found);
+                for (size_t bim_each : { bim_half_edge, bim_half_edge ^ 1 })
+                {
+                    half_edge& bim_each_half_edge = half_edges[bim_each];
+                    markFace(bim_each);
+                    touched_nodes.insert(bim_each_half_edge.source);
+                    std::vector<size_t>& bim_rotation = node_rotations[bim_each_half_edge.source];
+                    bim_rotation.erase(std::find(bim_rotation.begin(), bim_rotation.end(), bim_each));
+                    bim_each_half_edge.alive = false;
+                }
+                free_half_edges.push_back(bim_half_edge);
+
+                house.walls.erase(_wall_id);
+                for (typename house_type::hole_map::iterator it = house.holes.begin(); it != house.holes.end();)
+                {
+                    if (it->second.wall_id == _wall_id)
+                    {
+                        const id_type bim_hole_id = it->first;
+                        ++it;
+                        house.holes.erase(bim_hole_id);
+                    }
+                    else
+                    {
+                        ++it;
+                    }
+                }
+                return true;
+            }
+
+            /*!
+             * Set a room, the ids of all room-exs are found again by `update`.
+             */
+            void setRoom(id_type _room_id, const room_type& _room)
+            {
+                house.rooms.erase(_room_id);
+                house.rooms.insert(std::make_pair(_room_id, _room));
+                rooms_dirty = true;
+            }
+
+            bool eraseRoom(id_type _room_id)
+            {
+                if (house.rooms.erase(_room_id) == 0)
+                {
+                    return false;
+                }
+                rooms_dirty = true;
+                return true;
+            }
+
+            /*!
+             * Trace the room-exs which are marked by the edits again.
+             * 
+             * @param _changes Output the ids of the created, destroyed and modified room-exs
+             */
+            void update(change_set& _changes)
+            {
+                _changes.clear();
+                if (rooms_dirty)
+                {
+                    room_index.build(house);
+                }
+
+                /// a room-ex is changed if the next one of any its half-edge is changed
+                for (id_type bim_node_id : touched_nodes)
+                {
+                    typename std::map<id_type, std::vector<size_t>>::const_iterator cit_rotation = node_rotations.find(bim_node_id);
+                    if (cit_rotation == node_rotations.end()) continue;
+                    for (size_t bim_half_edge : cit_rotation->second)
+                    {
+                        const size_t bim_in_half_edge = bim_half_edge ^ 1;
+                        if (half_edges[bim_in_half_edge].face != none_index
+                            && half_edges[bim_in_half_edge].next != findNextHalfEdge(bim_in_half_edge))
+                        {
+                            dirty_faces.insert(half_edges[bim_in_half_edge].face);
+                        }
+                    }
+                }
+
+                /// release all half-edges of the changed room-exs
+                std::map<size_t, room_ex> bim_old_room_exs;
+                std::map<size_t, size_t> bim_old_faces;
+                std::vector<size_t> bim_candidates(new_half_edges);
+                for (size_t bim_face : dirty_faces)
+                {
+                    typename room_ex_map::iterator it_room_ex = room_exs.find(bim_face);
+                    if (it_room_ex == room_exs.end()) continue;
+                    bim_old_room_exs.insert(std::make_pair(bim_face, it_room_ex->second));
+                    room_exs.erase(it_room_ex);
+                    for (size_t bim_half_edge : face_half_edges[bim_face])
+                    {
+                        half_edge& bim_each_half_edge = half_edges[bim_half_edge];
+                        if (!bim_each_half_edge.alive || bim_each_half_edge.face != bim_face) continue;
+                        bim_each_half_edge.face = none_index;
+                        bim_old_faces[bim_half_edge] = bim_face;
+                        bim_candidates.push_back(bim_half_edge);
+                    }
+                    face_half_edges.erase(bim_face);
+                }
+                std::sort(bim_candidates.begin(), bim_candidates.end());
+                bim_candidates.erase(std::unique(bim_candidates.begin(), bim_candidates.end()), bim_candidates.end());
+                std::sort(bim_candidates.begin(), bim_candidates.end(), [this](size_t _a, size_t _b) { return isLessHalfEdge(_a, _b); });
+
+                /// trace the released half-edges, every new room-ex starts from its smallest half-edge
+                const size_t bim_new_face_base = next_face_id;
+                std::vector<std::vector<size_t>> bim_new_faces;
+                for (size_t bim_first_half_edge : bim_candidates)
+                {
+                    if (!half_edges[bim_first_half_edge].alive || half_edges[bim_first_half_edge].face != none_index) continue;
+                    const size_t bim_face = bim_new_face_base + bim_new_faces.size();
+                    bim_new_faces.push_back(std::vector<size_t>());
+                    std::vector<size_t>& bim_face_half_edges = bim_new_faces.back();
+                    size_t bim_half_edge = bim_first_half_edge;
+                    do
+                    {
+                        const size_t bim_next_half_edge = findNextHalfEdge(bim_half_edge);
+                        half_edges[bim_half_edge].next = bim_next_half_edge;
+                        bim_half_edge = bim_next_half_edge;
+                        assert(half_edges[bim_half_edge].face == none_index);
+                        half_edges[bim_half_edge].face = bim_face;
+                        bim_face_half_edges.push_back(bim_half_edge);
+                    } while (bim_half_edge != bim_first_half_edge);
+                }
+
+                room_ex_vector bim_new_room_exs(bim_new_faces.size());
+                for (size_t f = 0, fc = bim_new_faces.size(); f < fc; ++f)
+                {
+                    makeRoomEx(bim_new_face_base + f, bim_new_faces[f], bim_new_room_exs[f]);
+                }
+                algorithm_type::assignRoomExIds(room_index, bim_new_room_exs);
+
+                /// a new room-ex keeps the id of the old one which has the most same half-edges
+                std::set<size_t> bim_taken_faces;
+                for (size_t f = 0, fc = bim_new_faces.size(); f < fc; ++f)
+                {
+                    std::map<size_t, size_t> bim_old_faces_2_counts;
+                    for (size_t bim_half_edge : bim_new_faces[f])
+                    {
+                        typename std::map<size_t, size_t>::const_iterator cit_found = bim_old_faces.find(bim_half_edge);
+                        if (cit_found == bim_old_faces.end() || bim_taken_faces.count(cit_found->second) != 0) continue;
+                        ++bim_old_faces_2_counts[cit_found->second];
+                    }
+                    size_t bim_face = none_index;
+                    size_t bim_max_count = 0;
+                    for (const std::pair<const size_t, size_t>& bim_old_face_2_count : bim_old_faces_2_counts)
+                    {
+                        if (bim_old_face_2_count.second > bim_max_count)
+                        {
+                            bim_face = bim_old_face_2_count.first;
+                            bim_max_count = bim_old_face_2_count.second;
+                        }
+                    }
+
+                    room_ex& bim_room_ex = bim_new_room_exs[f];
+                    if (bim_face == none_index)
+                    {
+                        bim_face = next_face_id++;
+                        _changes.created.push_back(bim_face);
+                    }
+                    else
+                    {
+                        bim_taken_faces.insert(bim_face);
+                        if (!isSameRoomEx(bim_old_room_exs[bim_face], bim_room_ex) || isMoved(bim_new_faces[f]))
+                        {
+                            _changes.modified.push_back(bim_face);
+                        }
+                    }
+                    for (size_t bim_half_edge : bim_new_faces[f])
+                    {
+                        half_edges[bim_half_edge].face = bim_face;
+                    }
+                    face_half_edges[bim_face].swap(bim_new_faces[f]);
+                    room_exs[bim_face] = bim_room_ex;
+                }
+                for (const std::pair<const size_t, room_ex>& bim_old_room_ex : bim_old_room_exs)
+                {
+                    if (bim_taken_faces.count(bim_old_room_ex.first) == 0)
+                    {
+                        _changes.destroyed.push_back(bim_old_room_ex.first);
+                    }
+                }
+
+                if (rooms_dirty)
+                {
+                    room_ex_vector bim_room_exs;
+                    for (const std::pair<const size_t, room_ex>& bim_room_ex : room_exs)
+                    {
+                        bim_room_exs.push_back(bim_room_ex.second);
+                        bim_room_exs.back().id = TConstant::none_id;
+                    }
+                    algorithm_type::assignRoomExIds(room_index, bim_room_exs);
+                    size_t i = 0;
+                    for (std::pair<const size_t, room_ex>& bim_room_ex : room_exs)
+                    {
+                        if (bim_room_ex.second.id != bim_room_exs[i].id)
+                        {
+                            bim_room_ex.second.id = bim_room_exs[i].id;
+                            if (std::find(_changes.created.begin(), _changes.created.end(), bim_room_ex.first) == _changes.created.end()
+                                && std::find(_changes.modified.begin(), _changes.modified.end(), bim_room_ex.first) == _changes.modified.end())
+                            {
+                                _changes.modified.push_back(bim_room_ex.first);
+                            }
+                        }
+                        ++i;
+                    }
+                }
+
+                std::sort(_changes.modified.begin(), _changes.modified.end());
+                clearDirty();
+            }
+
+        private:
+            inline const node_type& findNode(id_type _node_id) const
+            {
+                return house.nodes.find(_node_id)->second;
+            }
+
+            inline void markFace(size_t _half_edge)
+            {
+                if (half_edges[_half_edge].face != none_index)
+                {
+                    dirty_faces.insert(half_edges[_half_edge].face);
+                }
+            }
+
+            inline void clearDirty()
+            {
+                dirty_faces.clear();
+                touched_nodes.clear();
+                moved_nodes.clear();
+                new_half_edges.clear();
+                rooms_dirty = false;
+            }
+
+            /// add the half-edges of a wall, and insert them into the sorted half-edges of its nodes
+            bool attachWall(id_type _wall_id, const wall_type& _wall)
+            {
+                if (!_wall.isValid()
+                    || house.nodes.find(_wall.start_node_id) == house.nodes.end()
+                    || house.nodes.find(_wall.end_node_id) == house.nodes.end())
+                {
+                    return false;
+                }
+                size_t bim_half_edge = half_edges.size();
+                if (free_half_edges.empty())
+                {
+                    half_edges.resize(half_edges.size() + 2);
+                }
+                else
+                {
+                    bim_half_edge = free_half_edges.back();
+                    free_half_edges.pop_back();
+                }
+                for (size_t i = 0; i < 2; ++i)
+                {
+                    half_edge& bim_each_half_edge = half_edges[bim_half_edge + i];
+                    bim_each_half_edge = half_edge();
+                    bim_each_half_edge.source = (i == 0) ? _wall.start_node_id : _wall.end_node_id;
+                    bim_each_half_edge.target = (i == 0) ? _wall.end_node_id : _wall.start_node_id;
+                    bim_each_half_edge.wall = wall_ex(_wall_id, i != 0);
+                    bim_each_half_edge.alive = true;
+                    std::vector<size_t>& bim_rotation = node_rotations[bim_each_half_edge.source];
+                    bim_rotation.push_back(bim_half_edge + i);
+                    sortRotation(bim_each_half_edge.source, bim_rotation);
+                    touched_nodes.insert(bim_each_half_edge.source);
+                    new_half_edges.push_back(bim_half_edge + i);
+                }
+                wall_half_edges[_wall_id] = bim_half_edge;
+                return true;
+            }
+
+            /// the half-edges are compared by their walls, so the room-exs don't depend on the order of the edits
+            inline bool isLessHalfEdge(size_t _a, size_t _b) const
+            {
+                const wall_ex& bim_a = half_edges[_a].wall;
+                const wall_ex& bim_b = half_edges[_b].wall;
+                return (bim_a.id < bim_b.id || (bim_a.id == bim_b.id && bim_a.inversed < bim_b.inversed));
+            }
+
+            void sortRotation(id_type _node_id, std::vector<size_t>& _rotation) const
+            {
+                const point_type& bim_node_point = findNode(_node_id).p();
+                std::sort(_rotation.begin(), _rotation.end(), [this, &bim_node_point](size_t _a, size_t _b)
+                {
+                    const point_type& bim_point_a = findNode(half_edges[_a].target).p();
+                    const point_type& bim_point_b = findNode(half_edges[_b].target).p();
+                    if (predicates::isLessAngle(bim_node_point, bim_point_a, bim_point_b)) return true;
+                    if (predicates::isLessAngle(bim_node_point, bim_point_b, bim_point_a)) return false;
+                    return isLessHalfEdge(_a, _b);
+                });
+            }
+
+            /// same as `algorithm::buildRotationSystem`, the next one is the first one before its twin in the counterclockwise order
+            size_t findNextHalfEdge(size_t _half_edge) const
+            {
+                const std::vector<size_t>& bim_rotation = node_rotations.find(half_edges[_half_edge].target)->second;
+                const size_t bim_position = static_cast<size_t>(std::find(bim_rotation.begin(), bim_rotation.end(), _half_edge ^ 1) - bim_rotation.begin());
+                return bim_rotation[(bim_position + bim_rotation.size() - 1) % bim_rotation.size()];
+            }
+
+            void makeRoomEx(size_t _face, const std::vector<size_t>& _half_edges, room_ex& _room_ex) const
+            {
+                for (size_t bim_half_edge : _half_edges)
+                {
+                    wall_ex bim_wall_ex = half_edges[bim_half_edge].wall;
+                    bim_wall_ex.repeated = (half_edges[bim_half_edge ^ 1].face == _face);
+                    _room_ex.walls.push_back(bim_wall_ex);
+                }
+                algorithm_type::computeRoomExSideBy(_room_ex
+                    , [this, &_half_edges](size_t _index)
+                    {
+                        const half_edge& bim_half_edge = half_edges[_half_edges[_index]];
+                        return bim_half_edge.wall.inversed
+                            ? std::make_pair(bim_half_edge.target, bim_half_edge.source)
+                            : std::make_pair(bim_half_edge.source, bim_half_edge.target);
+                    }
+                    , [this](id_type _node_id) -> const node_type& { return findNode(_node_id); });
+            }
+
+            static bool isSameRoomEx(const room_ex& _a, const room_ex& _b)
+            {
+                if (_a.id != _b.id || _a.side != _b.side || _a.walls.size() != _b.walls.size())
+                {
+                    return false;
+                }
+                for (size_t i = 0, ic = _a.walls.size(); i < ic; ++i)
+                {
+                    if (!(_a.walls[i] == _b.walls[i]) || _a.walls[i].repeated != _b.walls[i].repeated)
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            bool isMoved(const std::vector<size_t>& _half_edges) const
+            {
+                for (size_t bim_half_edge : _half_edges)
+                {
+                    if (moved_nodes.count(half_edges[bim_half_edge].source) != 0) return true;
+                }
+                return false;
+            }
+
+        private:
+            house_type                                  house;
+            wall_room_index                             room_index;
+            room_ex_map                                 room_exs;
+            std::vector<half_edge>                      half_edges;
+            std::vector<size_t>                         free_half_edges;    ///< The first half-edges of the erased walls
+            std::map<id_type, size_t>                   wall_half_edges;    ///< The first half-edge of every wall
+            std::map<id_type, std::vector<size_t>>      node_rotations;     ///< The half-edges from every node, sorted by angle
+            std::map<size_t, std::vector<size_t>>       face_half_edges;
+            std::set<size_t>                            dirty_faces;
+            std::set<id_type>                           touched_nodes;      ///< The nodes whose sorted half-edges are changed
+            std::set<id_type>                           moved_nodes;
+            std::vector<size_t>                         new_half_edges;
+            bool                                        rooms_dirty;
+            size_t                                      next_face_id;
+        };
+
+        /*!
+         * A spatial index of the walls and the room-exs of a house.
+         * 
+         * It finds the room-ex at a point, the nearest wall to a point, and the walls or the room-exs in a box.
+         * The walls and the room-exs are stored in two `box_tree`, and the polygons of the room-exs are kept in flat arrays.
+         * It must be built again after the house or the room-exs are changed, and all queries can be called by many threads at the same time.
+         */
+        template<typename TConstant = constant<>>
+        class spatial_index
+        {
+        public:
+            typedef algorithm<TConstant>                        algorithm_type;
+            typedef typename TConstant::precision_type          precision_type;
+            typedef typename TConstant::point_type              point_type;
+            typedef typename TConstant::id_type                 id_type;
+            typedef typename algorithm_type::id_vector          id_vector;
+            typedef typename algorithm_type::wall_type          wall_type;
+            typedef typename algorithm_type::house_type         house_type;
+            typedef typename algorithm_type::wall_ex            wall_ex;
+            typedef typename algorithm_type::room_ex            room_ex;
+            typedef typename algorithm_type::room_ex_vector     room_ex_vector;
+            typedef box_tree<precision_type>                    tree_type;
+
+            static const size_t none_index = static_cast<size_t>(-1);
+
+        public:
+            spatial_index()
+                : wall_ids()
+                , wall_points()
+                , wall_tree()
+                , room_ex_indices()
+                , room_offsets()
+                , room_points()
+                , room_areas()
+                , room_tree()
+            {}
+
+        public:
+            inline void clear()
+            {
+                wall_ids.clear();
+                wall_points.clear();
+                wall_tree.clear();
+                room_ex_indices.clear();
+                room_offsets.clear();
+                room_points.clear();
+                room_areas.clear();
+                room_tree.clear();
+            }
+
+            /*!
+             * Build the index by all valid walls of a house and its room-exs, only the room-exs of `room_side_in` can be found at a point.
+             * 
+             * @param _house The house
+             * @param _room_exs The room-exs of the house, the results of the queries are their indices
+             * @param _pool Build the walls, the polygons and the trees in parallel if it is not null
+             */
+            void build(const house_type& _house, const room_ex_vector& _room_exs, thread_pool* _pool = nullptr)
+            {
+                clear();
+                std::vector<const wall_type*> bim_walls;
+                for (typename house_type::wall_map::const_iterator cit = _house.walls.cbegin(); cit != _house.walls.cend(); ++cit)
+                {
+                    if (!cit->second.isValid()) continue;
+                    wall_ids.push_back(cit->first);
+                    bim_walls.push_back(&cit->second);
+                }
+                wall_points.resize(wall_ids.size() * 2);
+                std::vector<precision_type> bim_boxes(wall_ids.size() * 4);
+                parallelFor(_pool, wall_ids.size(), [&](size_t _index)
+                {
+                    const typename house_type::node_map::const_iterator cit_start_node = _house.nodes.find(bim_walls[_index]->start_node_id);
+                    const typename house_type::node_map::const_iterator cit_end_node = _house.nodes.find(bim_walls[_index]->end_node_id);
+                    if (cit_start_node == _house.nodes.cend() || cit_end_node == _house.nodes.cend())
+                    {
+                        throw std::invalid_argument("contains invalid node!");
+                    }
+                    wall_points[_index * 2] = cit_start_node->second.p();
+                    wall_points[_index * 2 + 1] = cit_end_node->second.p();
+                    makeBox(&wall_points[_index * 2], 2, &bim_boxes[_index * 4]);
+                });
+                wall_tree.build(bim_boxes, _pool);
+
+                /// the polygons are gathered the same way as `algorithm::computeRoomExHierarchy` does
+                room_offsets.push_back(0);
+                for (size_t i = 0, ic = _room_exs.size(); i < ic; ++i)
+                {
+                    if (_room_exs[i].side != algorithm_type::room_side_in || _room_exs[i].walls.empty()) continue;
+                    room_ex_indices.push_back(i);
+                    room_offsets.push_back(room_offsets.back() + _room_exs[i].walls.size());
+                }
+                room_points.resize(room_offsets.back());
+                room_areas.resize(room_ex_indices.size());
+                bim_boxes.assign(room_ex_indices.size() * 4, 0);
+                parallelFor(_pool, room_ex_indices.size(), [&](size_t _index)
+                {
+                    room_areas[_index] = algorithm_type::gatherRoomExPolygon(_house, _room_exs[room_ex_indices[_index]]
+                        , &room_points[room_offsets[_index]], &bim_boxes[_index * 4]);
+                });
+                room_tree.build(bim_boxes, _pool);
+            }
+
+            /*!
+             * Find the room-ex which contains a point, the smallest one is chosen if some room-exs contain it.
+             * The test is exact, see `algorithm::isInPolygon`.
+             * 
+             * @return The index of the room-ex, or `none_index` if it is not found
+             */
+            size_t findRoomEx(const point_type& _point) const
+            {
+                size_t bim_found = none_index;
+                room_tree.query(_point.x(), _point.y(), _point.x(), _point.y(), [&](size_t _index)
+                {
+                    if (bim_found != none_index && room_areas[bim_found] <= room_areas[_index]) return;
+                    if (algorithm_type::isInPolygon(&room_points[room_offsets[_index]], room_offsets[_index + 1] - room_offsets[_index], _point))
+                    {
+                        bim_found = _index;
+                    }
+                });
+                return (bim_found == none_index) ? none_index : room_ex_indices[bim_found];
+            }
+
+            /*!
+             * Find the room-exs of many points, see `findRoomEx`.
+             * 
+             * @param _points The points
+             * @param _indices Output the index of the room-ex of every point
+             * @param _pool Find them in parallel if it is not null
+             */
+            void findRoomExs(const std::vector<point_type>& _points, std::vector<size_t>& _indices, thread_pool* _pool = nullptr) const
+            {
+                _indices.resize(_points.size());
+                parallelFor(_pool, _points.size(), [this, &_points, &_indices](size_t _index)
+                {
+                    _indices[_index] = findRoomEx(_points[_index]);
+                });
+            }
+
+            /*!
+             * Find the room-exs whose boxes intersect a box.
+             * 
+             * @param _min The min point of the box
+             * @param _max The max point of the box
+             * @param _indices Output the indices of the room-exs
+             */
+            void findRoomExs(const point_type& _min, const point_type& _max, std::vector<size_t>& _indices) const
+            {
+                _indices.clear();
+                room_tree.query(_min.x(), _min.y(), _max.x(), _max.y(), [this, &_indices](size_t _index)
+                {
+                    _indices.push_back(room_ex_indices[_index]);
+                });
+            }
+
+            /*!
+             * Find the nearest wall to a point.
+             * 
+             * @param _point The point
+             * @param _distance Output the distance to the wall if it is not null
+             * @return The id of the wall, or `none_id` if there is no wall
+             */
+            id_type findNearestWall(const point_type& _point, precision_type* _distance = nullptr) const
+            {
+                precision_type bim_distance_2 = std::numeric_limits<precision_type>::max();
+                const size_t bim_index = wall_tree.nearest(_point.x(), _point.y(), [this, &_point](size_t _index)
+                {
+                    return calculateDistance2(wall_points[_index * 2], wall_points[_index * 2 + 1], _point);
+                }, bim_distance_2);
+                if (bim_index == wall_tree.size())
+                {
+                    return TConstant::none_id;
+                }
+                if (_distance != nullptr)
+                {
+                    *_distance = std::sqrt(bim_distance_2);
+                }
+                return wall_ids[bim_index];
+            }
+
+            /*!
+             * Find the nearest walls to many points, see `findNearestWall`.
+             * 
+             * @param _points The points
+             * @param _wall_ids Output the id of the nearest wall to every point
+             * @param _pool Find them in parallel if it is not null
+             */
+            void findNearestWalls(const std::vector<point_type>& _points, id_vector& _wall_ids, thread_pool* _pool = nullptr) const
+            {
+                _wall_ids.resize(_points.size());
+                parallelFor(_pool, _points.size(), [this, &_points, &_wall_ids](size_t _index)
+                {
+                    _wall_ids[_index] = findNearestWall(_points[_index]);
+                });
+            }
+
+            /*!
+             * Find the walls which intersect a box.
+             * 
+             * @param _min The min point of the box
+             * @param _max The max point of the box
+             * @param _wall_ids Output the ids of the walls
+             */
+            void findWalls(const point_type& _min, const point_type& _max, id_vector& _wall_ids) const
+            {
+                _wall_ids.clear();
+                wall_tree.query(_min.x(), _min.y(), _max.x(), _max.y(), [this, &_min, &_max, &_wall_ids](size_t _index)
+                {
+                    if (isSegmentInBox(wall_points[_index * 2], wall_points[_index * 2 + 1], _min, _max))
+                    {
+                        _wall_ids.push_back(wall_ids[_index]);
+                    }
+                });
+            }
+
+        private:
+            template<typename TFunc>
+            static void parallelFor(thread_pool* _pool, size_t _count, const TFunc& _func)
+            {
+                if (_pool != nullptr)
+                {
+                    _pool->parallelFor(_count, _func);
+                    return;
+                }
+                for (size_t i = 0; i < _count; ++i)
+                {
+                    _func(i);
+                }
+            }
+
+            static void makeBox(const point_type* _points, size_t _count, precision_type* _box)
+            {
+                _box[0] = _box[2] = _points[0].x();
+                _box[1] = _box[3] = _points[0].y();
+                for (size_t i = 1; i < _count; ++i)
+                {
+                    _box[0] = std::min(_box[0], _points[i].x());
+                    _box[1] = std::min(_box[1], _points[i].y());
+                    _box[2] = std::max(_box[2], _points[i].x());
+                    _box[3] = std::max(_box[3], _points[i].y());
+                }
+            }
+
+            /// the squared distance from a point to a segment
+            static precision_type calculateDistance2(const point_type& _a, const point_type& _b, const point_type& _point)
+            {
+                const precision_type bim_dx = _b.x() - _a.x();
+                const precision_type bim_dy = _b.y() - _a.y();
+                precision_type bim_px = _point.x() - _a.x();
+                precision_type bim_py = _point.y() - _a.y();
+                const precision_type bim_length_2 = bim_dx * bim_dx + bim_dy * bim_dy;
+                if (bim_length_2 > 0)
+                {
+                    const precision_type bim_t = std::min(std::max((bim_px * bim_dx + bim_py * bim_dy) / bim_length_2, static_cast<precision_type>(0)), static_cast<precision_type>(1));
+                    bim_px -= bim_dx * bim_t;
+                    bim_py -= bim_dy * bim_t;
+                }
+                return bim_px * bim_px + bim_py * bim_py;
+            }
+
+            /// clip the segment by the box (Liang-Barsky)
+            static bool isSegmentInBox(const point_type& _a, const point_type& _b, const point_type& _min, const point_type& _max)
+            {
+                precision_type bim_t0 = 0;
+                precision_type bim_t1 = 1;
+                const precision_type bim_d[2] = { _b.x() - _a.x(), _b.y() - _a.y() };
+                const precision_type bim_a[2] = { _a.x(), _a.y() };
+                const precision_type bim_min[2] = { _min.x(), _min.y() };
+                const precision_type bim_max[2] = { _max.x(), _max.y() };
+                for (size_t i = 0; i < 2; ++i)
+                {
+                    if (bim_d[i] == 0)
+                    {
+                        if (bim_a[i] < bim_min[i] || bim_a[i] > bim_max[i]) return false;
+                        continue;
+                    }
+                    precision_type bim_near = (bim_min[i] - bim_a[i]) / bim_d[i];
+                    precision_type bim_far = (bim_max[i] - bim_a[i]) / bim_d[i];
+                    if (bim_near > bim_far) std::swap(bim_near, bim_far);
+                    bim_t0 = std::max(bim_t0, bim_near);
+                    bim_t1 = std::min(bim_t1, bim_far);
+                    if (bim_t0 > bim_t1) return false;
+                }
+                return true;
+            }
+
+        private:
+            id_vector                   wall_ids;
+            std::vector<point_type>     wall_points;        ///< The start node and the end node of every wall
+            tree_type                   wall_tree;
+            std::vector<size_t>         room_ex_indices;    ///< The index of every indexed room-ex in the room-exs
+            std::vector<size_t>         room_offsets;       ///< The points of the polygon `i` are `[room_offsets[i], room_offsets[i + 1])` of `room_points`
+            std::vector<point_type>     room_points;
+            std::vector<precision_type> room_areas;
+            tree_type                   room_tree;
         };
 
+        /*!
+         * The adjacency graph of the rooms of a house, two rooms are adjacent if they share walls.
+         * 
+         * The rooms are numbered by the order of their ids, and the neighbours of the room `i` are stored in
+         * `[offsets[i], offsets[i + 1])` of `neighbours` from small to big, with the links to them in `links`.
+         * Every link keeps the walls between its two rooms in `[wall_offsets[l], wall_offsets[l + 1])` of `wall_ids`,
+         * and the valid holes on these walls in `[hole_offsets[l], hole_offsets[l + 1])` of `hole_ids`,
+         * they are usually doors or windows, see `hole::kind`.
+         * The walls of the rooms are kept in an inverted index, so `updateRooms` only reads the changed rooms again.
+         */
         template<typename TConstant = constant<>>
-        class algorithm
+        class room_graph
         {
         public:
-            typedef typename TConstant::precision_type  precision_type;
-            typedef typename TConstant::point_type      point_type;
-            typedef typename TConstant::id_type         id_type;
-            typedef std::vector<id_type>                id_vector;
-            typedef node<TConstant>                     node_type;
-            typedef wall<TConstant>                     wall_type;
-            typedef room<TConstant>                     room_type;
-            typedef house<TConstant>                    house_type;
+            typedef algorithm<TConstant>                        algorithm_type;
+            typedef typename TConstant::id_type                 id_type;
+            typedef typename algorithm_type::id_vector          id_vector;
+            typedef typename algorithm_type::house_type         house_type;
+            typedef typename algorithm_type::wall_ex            wall_ex;
+            typedef typename algorithm_type::room_ex            room_ex;
+            typedef typename algorithm_type::room_ex_vector     room_ex_vector;
 
-        public:
-            class wall_ex
+            static const size_t none_index = static_cast<size_t>(-1);
+
+        private:
+            /// A wall between two rooms, the rooms are their indices and `first` is less than `second`
+            class wall_link
             {
             public:
-                wall_ex(id_type _id = TConstant::none_id, bool _inversed = false)
-                    : id(_id)
-                    , inversed(_inversed)
-                    , repeated(false)
+                wall_link(size_t _first = 0, size_t _second = 0, id_type _wall_id = TConstant::none_id)
+                    : first(_first)
+                    , second(_second)
+                    , wall_id(_wall_id)
                 {}
 
             public:
-                bool operator==(const wall_ex& _a) const
-                {
-                    return (id == _a.id && inversed == _a.inversed);
-                }
-
-            public:
-                id_type     id;
-                bool        inversed;
-                bool        repeated;
+                size_t      first;
+                size_t      second;
+                id_type     wall_id;
             };
 
-            /*!
-             * An enum, it means the direction of the room's edges.
-             */
-            enum room_side
+        public:
+            room_graph()
+                : room_ids()
+                , offsets()
+                , neighbours()
+                , links()
+                , link_rooms()
+                , wall_offsets()
+                , wall_ids()
+                , hole_offsets()
+                , hole_ids()
+                , walls_2_rooms()
+            {}
+
+        public:
+            inline void clear()
             {
-                room_side_both,     ///< Don't know the room faces inside or outside
-                room_side_in,       ///< The room faces inside
-                room_side_out,      ///< The room faces outside
-            };
+                room_ids.clear();
+                offsets.clear();
+                neighbours.clear();
+                links.clear();
+                link_rooms.clear();
+                wall_offsets.clear();
+                wall_ids.clear();
+                hole_offsets.clear();
+                hole_ids.clear();
+                walls_2_rooms.clear();
+            }
 
-            class room_ex
+            inline size_t roomCount() const
             {
-            public:
-                room_ex()
-                    : id(TConstant::none_id)
-                    , walls()
-                    , side(room_side_both)
-                {}
+                return room_ids.size();
+            }
 
-            public:
-                id_type                 id;
-                std::vector<wall_ex>    walls;
-                room_side               side;
-            };
+            inline size_t linkCount() const
+            {
+                return link_rooms.size();
+            }
 
-            class node_ex
+            /*!
+             * Build the graph by the walls of all rooms of a house.
+             * 
+             * @param _house The house
+             */
+            void build(const house_type& _house)
             {
-            public:
-                node_ex(id_type _id = TConstant::none_id
-                    , bool _used = false)
-                    : id(_id)
-                    , used(_used)
-                    , with_wall()
-                {}
+                clear();
+                for (typename house_type::room_map::const_iterator cit = _house.rooms.cbegin(); cit != _house.rooms.cend(); ++cit)
+                {
+                    room_ids.push_back(cit->first);
+                }
+                addRoomWalls(_house, room_ids, walls_2_rooms);
+                std::sort(walls_2_rooms.begin(), walls_2_rooms.end());
+                walls_2_rooms.erase(std::unique(walls_2_rooms.begin(), walls_2_rooms.end()), walls_2_rooms.end());
+                link(_house);
+            }
 
-            public:
-                bool operator==(const node_ex& _a) const
+            /*!
+             * Build the graph by the room-exs of a house, only the walls which are really traced around a room are used.
+             * 
+             * @param _house The house
+             * @param _room_exs The room-exs of the house, their ids are the rooms, see `algorithm::computeRoomExs`
+             */
+            void build(const house_type& _house, const room_ex_vector& _room_exs)
+            {
+                clear();
+                for (typename house_type::room_map::const_iterator cit = _house.rooms.cbegin(); cit != _house.rooms.cend(); ++cit)
                 {
-                    return (id == _a.id
-                        && used == _a.used
-                        && with_wall == _a.with_wall);
+                    room_ids.push_back(cit->first);
                 }
+                addRoomExWalls(_room_exs, room_ids, walls_2_rooms);
+                std::sort(walls_2_rooms.begin(), walls_2_rooms.end());
+                walls_2_rooms.erase(std::unique(walls_2_rooms.begin(), walls_2_rooms.end()), walls_2_rooms.end());
+                link(_house);
+            }
 
-            public:
-                id_type     id;
-                bool        used;
-                wall_ex     with_wall;
-            };
+            /*!
+             * Read some rooms of a house again after they are inserted, changed or erased.
+             * 
+             * Only the walls of these rooms are read, and the links are made again by the inverted index in \f$ O(W) \f$.
+             * The holes are read again too, so it also updates the graph after the holes are changed.
+             * 
+             * @param _house The house
+             * @param _room_ids The ids of the changed rooms
+             */
+            void updateRooms(const house_type& _house, const id_vector& _room_ids)
+            {
+                update(_house, _room_ids, [&_house](const id_vector& _rooms, std::vector<std::pair<id_type, id_type>>& _walls_2_rooms)
+                {
+                    addRoomWalls(_house, _rooms, _walls_2_rooms);
+                });
+            }
 
-        public:
-            typedef std::vector<room_ex>               room_ex_vector;
+            /*!
+             * Read some rooms again by their room-exs, see `updateRooms` and `build`.
+             * 
+             * @param _house The house
+             * @param _room_exs The room-exs of the house, only the ones of the changed rooms are used
+             * @param _room_ids The ids of the changed rooms
+             */
+            void updateRooms(const house_type& _house, const room_ex_vector& _room_exs, const id_vector& _room_ids)
+            {
+                update(_house, _room_ids, [&_room_exs](const id_vector& _rooms, std::vector<std::pair<id_type, id_type>>& _walls_2_rooms)
+                {
+                    addRoomExWalls(_room_exs, _rooms, _walls_2_rooms);
+                });
+            }
 
-        public:
-            template<typename TItem>
-            static void addUnique(std::vector<TItem>& _v, const TItem& _i)
+            /*!
+             * Find the index of a room, return `none_index` if it is not found.
+             */
+            inline size_t findRoomIndex(id_type _room_id) const
             {
-                typename std::vector<TItem>::iterator it_found = std::find(_v.begin(), _v.end(), _i);
-                if (it_found != _v.end()) return;
-                _v.push_back(_i);
+                typename id_vector::const_iterator cit_found = std::lower_bound(room_ids.cbegin(), room_ids.cend(), _room_id);
+                if (cit_found == room_ids.cend() || *cit_found != _room_id)
+                {
+                    return none_index;
+                }
+                return static_cast<size_t>(cit_found - room_ids.cbegin());
             }
 
             /*!
-             * Is the `_all` contains `_sub`?
-             * 
-             * **Importance**: The `_all` and `_sub` must be sorted from small to big.
+             * Find the link between two rooms.
              * 
-             * @param _all A vector contains all items
-             * @param _sub A vector contains a part of items
+             * @return The index of the link, or `none_index` if they are not adjacent
              */
-            template<typename TItem>
-            static bool isContainsForBiggerVector(const std::vector<TItem>& _all, const std::vector<TItem>& _sub)
+            size_t findLink(id_type _a, id_type _b) const
             {
-                if (_all.empty() || _sub.empty()) return false;
-                if (_all.size() < _sub.size()) return false;
-                size_t a_index = 0;
-                size_t s_index = 0;
-                const size_t a_size = _all.size();
-                const size_t s_size = _sub.size();
-                while (a_index < a_size
-                    && s_index < s_size
-                    && _all[a_index] <= _sub[s_index])
+                const size_t bim_a = findRoomIndex(_a);
+                const size_t bim_b = findRoomIndex(_b);
+                if (bim_a == none_index || bim_b == none_index)
                 {
-                    if (_all[a_index] == _sub[s_index])
-                    {
-                        ++s_index;
-                    }
-                    else
-                    {
-                        ++a_index;
-                    }
+                    return none_index;
                 }
-                return (s_index == s_size);
+                std::vector<size_t>::const_iterator cit_begin = neighbours.cbegin() + offsets[bim_a];
+                std::vector<size_t>::const_iterator cit_end = neighbours.cbegin() + offsets[bim_a + 1];
+                std::vector<size_t>::const_iterator cit_found = std::lower_bound(cit_begin, cit_end, bim_b);
+                if (cit_found == cit_end || *cit_found != bim_b)
+                {
+                    return none_index;
+                }
+                return links[static_cast<size_t>(cit_found - neighbours.cbegin())];
             }
 
             /*!
-             * Calculate the angle \f$ \alpha \f$ between \f$ \vec{OA} \f$ and \f$ \vec{OB} \f$.
-             * @f[
-             * f(\vec{OA}, \vec{OB}) =
-             * \begin{cases}
-             * \cos^{-1}(\vec{OA} \cdot \vec{OB})               & \quad \text{if } 0^{\circ} \leq \alpha \leq 180^{\circ}\\
-             * \pi * 2 - \cos^{-1}(\vec{OA} \cdot \vec{OB})     & \quad \text{if } 180^{\circ} < \alpha < 360^{\circ}
-             * \end{cases}
-             * @f]
-             *
-             * @param _o The \f$ {O} \f$ node(point)
-             * @param _a The \f$ {A} \f$ node(point)
-             * @param _b The \f$ {B} \f$ node(point)
+             * Find the ids of the rooms which are adjacent to a room, they are sorted.
+             * 
+             * @param _room_id The id of the room
+             * @param _room_ids Output the ids of the adjacent rooms
              */
-            static precision_type calculateAngleEx(const node_type& _o, const node_type& _a, const node_type& _b)
+            bool findNeighbours(id_type _room_id, id_vector& _room_ids) const
             {
-                /// Make the line \f$ \vec{OA} \f$, and normalize it.
-                point_type line_a(_a.p() - _o.p()); line_a.normalize();
-                /// Make the line \f$ \vec{OB} \f$, and normalize it.
-                point_type line_b(_b.p() - _o.p()); line_b.normalize();
-                /// Compute the dot product and the cross product between \f$ \vec{OA} \f$ and \f$ \vec{OB} \f$
-                precision_type sin_res = line_a.dot(line_b);
-                precision_type cos_res = line_a.cross(line_b);
-                precision_type res = static_cast<precision_type>(0);
-                if (sin_res >= 0)
+                _room_ids.clear();
+                const size_t bim_room_index = findRoomIndex(_room_id);
+                if (bim_room_index == none_index)
                 {
-                    res = static_cast<precision_type>(acos(cos_res));
+                    return false;
                 }
-                else
+                for (size_t i = offsets[bim_room_index], ic = offsets[bim_room_index + 1]; i < ic; ++i)
                 {
-                    res = static_cast<precision_type>(M_PI * 2.0 - acos(cos_res));
+                    _room_ids.push_back(room_ids[neighbours[i]]);
                 }
-                return res;
+                return true;
             }
 
             /*!
-             * Calculate the increased sine of a angle \f$ \alpha \f$ between \f$ \vec{OA} \f$ and \f$ \vec{OB} \f$.
-             * @f[
-             * f(\vec{OA}, \vec{OB}) =
-             * \begin{cases}
-             * \vert\vec{OA} \times \vec{OB}\vert         & \quad \text{if } 0^{\circ} \leq \alpha \leq 90^{\circ}\\
-             * 2 - \vert\vec{OA} \times \vec{OB}\vert     & \quad \text{if } 90^{\circ} < \alpha < 270^{\circ}\\
-             * 4 + \vert\vec{OA} \times \vec{OB}\vert     & \quad \text{if } 270^{\circ} \leq \alpha < 360^{\circ}
-             * \end{cases}
-             * @f]
+             * Find the walls between two rooms, they are sorted.
              * 
-             * @param _o The \f$ {O} \f$ node(point)
-             * @param _a The \f$ {A} \f$ node(point)
-             * @param _b The \f$ {B} \f$ node(point)
+             * @param _a The id of a room
+             * @param _b The id of the other room
+             * @param _wall_ids Output the ids of the walls
              */
-            static precision_type calculateSinAngleEx(const node_type& _o, const node_type& _a, const node_type& _b)
+            bool findWalls(id_type _a, id_type _b, id_vector& _wall_ids) const
             {
-                /// Make the line \f$ \vec{OA} \f$, and normalize it.
-                point_type line_a(_a.p() - _o.p()); line_a.normalize();
-                /// Make the line \f$ \vec{OB} \f$, and normalize it.
-                point_type line_b(_b.p() - _o.p()); line_b.normalize();
-                /// Compute the dot product and the cross product between \f$ \vec{OA} \f$ and \f$ \vec{OB} \f$
-                precision_type sin_res = line_a.dot(line_b);
-                precision_type cos_res = line_a.cross(line_b);
-                precision_type res = static_cast<precision_type>(0);
-                if (cos_res >= static_cast<precision_type>(0))
+                _wall_ids.clear();
+                const size_t bim_link = findLink(_a, _b);
+                if (bim_link == none_index)
+                {
+                    return false;
+                }
+                _wall_ids.assign(wall_ids.cbegin() + wall_offsets[bim_link], wall_ids.cbegin() + wall_offsets[bim_link + 1]);
+                return true;
+            }
+
+            /*!
+             * Find the holes on the walls between two rooms, they are sorted by their walls.
+             * 
+             * @param _a The id of a room
+             * @param _b The id of the other room
+             * @param _hole_ids Output the ids of the holes
+             */
+            bool findHoles(id_type _a, id_type _b, id_vector& _hole_ids) const
+            {
+                _hole_ids.clear();
+                const size_t bim_link = findLink(_a, _b);
+                if (bim_link == none_index)
+                {
+                    return false;
+                }
+                _hole_ids.assign(hole_ids.cbegin() + hole_offsets[bim_link], hole_ids.cbegin() + hole_offsets[bim_link + 1]);
+                return true;
+            }
+
+        private:
+            static void addRoomWalls(const house_type& _house, const id_vector& _rooms, std::vector<std::pair<id_type, id_type>>& _walls_2_rooms)
+            {
+                for (id_type bim_room_id : _rooms)
+                {
+                    const typename house_type::room_map::const_iterator cit_found_room = _house.rooms.find(bim_room_id);
+                    if (cit_found_room == _house.rooms.cend()) continue;
+                    for (id_type bim_wall_id : cit_found_room->second.wall_ids)
+                    {
+                        _walls_2_rooms.push_back(std::make_pair(bim_wall_id, bim_room_id));
+                    }
+                }
+            }
+
+            static void addRoomExWalls(const room_ex_vector& _room_exs, const id_vector& _rooms, std::vector<std::pair<id_type, id_type>>& _walls_2_rooms)
+            {
+                for (const room_ex& each_room_ex : _room_exs)
+                {
+                    if (!std::binary_search(_rooms.cbegin(), _rooms.cend(), each_room_ex.id)) continue;
+                    for (const wall_ex& each_wall_ex : each_room_ex.walls)
+                    {
+                        _walls_2_rooms.push_back(std::make_pair(each_wall_ex.id, each_room_ex.id));
+                    }
+                }
+            }
+
+            template<typename TFunc>
+            void update(const house_type& _house, const id_vector& _room_ids, const TFunc& _add_walls)
+            {
+                id_vector bim_changed_ids(_room_ids);
+                std::sort(bim_changed_ids.begin(), bim_changed_ids.end());
+                bim_changed_ids.erase(std::unique(bim_changed_ids.begin(), bim_changed_ids.end()), bim_changed_ids.end());
+                auto is_changed = [&bim_changed_ids](id_type _room_id)
+                {
+                    return std::binary_search(bim_changed_ids.cbegin(), bim_changed_ids.cend(), _room_id);
+                };
+
+                /// drop the changed rooms, and merge the ones which are still in the house
+                room_ids.erase(std::remove_if(room_ids.begin(), room_ids.end(), is_changed), room_ids.end());
+                walls_2_rooms.erase(std::remove_if(walls_2_rooms.begin(), walls_2_rooms.end()
+                    , [&is_changed](const std::pair<id_type, id_type>& _wall_2_room)
+                    {
+                        return is_changed(_wall_2_room.second);
+                    }), walls_2_rooms.end());
+                id_vector bim_rooms;
+                for (id_type bim_room_id : bim_changed_ids)
+                {
+                    if (_house.rooms.find(bim_room_id) != _house.rooms.cend())
+                    {
+                        bim_rooms.push_back(bim_room_id);
+                    }
+                }
+                const size_t bim_rooms_count = room_ids.size();
+                room_ids.insert(room_ids.end(), bim_rooms.begin(), bim_rooms.end());
+                std::inplace_merge(room_ids.begin(), room_ids.begin() + bim_rooms_count, room_ids.end());
+
+                std::vector<std::pair<id_type, id_type>> bim_walls_2_rooms;
+                _add_walls(bim_rooms, bim_walls_2_rooms);
+                std::sort(bim_walls_2_rooms.begin(), bim_walls_2_rooms.end());
+                bim_walls_2_rooms.erase(std::unique(bim_walls_2_rooms.begin(), bim_walls_2_rooms.end()), bim_walls_2_rooms.end());
+                const size_t bim_walls_2_rooms_count = walls_2_rooms.size();
+                walls_2_rooms.insert(walls_2_rooms.end(), bim_walls_2_rooms.begin(), bim_walls_2_rooms.end());
+                std::inplace_merge(walls_2_rooms.begin(), walls_2_rooms.begin() + bim_walls_2_rooms_count, walls_2_rooms.end());
+                link(_house);
+            }
+
+            /// make the links and the adjacency of rooms by the inverted index
+            void link(const house_type& _house)
+            {
+                const size_t bim_rooms_count = room_ids.size();
+
+                /// every pair of rooms on a wall, in the order of walls
+                std::vector<wall_link> bim_wall_links;
+                std::vector<size_t> bim_rooms;
+                for (size_t i = 0, ic = walls_2_rooms.size(); i < ic; )
+                {
+                    const id_type bim_wall_id = walls_2_rooms[i].first;
+                    bim_rooms.clear();
+                    for (; i < ic && walls_2_rooms[i].first == bim_wall_id; ++i)
+                    {
+                        bim_rooms.push_back(findRoomIndex(walls_2_rooms[i].second));
+                    }
+                    for (size_t a = 0, ac = bim_rooms.size(); a < ac; ++a)
+                    {
+                        for (size_t b = a + 1; b < ac; ++b)
+                        {
+                            bim_wall_links.push_back(wall_link(bim_rooms[a], bim_rooms[b], bim_wall_id));
+                        }
+                    }
+                }
+
+                /// sort them by the rooms by two stable counting sorts, so the walls of a link are still sorted
+                std::vector<wall_link> bim_sorted_links(bim_wall_links.size());
+                std::vector<size_t> bim_cursors(bim_rooms_count + 1);
+                for (size_t bim_pass = 0; bim_pass < 2; ++bim_pass)
+                {
+                    bim_cursors.assign(bim_rooms_count + 1, 0);
+                    for (const wall_link& each_wall_link : bim_wall_links)
+                    {
+                        ++bim_cursors[(bim_pass == 0 ? each_wall_link.second : each_wall_link.first) + 1];
+                    }
+                    for (size_t i = 0; i < bim_rooms_count; ++i)
+                    {
+                        bim_cursors[i + 1] += bim_cursors[i];
+                    }
+                    for (const wall_link& each_wall_link : bim_wall_links)
+                    {
+                        bim_sorted_links[bim_cursors[bim_pass == 0 ? each_wall_link.second : each_wall_link.first]++] = each_wall_link;
+                    }
+                    bim_wall_links.swap(bim_sorted_links);
+                }
+
+                /// the valid holes by their walls
+                std::vector<std::pair<id_type, id_type>> bim_walls_2_holes;
+                for (typename house_type::hole_map::const_iterator cit = _house.holes.cbegin(); cit != _house.holes.cend(); ++cit)
+                {
+                    if (!cit->second.isValid()) continue;
+                    bim_walls_2_holes.push_back(std::make_pair(cit->second.wall_id, cit->first));
+                }
+                std::sort(bim_walls_2_holes.begin(), bim_walls_2_holes.end());
+
+                link_rooms.clear();
+                wall_offsets.clear();
+                wall_ids.clear();
+                hole_offsets.clear();
+                hole_ids.clear();
+                for (const wall_link& each_wall_link : bim_wall_links)
                 {
-                    if (sin_res >= static_cast<precision_type>(0))
+                    if (link_rooms.empty() || link_rooms.back().first != each_wall_link.first || link_rooms.back().second != each_wall_link.second)
                     {
-                        res = sin_res;
+                        link_rooms.push_back(std::make_pair(each_wall_link.first, each_wall_link.second));
+                        wall_offsets.push_back(wall_ids.size());
+                        hole_offsets.push_back(hole_ids.size());
                     }
-                    else
+                    wall_ids.push_back(each_wall_link.wall_id);
+                    typename std::vector<std::pair<id_type, id_type>>::const_iterator cit_hole = std::lower_bound(bim_walls_2_holes.cbegin(), bim_walls_2_holes.cend()
+                        , each_wall_link.wall_id, [](const std::pair<id_type, id_type>& _a, id_type _b)
+                        {
+                            return _a.first < _b;
+                        });
+                    for (; cit_hole != bim_walls_2_holes.cend() && cit_hole->first == each_wall_link.wall_id; ++cit_hole)
                     {
-                        res = static_cast<precision_type>(4) + sin_res;
+                        hole_ids.push_back(cit_hole->second);
                     }
                 }
-                else
+                wall_offsets.push_back(wall_ids.size());
+                hole_offsets.push_back(hole_ids.size());
+
+                /// the links are sorted by their first rooms, so the neighbours of every room are sorted too
+                offsets.assign(bim_rooms_count + 1, 0);
+                for (const std::pair<size_t, size_t>& each_link_rooms : link_rooms)
                 {
-                    res = static_cast<precision_type>(2) - sin_res;
+                    ++offsets[each_link_rooms.first + 1];
+                    ++offsets[each_link_rooms.second + 1];
                 }
-                return res;
+                for (size_t i = 0; i < bim_rooms_count; ++i)
+                {
+                    offsets[i + 1] += offsets[i];
+                }
+                neighbours.resize(offsets.back());
+                links.resize(offsets.back());
+                bim_cursors.assign(offsets.begin(), offsets.end() - 1);
+                for (size_t i = 0, ic = link_rooms.size(); i < ic; ++i)
+                {
+                    const size_t bim_first = link_rooms[i].first;
+                    const size_t bim_second = link_rooms[i].second;
+                    neighbours[bim_cursors[bim_first]] = bim_second;
+                    links[bim_cursors[bim_first]++] = i;
+                    neighbours[bim_cursors[bim_second]] = bim_first;
+                    links[bim_cursors[bim_second]++] = i;
+                }
+            }
+
+        public:
+            id_vector                                   room_ids;       ///< The ids of all rooms, sorted
+            std::vector<size_t>                         offsets;        ///< The offsets of neighbours by the indices of rooms
+            std::vector<size_t>                         neighbours;     ///< The indices of the adjacent rooms
+            std::vector<size_t>                         links;          ///< The link to every adjacent room
+            std::vector<std::pair<size_t, size_t>>      link_rooms;     ///< The indices of the two rooms of every link, the first one is less
+            std::vector<size_t>                         wall_offsets;   ///< The offsets of walls by the links
+            id_vector                                   wall_ids;       ///< The walls of all links
+            std::vector<size_t>                         hole_offsets;   ///< The offsets of holes by the links
+            id_vector                                   hole_ids;       ///< The holes of all links
+
+        private:
+            std::vector<std::pair<id_type, id_type>>    walls_2_rooms;  ///< The inverted index of the walls and the rooms, sorted
+        };
+
+        /*!
+         * The walking graph of a house through its doors, for the distances between rooms.
+         * 
+         * The nodes `[0, roomCount())` are the centers of the rooms by the order of `room_ids`,
+         * and the next `doorCount()` nodes are the middles of the doors by the order of `hole_ids`.
+         * In every room, its center and all its doors are linked by straight lines, and the edges of the node `i` are stored in
+         * `[offsets[i], offsets[i + 1])` of `targets` and `weights`. The walking distance between two rooms is between their centers,
+         * so it is exact for convex rooms, and may be shorter than the real path around the corners of a concave room.
+         * The distances from a room to all rooms are cached after `computeDistances`, until the graph is built again.
+         */
+        template<typename TConstant = constant<>>
+        class navigation_graph
+        {
+        public:
+            typedef algorithm<TConstant>                                algorithm_type;
+            typedef typename TConstant::precision_type                  precision_type;
+            typedef typename TConstant::point_type                      point_type;
+            typedef typename TConstant::id_type                         id_type;
+            typedef typename TConstant::kind_type                       kind_type;
+            typedef typename algorithm_type::id_vector                  id_vector;
+            typedef typename algorithm_type::hole_type                  hole_type;
+            typedef typename algorithm_type::house_type                 house_type;
+            typedef typename algorithm_type::room_ex_vector             room_ex_vector;
+            typedef typename algorithm_type::room_ex_metrics_vector     room_ex_metrics_vector;
+            typedef typename algorithm_type::wall_room_index            wall_room_index;
+            typedef std::vector<precision_type>                         distance_vector;
+
+            static const size_t none_index = static_cast<size_t>(-1);
+
+        private:
+            typedef std::pair<precision_type, size_t>                   queue_item;
+
+        public:
+            navigation_graph()
+                : room_ids()
+                , hole_ids()
+                , points()
+                , offsets()
+                , targets()
+                , weights()
+                , exits()
+                , distance_rows()
+            {}
+
+        public:
+            inline void clear()
+            {
+                room_ids.clear();
+                hole_ids.clear();
+                points.clear();
+                offsets.clear();
+                targets.clear();
+                weights.clear();
+                exits.clear();
+                distance_rows.clear();
+            }
+
+            inline size_t roomCount() const
+            {
+                return room_ids.size();
+            }
+
+            inline size_t doorCount() const
+            {
+                return hole_ids.size();
+            }
+
+            inline size_t nodeCount() const
+            {
+                return points.size();
             }
 
             /*!
-             * Calculate the increased cosine of a angle \f$ \alpha \f$ between \f$ \vec{OA} \f$ and \f$ \vec{OB} \f$.
-             * @f[
-             * f(\vec{OA}, \vec{OB}) =
-             * \begin{cases}
-             * 1 - \vec{OA} \cdot \vec{OB}      & \quad \text{if } 0^{\circ} \leq \alpha \leq 180^{\circ}\\
-             * 3 + \vec{OA} \cdot \vec{OB}      & \quad \text{if } 180^{\circ} < \alpha < 360^{\circ}
-             * \end{cases}
-             * @f]
-             *
-             * @param _o The \f$ {O} \f$ node(point)
-             * @param _a The \f$ {A} \f$ node(point)
-             * @param _b The \f$ {B} \f$ node(point)
+             * Forget the cached distances of `computeDistances`.
              */
-            static precision_type calculateCosAngleEx(const node_type& _o, const node_type& _a, const node_type& _b)
+            inline void clearCache()
             {
-                /// Make the line \f$ \vec{OA} \f$, and normalize it.
-                point_type line_a(_a.p() - _o.p()); line_a.normalize();
-                /// Make the line \f$ \vec{OB} \f$, and normalize it.
-                point_type line_b(_b.p() - _o.p()); line_b.normalize();
-                /// Compute the dot product and the cross product between \f$ \vec{OA} \f$ and \f$ \vec{OB} \f$
-                precision_type sin_res = line_a.dot(line_b);
-                precision_type cos_res = line_a.cross(line_b);
-                precision_type res = static_cast<precision_type>(0);
-                if (sin_res >= static_cast<precision_type>(0))
+                for (distance_vector& each_distance_row : distance_rows)
                 {
-                    res = static_cast<precision_type>(1) - cos_res;
+                    distance_vector().swap(each_distance_row);
                 }
-                else
+            }
+
+            /*!
+             * Find the index of a room, return `none_index` if it is not found.
+             */
+            inline size_t findRoomIndex(id_type _room_id) const
+            {
+                typename id_vector::const_iterator cit_found = std::lower_bound(room_ids.cbegin(), room_ids.cend(), _room_id);
+                if (cit_found == room_ids.cend() || *cit_found != _room_id)
                 {
-                    res = static_cast<precision_type>(3) + cos_res;
+                    return none_index;
                 }
-                return res;
+                return static_cast<size_t>(cit_found - room_ids.cbegin());
             }
 
             /*!
-             * Compute all room's edges by all walls, and don't use recursion.
+             * Build the graph of a house.
+             * 
+             * The center of a room is the centroid of its biggest room-ex of `room_side_in`, or the middle of its doors if it has no room-ex.
+             * The middle of a door is at `distance + width / 2` from the start node of its wall.
+             * A door links all rooms which use its wall, and it is an exit if only one room uses its wall.
              * 
              * @param _house The house
-             * @param _room_exs Output the room's edge list
-             * @param _room_id The special id of room, find all rooms if it is none
+             * @param _room_exs The room-exs of the house, their ids are the rooms, see `algorithm::computeRoomExs`
+             * @param _door_kinds The kinds of the holes which can be walked through, all valid holes are doors if it is empty
+             * @param _pool Compute the centroids in parallel if it is not null
              */
-            static bool computeRoomExs(const house_type& _house
-                , room_ex_vector& _room_exs
-                , id_type _room_id = TConstant::none_id)
+            void build(const house_type& _house
+                , const room_ex_vector& _room_exs
+                , const std::vector<kind_type>& _door_kinds = std::vector<kind_type>()
+                , thread_pool* _pool = nullptr)
             {
+                clear();
+                for (typename house_type::room_map::const_iterator cit = _house.rooms.cbegin(); cit != _house.rooms.cend(); ++cit)
+                {
+                    room_ids.push_back(cit->first);
+                }
+                const size_t bim_rooms_count = room_ids.size();
+                points.assign(bim_rooms_count, point_type());
+
+                room_ex_metrics_vector bim_metrics;
+                algorithm_type::computeRoomExMetrics(_house, _room_exs, bim_metrics, _pool);
+                std::vector<precision_type> bim_areas(bim_rooms_count, static_cast<precision_type>(-1));
+                for (size_t i = 0, ic = _room_exs.size(); i < ic; ++i)
+                {
+                    if (_room_exs[i].side != algorithm_type::room_side_in || _room_exs[i].walls.empty()) continue;
+                    const size_t bim_room_index = findRoomIndex(_room_exs[i].id);
+                    if (bim_room_index == none_index || bim_metrics[i].area <= bim_areas[bim_room_index]) continue;
+                    bim_areas[bim_room_index] = bim_metrics[i].area;
+                    points[bim_room_index] = bim_metrics[i].centroid;
+                }
+
+                /// the doors which are used by any room, and their rooms
+                const wall_room_index bim_index(_house);
                 id_vector bim_room_ids;
-                if (_room_id != TConstant::none_id)
+                std::vector<std::pair<size_t, size_t>> bim_rooms_2_doors;
+                for (typename house_type::hole_map::const_iterator cit = _house.holes.cbegin(); cit != _house.holes.cend(); ++cit)
                 {
-                    const typename house_type::room_map::const_iterator cit_found_room = _house.rooms.find(_room_id);
-                    if (cit_found_room == _house.rooms.cend())
+                    const hole_type& bim_hole = cit->second;
+                    if (!bim_hole.isValid()) continue;
+                    if (!_door_kinds.empty() && std::find(_door_kinds.cbegin(), _door_kinds.cend(), bim_hole.kind) == _door_kinds.cend()) continue;
+                    if (!bim_index.findRoomIds(bim_hole.wall_id, bim_room_ids)) continue;
+                    const typename house_type::wall_map::const_iterator cit_found_wall = _house.walls.find(bim_hole.wall_id);
+                    if (cit_found_wall == _house.walls.cend())
                     {
-                        return false;
+                        throw std::invalid_argument("contains invalid wall!");
                     }
-                    bim_room_ids.push_back(_room_id);
-                }
-                else
-                {
-                    for (typename house_type::room_map::const_iterator cit = _house.rooms.cbegin(); cit != _house.rooms.cend(); ++cit)
+                    const typename house_type::node_map::const_iterator cit_start_node = _house.nodes.find(cit_found_wall->second.start_node_id);
+                    const typename house_type::node_map::const_iterator cit_end_node = _house.nodes.find(cit_found_wall->second.end_node_id);
+                    if (cit_start_node == _house.nodes.cend() || cit_end_node == _house.nodes.cend())
                     {
-                        bim_room_ids.push_back(cit->first);
+                        throw std::invalid_argument("contains invalid node!");
+                    }
+                    const point_type bim_line(cit_end_node->second.p() - cit_start_node->second.p());
+                    const precision_type bim_length = std::sqrt(bim_line.x() * bim_line.x() + bim_line.y() * bim_line.y());
+                    const precision_type bim_t = (bim_length > 0)
+                        ? std::min(std::max((bim_hole.distance + bim_hole.width / 2) / bim_length, static_cast<precision_type>(0)), static_cast<precision_type>(1))
+                        : static_cast<precision_type>(0);
+                    const size_t bim_door = points.size();
+                    points.push_back(point_type(cit_start_node->second.x() + bim_line.x() * bim_t, cit_start_node->second.y() + bim_line.y() * bim_t));
+                    hole_ids.push_back(cit->first);
+                    for (id_type bim_room_id : bim_room_ids)
+                    {
+                        bim_rooms_2_doors.push_back(std::make_pair(findRoomIndex(bim_room_id), bim_door));
+                    }
+                    if (bim_room_ids.size() == 1)
+                    {
+                        exits.push_back(bim_door);
                     }
                 }
+                std::sort(bim_rooms_2_doors.begin(), bim_rooms_2_doors.end());
 
-                _room_exs.clear();
-
-                std::map<id_type, std::vector<node_ex>> bim_nodes_2_next_nodes;
-
-                for (id_type bim_room_id : bim_room_ids)
+                for (size_t i = 0, ic = bim_rooms_2_doors.size(); i < ic; )
                 {
-                    const room_type& bim_room = _house.rooms.find(bim_room_id)->second;
-                    for (const id_type wall_id : bim_room.wall_ids)
+                    const size_t bim_room_index = bim_rooms_2_doors[i].first;
+                    size_t bim_end = i;
+                    precision_type bim_x = 0;
+                    precision_type bim_y = 0;
+                    for (; bim_end < ic && bim_rooms_2_doors[bim_end].first == bim_room_index; ++bim_end)
                     {
-                        const wall_type& bim_wall = _house.walls.find(wall_id)->second;
-                        node_ex bim_next_node;
-                        bim_next_node.with_wall.id = wall_id;
-                        {
-                            bim_next_node.with_wall.inversed = false;
-                            bim_next_node.id = bim_wall.end_node_id;
-                            if (bim_nodes_2_next_nodes.find(bim_wall.start_node_id) == bim_nodes_2_next_nodes.end())
-                            {
-                                std::vector<node_ex> bim_next_nodes;
-                                bim_next_nodes.push_back(bim_next_node);
-                                bim_nodes_2_next_nodes.insert(std::make_pair<>(bim_wall.start_node_id, bim_next_nodes));
-                            }
-                            else
-                            {
-                                addUnique<>(bim_nodes_2_next_nodes[bim_wall.start_node_id], bim_next_node);
-                            }
-                        }
-                        {
-                            bim_next_node.with_wall.inversed = true;
-                            bim_next_node.id = bim_wall.start_node_id;
-                            if (bim_nodes_2_next_nodes.find(bim_wall.end_node_id) == bim_nodes_2_next_nodes.end())
-                            {
-                                std::vector<node_ex> bim_next_nodes;
-                                bim_next_nodes.push_back(bim_next_node);
-                                bim_nodes_2_next_nodes.insert(std::make_pair<>(bim_wall.end_node_id, bim_next_nodes));
-                            }
-                            else
-                            {
-                                addUnique<>(bim_nodes_2_next_nodes[bim_wall.end_node_id], bim_next_node);
-                            }
-                        }
+                        bim_x += points[bim_rooms_2_doors[bim_end].second].x();
+                        bim_y += points[bim_rooms_2_doors[bim_end].second].y();
+                    }
+                    if (bim_areas[bim_room_index] < 0)
+                    {
+                        points[bim_room_index] = point_type(bim_x / static_cast<precision_type>(bim_end - i), bim_y / static_cast<precision_type>(bim_end - i));
                     }
+                    i = bim_end;
                 }
 
-                if (bim_nodes_2_next_nodes.empty())
+                /// count the edges first, then fill them
+                offsets.assign(points.size() + 1, 0);
+                visitEdges(bim_rooms_2_doors, [this](size_t _a, size_t _b)
                 {
-                    return false;
+                    ++offsets[_a + 1];
+                    ++offsets[_b + 1];
+                });
+                for (size_t i = 0, ic = points.size(); i < ic; ++i)
+                {
+                    offsets[i + 1] += offsets[i];
                 }
+                targets.resize(offsets.back());
+                weights.resize(offsets.back());
+                std::vector<size_t> bim_cursors(offsets.begin(), offsets.end() - 1);
+                visitEdges(bim_rooms_2_doors, [this, &bim_cursors](size_t _a, size_t _b)
+                {
+                    const point_type bim_line(points[_b] - points[_a]);
+                    const precision_type bim_weight = std::sqrt(bim_line.x() * bim_line.x() + bim_line.y() * bim_line.y());
+                    targets[bim_cursors[_a]] = _b;
+                    weights[bim_cursors[_a]++] = bim_weight;
+                    targets[bim_cursors[_b]] = _a;
+                    weights[bim_cursors[_b]++] = bim_weight;
+                });
+                distance_rows.assign(bim_rooms_count, distance_vector());
+            }
 
-                /// Compute the path/edges of the room
-                while (!bim_nodes_2_next_nodes.empty())
+            /*!
+             * Find the walking distance between two rooms by A*, the straight line to the target is the heuristic.
+             * 
+             * @param _from_id The id of the room where the path starts
+             * @param _to_id The id of the room where the path ends
+             * @param _hole_ids Output the doors on the path in order if it is not null
+             * @return The distance, or infinity if a room is not found or they are not connected
+             */
+            precision_type findDistance(id_type _from_id, id_type _to_id, id_vector* _hole_ids = nullptr) const
+            {
+                if (_hole_ids != nullptr)
                 {
-                    room_ex bim_room_ex;
-                    bim_room_ex.id  = _room_id;
-                    bool bim_path_is_closed     = false;
+                    _hole_ids->clear();
+                }
+                const precision_type bim_infinity = std::numeric_limits<precision_type>::infinity();
+                const size_t bim_from = findRoomIndex(_from_id);
+                const size_t bim_to = findRoomIndex(_to_id);
+                if (bim_from == none_index || bim_to == none_index)
+                {
+                    return bim_infinity;
+                }
+                if (bim_from == bim_to)
+                {
+                    return 0;
+                }
 
-                    id_type bim_start_node_id            = bim_nodes_2_next_nodes.cbegin()->first;
-                    id_type bim_last_node_id             = TConstant::none_id;
-                    id_type bim_first_wall_start_node_id = TConstant::none_id;
-                    id_type bim_first_wall_end_node_id   = TConstant::none_id;
-                    wall_ex bim_first_wall_ex;
-                    while (true)
+                const point_type& bim_target = points[bim_to];
+                auto heuristic = [this, &bim_target](size_t _node)
+                {
+                    const point_type bim_line(bim_target - points[_node]);
+                    return std::sqrt(bim_line.x() * bim_line.x() + bim_line.y() * bim_line.y());
+                };
+                const size_t bim_none_index = none_index;
+                distance_vector bim_distances(points.size(), bim_infinity);
+                std::vector<size_t> bim_parents(points.size(), bim_none_index);
+                std::vector<bool> bim_closed(points.size(), false);
+                std::vector<queue_item> bim_queue;
+                bim_distances[bim_from] = 0;
+                bim_queue.push_back(queue_item(heuristic(bim_from), bim_from));
+                while (!bim_queue.empty())
+                {
+                    std::pop_heap(bim_queue.begin(), bim_queue.end(), std::greater<queue_item>());
+                    const size_t bim_node = bim_queue.back().second;
+                    bim_queue.pop_back();
+                    if (bim_closed[bim_node]) continue;
+                    bim_closed[bim_node] = true;
+                    if (bim_node == bim_to) break;
+                    /// the paths never pass through the centers of the other rooms
+                    if (bim_node < room_ids.size() && bim_node != bim_from) continue;
+                    for (size_t i = offsets[bim_node], ic = offsets[bim_node + 1]; i < ic; ++i)
                     {
-                        std::vector<node_ex>& bim_next_nodes = bim_nodes_2_next_nodes.find(bim_start_node_id)->second;
-                        if (bim_next_nodes.empty())
-                        {
-                            break;
-                        }
-                        if (bim_last_node_id == TConstant::none_id)
-                        {
-                            bim_last_node_id = bim_start_node_id;
-                            node_ex& bim_next_node = bim_next_nodes[0];
-                            bim_start_node_id = bim_next_node.id;
-                            bim_first_wall_ex = bim_next_node.with_wall;
-                        }
-                        else
-                        {
-                            assert(bim_start_node_id != bim_last_node_id);
-                            if (bim_start_node_id == bim_last_node_id)
-                            {
-                                throw std::invalid_argument("contains invalid wall!");
-                            }
-
-                            std::map<precision_type, size_t> sin_angle_ex_2_index;
-                            {
-                                /// sort the next node by the `sin-angle-ex`
-                                const node_type& bim_start_node = _house.nodes.find(bim_start_node_id)->second;
-                                const node_type& bim_last_node = _house.nodes.find(bim_last_node_id)->second;
-                                for (size_t i = 0; i < bim_next_nodes.size(); ++i)
-                                {
-                                    const node_ex& bim_next_node = bim_next_nodes[i];
-                                    if (bim_next_node.used) continue;
-                                    const node_type& bim_node = _house.nodes.find(bim_next_node.id)->second;
-                                    precision_type sin_angle_ex = calculateSinAngleEx(bim_start_node, bim_last_node, bim_node);
-                                    sin_angle_ex_2_index.insert(std::make_pair<>(sin_angle_ex, i));
-                                }
-                            }
-                            if (sin_angle_ex_2_index.empty())
-                            {
-                                break;
-                            }
-
-                            typename std::map<precision_type, size_t>::const_iterator sin_angle_ex_2_index_last = --sin_angle_ex_2_index.cend();
-                            node_ex& bim_next_node = bim_next_nodes[sin_angle_ex_2_index_last->second];
-                            bim_next_node.used = true;
-
-                            wall_ex bim_wall_ex;
-                            bim_wall_ex = bim_next_node.with_wall;
-                            bim_room_ex.walls.push_back(bim_wall_ex);
-
-                            if (bim_first_wall_ex == bim_next_node.with_wall)
-                            {
-                                bim_path_is_closed = true;
-                                break;
-                            }
-
-                            bim_last_node_id = bim_start_node_id;
-                            bim_start_node_id = bim_next_node.id;
-                        }
+                        const size_t bim_next = targets[i];
+                        const precision_type bim_distance = bim_distances[bim_node] + weights[i];
+                        if (bim_closed[bim_next] || !(bim_distance < bim_distances[bim_next])) continue;
+                        bim_distances[bim_next] = bim_distance;
+                        bim_parents[bim_next] = bim_node;
+                        bim_queue.push_back(queue_item(bim_distance + heuristic(bim_next), bim_next));
+                        std::push_heap(bim_queue.begin(), bim_queue.end(), std::greater<queue_item>());
                     }
-
-                    if (bim_path_is_closed)
+                }
+                if (_hole_ids != nullptr && bim_distances[bim_to] != bim_infinity)
+                {
+                    for (size_t bim_node = bim_parents[bim_to]; bim_node != bim_from; bim_node = bim_parents[bim_node])
                     {
-                        /// mark all repeated walls
-                        std::map<id_type, size_t> bim_walls_2_counts;
-                        for (const wall_ex& bim_wall_ex : bim_room_ex.walls)
-                        {
-                            typename std::map<id_type, size_t>::iterator it_found = bim_walls_2_counts.find(bim_wall_ex.id);
-                            if (it_found == bim_walls_2_counts.end())
-                            {
-                                bim_walls_2_counts.insert(std::make_pair<>(bim_wall_ex.id, 1));
-                            }
-                            else
-                            {
-                                ++it_found->second;
-                            }
-                        }
-                        for (wall_ex& bim_wall_ex : bim_room_ex.walls)
-                        {
-                            bim_wall_ex.repeated = (bim_walls_2_counts[bim_wall_ex.id] != 1);
-                        }
-
-                        //TODO: decide wheather the room-ex is inside or outside
-                        /// find the most left node from all unrepeated walls
-                        {
-                            size_t bim_wall_ex_index = bim_room_ex.walls.size();
-                            node_type bim_left_node(TConstant::zero_point);
-                            {
-                                id_type bim_left_node_id = TConstant::none_id;
-                                for (size_t i = 0, ic = bim_room_ex.walls.size(); i < ic; ++i)
-                                {
-                                    const wall_ex& bim_wall_ex = bim_room_ex.walls[i];
-                                    /// ignore all repeated walls
-                                    if (bim_wall_ex.repeated) continue;
-                                    const wall_type& bim_wall = _house.walls.find(bim_wall_ex.id)->second;
-                                    if (!TConstant::isValid(bim_left_node_id))
-                                    {
-                                        bim_left_node_id = bim_wall.start_node_id;
-                                        bim_left_node = _house.nodes.find(bim_left_node_id)->second;
-                                        bim_wall_ex_index = i;
-                                    }
-                                    else
-                                    {
-                                        const node_type& bim_left_node_temp = _house.nodes.find(bim_wall.start_node_id)->second;
-                                        if (bim_left_node_temp.p() < bim_left_node.p())
-                                        {
-                                            bim_left_node_id = bim_wall.start_node_id;
-                                            bim_left_node = bim_left_node_temp;
-                                            bim_wall_ex_index = i;
-                                        }
-                                    }
-                                }
-                            }
-                            if (bim_wall_ex_index < bim_room_ex.walls.size())
-                            {
-                                const size_t bim_walls_count = bim_room_ex.walls.size();
-                                const wall_ex& bim_start_wall_ex = bim_room_ex.walls[bim_wall_ex_index];
-                                const wall_ex* bim_next_wall_ex_ptr = nullptr;
-                                while (bim_next_wall_ex_ptr != &bim_start_wall_ex
-                                    && (bim_next_wall_ex_ptr == nullptr
-                                        || bim_next_wall_ex_ptr->repeated))
-                                {
-                                    if (bim_start_wall_ex.inversed)
-                                    {
-                                        bim_wall_ex_index = bim_wall_ex_index + 1;
-                                    }
-                                    else
-                                    {
-                                        bim_wall_ex_index = bim_wall_ex_index + bim_walls_count - 1;
-                                    }
-                                    bim_wall_ex_index = bim_wall_ex_index % bim_walls_count;
-                                    bim_next_wall_ex_ptr = &bim_room_ex.walls[bim_wall_ex_index];
-                                }
-                                if (bim_next_wall_ex_ptr != &bim_start_wall_ex)
-                                {
-                                    const wall_type& bim_start_wall = _house.walls.find(bim_start_wall_ex.id)->second;
-                                    const node_type bim_start_node = _house.nodes.find(bim_start_wall.end_node_id)->second;
-                                    const wall_type& bim_next_wall = _house.walls.find(bim_next_wall_ex_ptr->id)->second;
-                                    const node_type bim_next_node = _house.nodes.find(bim_start_wall.start_node_id == bim_next_wall.end_node_id ? bim_next_wall.start_node_id : bim_next_wall.end_node_id)->second;
-                                    const precision_type bim_sin_angle_ex = calculateCosAngleEx(bim_left_node
-                                        , bim_start_wall_ex.inversed ? bim_next_node : bim_start_node
-                                        , bim_start_wall_ex.inversed ? bim_start_node : bim_next_node);
-                                    if (bim_sin_angle_ex == 0)
-                                    {
-                                        bim_room_ex.side = room_side_both;
-                                    }
-                                    else
-                                    {
-                                        bim_room_ex.side = (bim_sin_angle_ex <= static_cast<precision_type>(2)) ? room_side_in : room_side_out;
-                                    }
-                                }
-                            }
-                        }
-
-                        _room_exs.push_back(bim_room_ex);
+                        _hole_ids->push_back(hole_ids[bim_node - room_ids.size()]);
                     }
+                    std::reverse(_hole_ids->begin(), _hole_ids->end());
+                }
+                return bim_distances[bim_to];
+            }
 
-                    for (typename std::map<id_type, std::vector<node_ex>>::iterator it_m = bim_nodes_2_next_nodes.begin(); it_m != bim_nodes_2_next_nodes.end();)
-                    {
-                        std::vector<node_ex>& bim_next_nodes = it_m->second;
-                        for (typename std::vector<node_ex>::iterator it_v = bim_next_nodes.begin(); it_v != bim_next_nodes.end();)
-                        {
-                            if (it_v->used)
-                            {
-                                it_v = bim_next_nodes.erase(it_v);
-                            }
-                            else
-                            {
-                                ++it_v;
-                            }
-                        }
+            /*!
+             * Find the walking distances of many pairs of rooms, see `findDistance`.
+             * 
+             * @param _pairs The ids of the rooms where the paths start and end
+             * @param _distances Output the distance of every pair
+             * @param _pool Find them in parallel if it is not null
+             */
+            void findDistances(const std::vector<std::pair<id_type, id_type>>& _pairs, distance_vector& _distances, thread_pool* _pool = nullptr) const
+            {
+                _distances.resize(_pairs.size());
+                parallelFor(_pool, _pairs.size(), [this, &_pairs, &_distances](size_t _index)
+                {
+                    _distances[_index] = findDistance(_pairs[_index].first, _pairs[_index].second);
+                });
+            }
 
-                        if (it_m->second.empty())
-                        {
-                            it_m = bim_nodes_2_next_nodes.erase(it_m);
-                        }
-                        else
-                        {
-                            ++it_m;
-                        }
-                    }
+            /*!
+             * Compute the walking distances from many rooms to many rooms.
+             * 
+             * Every room where the paths start is searched by Dijkstra once, and its distances to all rooms are cached,
+             * so the later calls only read them. The rooms which are not cached are searched in parallel,
+             * but it must not be called by many threads at the same time because of the cache.
+             * 
+             * @param _from_ids The ids of the rooms where the paths start
+             * @param _to_ids The ids of the rooms where the paths end
+             * @param _distances Output the distance from `_from_ids[i]` to `_to_ids[j]` at `i * _to_ids.size() + j`,
+             *                   it is infinity if a room is not found or they are not connected
+             * @param _pool Search the rooms in parallel if it is not null
+             */
+            void computeDistances(const id_vector& _from_ids, const id_vector& _to_ids, distance_vector& _distances, thread_pool* _pool = nullptr)
+            {
+                const size_t bim_rooms_count = room_ids.size();
+                std::vector<size_t> bim_sources;
+                for (id_type bim_room_id : _from_ids)
+                {
+                    const size_t bim_room_index = findRoomIndex(bim_room_id);
+                    if (bim_room_index == none_index || !distance_rows[bim_room_index].empty()) continue;
+                    distance_rows[bim_room_index].resize(bim_rooms_count);
+                    bim_sources.push_back(bim_room_index);
                 }
+                parallelFor(_pool, bim_sources.size(), [this, &bim_sources, bim_rooms_count](size_t _index)
+                {
+                    distance_vector bim_distances;
+                    searchDistances(std::vector<size_t>(1, bim_sources[_index]), bim_distances);
+                    std::copy(bim_distances.begin(), bim_distances.begin() + bim_rooms_count, distance_rows[bim_sources[_index]].begin());
+                });
 
-                if (!TConstant::isValid(_room_id))
+                const precision_type bim_infinity = std::numeric_limits<precision_type>::infinity();
+                _distances.assign(_from_ids.size() * _to_ids.size(), bim_infinity);
+                for (size_t i = 0, ic = _from_ids.size(); i < ic; ++i)
                 {
-                    /// make sure the room id
-                    std::map<id_type, std::vector<id_type>> bim_rooms_2_walls;
-                    for (typename house_type::room_map::const_iterator cit = _house.rooms.cbegin();
-                        cit != _house.rooms.cend(); ++cit)
+                    const size_t bim_from = findRoomIndex(_from_ids[i]);
+                    if (bim_from == none_index) continue;
+                    for (size_t j = 0, jc = _to_ids.size(); j < jc; ++j)
                     {
-                        const room_type& bim_room = cit->second;
-                        id_vector bim_wall_ids = bim_room.wall_ids;
-                        std::sort(bim_wall_ids.begin(), bim_wall_ids.end());
-                        bim_rooms_2_walls.insert(std::make_pair(cit->first, bim_wall_ids));
+                        const size_t bim_to = findRoomIndex(_to_ids[j]);
+                        if (bim_to == none_index) continue;
+                        _distances[i * jc + j] = distance_rows[bim_from][bim_to];
                     }
+                }
+            }
 
-                    for (room_ex& each_room_ex : _room_exs)
+            /*!
+             * Compute the walking distance from every room to its nearest exit by one Dijkstra search from all exits.
+             * 
+             * @param _distances Output the distance of every room by the order of `room_ids`, it is infinity if the room can't go out
+             */
+            void computeExitDistances(distance_vector& _distances) const
+            {
+                searchDistances(exits, _distances);
+                _distances.resize(room_ids.size());
+            }
+
+        private:
+            template<typename TFunc>
+            static void parallelFor(thread_pool* _pool, size_t _count, const TFunc& _func)
+            {
+                if (_pool != nullptr)
+                {
+                    _pool->parallelFor(_count, _func);
+                    return;
+                }
+                for (size_t i = 0; i < _count; ++i)
+                {
+                    _func(i);
+                }
+            }
+
+            /// visit the edges from the center of every room to its doors, and between every two doors of a room
+            template<typename TFunc>
+            static void visitEdges(const std::vector<std::pair<size_t, size_t>>& _rooms_2_doors, const TFunc& _func)
+            {
+                for (size_t i = 0, ic = _rooms_2_doors.size(); i < ic; )
+                {
+                    size_t bim_end = i;
+                    while (bim_end < ic && _rooms_2_doors[bim_end].first == _rooms_2_doors[i].first) ++bim_end;
+                    for (size_t a = i; a < bim_end; ++a)
                     {
-                        id_vector bim_wall_ids;
-                        for (const wall_ex& bim_wall_ex : each_room_ex.walls)
-                        {
-                            bim_wall_ids.push_back(bim_wall_ex.id);
-                        }
-                        if (bim_wall_ids.empty())
-                        {
-                            continue;
-                        }
-                        std::sort(bim_wall_ids.begin(), bim_wall_ids.end());
-                        for (typename std::map<id_type, std::vector<id_type>>::const_iterator cit = bim_rooms_2_walls.cbegin();
-                            cit != bim_rooms_2_walls.cend(); ++cit)
+                        _func(_rooms_2_doors[a].first, _rooms_2_doors[a].second);
+                        for (size_t b = a + 1; b < bim_end; ++b)
                         {
-                            if (!isContainsForBiggerVector<>(cit->second, bim_wall_ids)) continue;
-                            each_room_ex.id = cit->first;
-                            break;
+                            _func(_rooms_2_doors[a].second, _rooms_2_doors[b].second);
                         }
                     }
+                    i = bim_end;
                 }
+            }
 
-                return !_room_exs.empty();
+            /// Dijkstra from some nodes, the paths never pass through the centers of rooms which are not the sources
+            void searchDistances(const std::vector<size_t>& _sources, distance_vector& _distances) const
+            {
+                _distances.assign(points.size(), std::numeric_limits<precision_type>::infinity());
+                std::vector<queue_item> bim_queue;
+                for (size_t bim_source : _sources)
+                {
+                    _distances[bim_source] = 0;
+                    bim_queue.push_back(queue_item(0, bim_source));
+                }
+                std::make_heap(bim_queue.begin(), bim_queue.end(), std::greater<queue_item>());
+                while (!bim_queue.empty())
+                {
+                    std::pop_heap(bim_queue.begin(), bim_queue.end(), std::greater<queue_item>());
+                    const queue_item bim_item = bim_queue.back();
+                    bim_queue.pop_back();
+                    const size_t bim_node = bim_item.second;
+                    if (bim_item.first > _distances[bim_node]) continue;
+                    if (bim_node < room_ids.size() && bim_item.first > 0) continue;
+                    for (size_t i = offsets[bim_node], ic = offsets[bim_node + 1]; i < ic; ++i)
+                    {
+                        const size_t bim_next = targets[i];
+                        const precision_type bim_distance = bim_item.first + weights[i];
+                        if (!(bim_distance < _distances[bim_next])) continue;
+                        _distances[bim_next] = bim_distance;
+                        bim_queue.push_back(queue_item(bim_distance, bim_next));
+                        std::push_heap(bim_queue.begin(), bim_queue.end(), std::greater<queue_item>());
+                    }
+                }
             }
+
+        public:
+            id_vector                   room_ids;       ///< The ids of all rooms, sorted
+            id_vector                   hole_ids;       ///< The ids of the holes of all doors
+            std::vector<point_type>     points;         ///< The centers of the rooms, then the middles of the doors
+            std::vector<size_t>         offsets;        ///< The offsets of edges by the nodes
+            std::vector<size_t>         targets;        ///< The node at the end of every edge
+            distance_vector             weights;        ///< The length of every edge
+            std::vector<size_t>         exits;          ///< The nodes of the doors which only one room uses
+
+        private:
+            std::vector<distance_vector>    distance_rows;  ///< The cached distances from every room to all rooms, empty if it isn't computed
         };
     }
 }
@@ -22,43 +22,62 @@
  */
 #include <bimpp/plan2d.hpp>
 
+#include <sstream>
+
 #if defined(WIN32) && !defined(NDEBUG)
 #include <crtdbg.h>
 #endif
 
-int main(int argc, char* argv[])
+/// Are the room-exs same, the ids of the second ones are mapped by `_wall_id` and `_room_id` first
+template<typename TRoomExs, typename TOtherRoomExs, typename TWallId, typename TRoomId>
+static bool isSameRoomExs(const TRoomExs& _a, const TOtherRoomExs& _b, const TWallId& _wall_id, const TRoomId& _room_id)
 {
-#if defined(WIN32) && !defined(NDEBUG)
-    _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
-#endif
-
-#if 1
-#if defined(WIN32) && !defined(NDEBUG)
-    /// Compare the performance
-    bimpp::plan2d::node<> node_o(0.0, 0.0);
-    bimpp::plan2d::node<> node_a(1.0, 0.0);
-    std::vector<bimpp::plan2d::node<>> node_bs;
-    for (size_t i = 0; i < 3000000; ++i)
+    if (_a.size() != _b.size())
     {
-        bimpp::plan2d::node<> node_b((rand() / static_cast<double>(RAND_MAX)) * 100.0 - 50.0, (rand() / static_cast<double>(RAND_MAX)) * 100.0 - 50.0);
-        node_bs.push_back(node_b);
+        return false;
     }
-    std::vector<double> node_aob_angle_ex;
-    for (size_t i = 0, ic = node_bs.size(); i < ic; ++i)
+    for (size_t i = 0, ic = _a.size(); i < ic; ++i)
     {
-        node_aob_angle_ex.push_back(bimpp::plan2d::algorithm<>::calculateAngleEx(node_o, node_a, node_bs[i]));
-    }
-    std::vector<double> node_aob_sin_angle_ex;
-    for (size_t i = 0, ic = node_bs.size(); i < ic; ++i)
-    {
-        node_aob_sin_angle_ex.push_back(bimpp::plan2d::algorithm<>::calculateSinAngleEx(node_o, node_a, node_bs[i]));
+        if (_a[i].id != _room_id(_b[i].id) || static_cast<int>(_a[i].side) != static_cast<int>(_b[i].side) || _a[i].walls.size() != _b[i].walls.size())
+        {
+            return false;
+        }
+        for (size_t j = 0, jc = _a[i].walls.size(); j < jc; ++j)
+        {
+            if (_a[i].walls[j].id != _wall_id(_b[i].walls[j].id) || _a[i].walls[j].inversed != _b[i].walls[j].inversed || _a[i].walls[j].repeated != _b[i].walls[j].repeated)
+            {
+                return false;
+            }
+        }
     }
-    std::vector<double> node_aob_cos_angle_ex;
-    for (size_t i = 0, ic = node_bs.size(); i < ic; ++i)
+    return true;
+}
+
+/// The room-exs of a tracker by an order which doesn't depend on their ids, every loop of walls starts from its smallest wall
+template<typename TRoomExMap>
+static std::vector<std::vector<size_t>> sortRoomExs(const TRoomExMap& _room_exs)
+{
+    std::vector<std::vector<size_t>> bimpp_loops;
+    for (const auto& bimpp_room_ex : _room_exs)
     {
-        node_aob_cos_angle_ex.push_back(bimpp::plan2d::algorithm<>::calculateCosAngleEx(node_o, node_a, node_bs[i]));
+        std::vector<size_t> bimpp_loop;
+        for (const auto& bimpp_wall_ex : bimpp_room_ex.second.walls)
+        {
+            bimpp_loop.push_back(bimpp_wall_ex.id * 4 + (bimpp_wall_ex.inversed ? 2 : 0) + (bimpp_wall_ex.repeated ? 1 : 0));
+        }
+        std::rotate(bimpp_loop.begin(), std::min_element(bimpp_loop.begin(), bimpp_loop.end()), bimpp_loop.end());
+        bimpp_loop.insert(bimpp_loop.begin(), static_cast<size_t>(bimpp_room_ex.second.side));
+        bimpp_loop.insert(bimpp_loop.begin(), bimpp_room_ex.second.id);
+        bimpp_loops.push_back(bimpp_loop);
     }
-#endif
+    std::sort(bimpp_loops.begin(), bimpp_loops.end());
+    return bimpp_loops;
+}
+
+int main(int argc, char* argv[])
+{
+#if defined(WIN32) && !defined(NDEBUG)
+    _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 #endif
 
     /// Make a house
@@ -100,5 +119,269 @@ int main(int argc, char* argv[])
 
     bimpp::plan2d::algorithm<>::room_ex_vector bimpp_room_exs;
     bimpp::plan2d::algorithm<>::computeRoomExs(bimpp_house, bimpp_room_exs);
+
+    /// Walking the faces gives the same room-exs as comparing the angles
+    bimpp::plan2d::algorithm<>::room_ex_vector bimpp_face_room_exs;
+    bimpp::plan2d::algorithm<>::computeRoomExs(bimpp_house, bimpp_face_room_exs
+        , bimpp::plan2d::constant<>::none_id, bimpp::plan2d::algorithm<>::trace_mode_face);
+    auto bimpp_same_id = [](size_t _id) { return _id; };
+    if (bimpp_room_exs.empty() || !isSameRoomExs(bimpp_room_exs, bimpp_face_room_exs, bimpp_same_id, bimpp_same_id))
+    {
+        return 1;
+    }
+
+    /// Renumber the sparse ids to dense 32-bit ids, the room-exs are same except the ids
+    typedef bimpp::plan2d::constant<double, bimpp::plan2d::point<double>, bimpp::plan2d::map_storage, bimpp::plan2d::symbol, std::uint32_t> compact_constant;
+    bimpp::plan2d::house<compact_constant> bimpp_compact_house;
+    bimpp::plan2d::id_renumbering<> bimpp_renumbering;
+    bimpp::plan2d::algorithm<compact_constant>::renumberHouse(bimpp_house, bimpp_compact_house, &bimpp_renumbering);
+    bimpp::plan2d::algorithm<compact_constant>::room_ex_vector bimpp_compact_room_exs;
+    bimpp::plan2d::algorithm<compact_constant>::computeRoomExs(bimpp_compact_house, bimpp_compact_room_exs);
+    auto bimpp_original_wall_id = [&bimpp_renumbering](std::uint32_t _id)
+    {
+        return (_id < bimpp_renumbering.wall_ids.size()) ? bimpp_renumbering.wall_ids[_id] : bimpp::plan2d::constant<>::none_id;
+    };
+    auto bimpp_original_room_id = [&bimpp_renumbering](std::uint32_t _id)
+    {
+        return (_id < bimpp_renumbering.room_ids.size()) ? bimpp_renumbering.room_ids[_id] : bimpp::plan2d::constant<>::none_id;
+    };
+    if (!isSameRoomExs(bimpp_room_exs, bimpp_compact_room_exs, bimpp_original_wall_id, bimpp_original_room_id))
+    {
+        return 1;
+    }
+
+    /// Split the crossing walls, a wall ending where two walls cross, and three walls crossing at one point, share one node
+    const double bimpp_crossings[][3][4] = {
+        { { -1.0, 0.0, 1.0, 0.0 }, { 0.0, -1.0, 0.0, 1.0 }, { 0.0, 0.0, 1.0, 1.0 } },
+        { { -1.0, -0.3, 1.0, 0.3 }, { -0.2, -1.0, 0.2, 1.0 }, { -1.0, 0.7, 1.0, -0.7 } },
+    };
+    const size_t bimpp_crossing_walls_counts[] = { 5, 6 };
+    const size_t bimpp_crossing_nodes_counts[] = { 6, 7 };
+    for (size_t i = 0; i < 2; ++i)
+    {
+        bimpp::plan2d::house<> bimpp_crossing_house;
+        for (size_t w = 0; w < 3; ++w)
+        {
+            bimpp_crossing_house.nodes.insert(std::make_pair<>(w * 2, bimpp::plan2d::node<>(bimpp_crossings[i][w][0], bimpp_crossings[i][w][1])));
+            bimpp_crossing_house.nodes.insert(std::make_pair<>(w * 2 + 1, bimpp::plan2d::node<>(bimpp_crossings[i][w][2], bimpp_crossings[i][w][3])));
+            bimpp_crossing_house.walls.insert(std::make_pair<>(w, bimpp::plan2d::wall<>(w * 2, w * 2 + 1)));
+        }
+        bimpp::plan2d::algorithm<>::wall_piece_vector bimpp_pieces;
+        bimpp::plan2d::algorithm<>::nodeWalls(bimpp_crossing_house, bimpp_pieces);
+        if (bimpp_crossing_house.walls.size() != bimpp_crossing_walls_counts[i] || bimpp_crossing_house.nodes.size() != bimpp_crossing_nodes_counts[i])
+        {
+            return 1;
+        }
+        for (const auto& bimpp_wall : bimpp_crossing_house.walls)
+        {
+            const bimpp::plan2d::point<> bimpp_line(bimpp_crossing_house.nodes.find(bimpp_wall.second.end_node_id)->second.p()
+                - bimpp_crossing_house.nodes.find(bimpp_wall.second.start_node_id)->second.p());
+            if (bimpp_line.x() * bimpp_line.x() + bimpp_line.y() * bimpp_line.y() < 1e-18)
+            {
+                return 1;
+            }
+        }
+    }
+
+    /// A door across a crossing is clipped by the piece which holds most of it
+    {
+        bimpp::plan2d::house<> bimpp_door_house;
+        bimpp_door_house.nodes.insert(std::make_pair<>(0, bimpp::plan2d::node<>(0.0, 0.0)));
+        bimpp_door_house.nodes.insert(std::make_pair<>(1, bimpp::plan2d::node<>(4.0, 0.0)));
+        bimpp_door_house.nodes.insert(std::make_pair<>(2, bimpp::plan2d::node<>(2.0, -1.0)));
+        bimpp_door_house.nodes.insert(std::make_pair<>(3, bimpp::plan2d::node<>(2.0, 1.0)));
+        bimpp_door_house.walls.insert(std::make_pair<>(0, bimpp::plan2d::wall<>(0, 1)));
+        bimpp_door_house.walls.insert(std::make_pair<>(1, bimpp::plan2d::wall<>(2, 3)));
+        bimpp_door_house.holes.insert(std::make_pair<>(0, bimpp::plan2d::hole<>(0, 1.75, 0.5)));
+        bimpp_door_house.holes.insert(std::make_pair<>(1, bimpp::plan2d::hole<>(0, 2.0, 0.5)));
+        bimpp::plan2d::algorithm<>::wall_piece_vector bimpp_pieces;
+        bimpp::plan2d::algorithm<>::nodeWalls(bimpp_door_house, bimpp_pieces);
+        for (const auto& bimpp_hole : bimpp_door_house.holes)
+        {
+            const bimpp::plan2d::wall<>& bimpp_wall = bimpp_door_house.walls.find(bimpp_hole.second.wall_id)->second;
+            const bimpp::plan2d::point<> bimpp_line(bimpp_door_house.nodes.find(bimpp_wall.end_node_id)->second.p()
+                - bimpp_door_house.nodes.find(bimpp_wall.start_node_id)->second.p());
+            const double bimpp_length = std::sqrt(bimpp_line.x() * bimpp_line.x() + bimpp_line.y() * bimpp_line.y());
+            if (!bimpp_hole.second.isValid() || bimpp_hole.second.distance + bimpp_hole.second.width > bimpp_length + 1e-9)
+            {
+                return 1;
+            }
+        }
+    }
+
+    /// The tracker gives the same room-exs after some edits as tracing the edited house again
+    {
+        bimpp::plan2d::room_ex_tracker<> bimpp_tracker;
+        bimpp_tracker.reset(bimpp_house);
+        bimpp_tracker.insertWall(3000, bimpp::plan2d::wall<>(0, 11));
+        bimpp_tracker.eraseWall(1334);
+        bimpp_tracker.moveNode(22, bimpp::plan2d::point<>(2.2, 2.2));
+        bimpp::plan2d::room_ex_tracker<>::change_set bimpp_changes;
+        bimpp_tracker.update(bimpp_changes);
+        bimpp::plan2d::room_ex_tracker<> bimpp_fresh_tracker;
+        bimpp_fresh_tracker.reset(bimpp_tracker.model());
+        if (bimpp_changes.empty() || sortRoomExs(bimpp_tracker.roomExs()) != sortRoomExs(bimpp_fresh_tracker.roomExs()))
+        {
+            return 1;
+        }
+    }
+
+    /// Make three rooms in a row, the doors between them and the exit of the first one are "door"
+    bimpp::plan2d::house<> bimpp_row_house;
+    for (size_t x = 0; x < 4; ++x)
+    {
+        bimpp_row_house.nodes.insert(std::make_pair<>(x * 2, bimpp::plan2d::node<>(bimpp::plan2d::constant<>::convert(x), 0.0)));
+        bimpp_row_house.nodes.insert(std::make_pair<>(x * 2 + 1, bimpp::plan2d::node<>(bimpp::plan2d::constant<>::convert(x), 1.0)));
+        bimpp_row_house.walls.insert(std::make_pair<>(x, bimpp::plan2d::wall<>(x * 2, x * 2 + 1, 0.1)));
+        if (x > 0)
+        {
+            bimpp_row_house.walls.insert(std::make_pair<>(10 + x, bimpp::plan2d::wall<>((x - 1) * 2, x * 2, 0.1)));
+            bimpp_row_house.walls.insert(std::make_pair<>(20 + x, bimpp::plan2d::wall<>((x - 1) * 2 + 1, x * 2 + 1, 0.1)));
+            bimpp::plan2d::room<> bimpp_row_room;
+            bimpp_row_room.kind = "office";
+            bimpp_row_room.wall_ids = { x - 1, x, 10 + x, 20 + x };
+            bimpp_row_house.rooms.insert(std::make_pair<>(x - 1, bimpp_row_room));
+        }
+        bimpp::plan2d::hole<> bimpp_door(x, 0.25, 0.5);
+        bimpp_door.kind = (x < 3) ? "door" : "window";
+        bimpp_row_house.holes.insert(std::make_pair<>(x, bimpp_door));
+    }
+    bimpp::plan2d::algorithm<>::room_ex_vector bimpp_row_room_exs;
+    bimpp::plan2d::algorithm<>::computeRoomExs(bimpp_row_house, bimpp_row_room_exs);
+
+    /// The house is same after writing and reading it as JSON or binary
+    {
+        std::ostringstream bimpp_json;
+        bimpp::plan2d::json_writer<>::write(bimpp_json, bimpp_row_house);
+        std::istringstream bimpp_json_input(bimpp_json.str());
+        bimpp::plan2d::json_reader<> bimpp_reader;
+        bimpp::plan2d::house<> bimpp_json_house;
+        std::vector<char> bimpp_bytes;
+        bimpp::plan2d::binary_writer<>::write(bimpp_row_house, bimpp_bytes);
+        bimpp::plan2d::binary_view<> bimpp_view;
+        bimpp::plan2d::house<> bimpp_binary_house;
+        if (!bimpp_reader.read(bimpp_json_input, bimpp_json_house)
+            || !bimpp_view.open(bimpp_bytes.data(), bimpp_bytes.size()) || !bimpp_view.toHouse(bimpp_binary_house))
+        {
+            return 1;
+        }
+        std::ostringstream bimpp_json_again;
+        bimpp::plan2d::json_writer<>::write(bimpp_json_again, bimpp_json_house);
+        std::ostringstream bimpp_binary_again;
+        bimpp::plan2d::json_writer<>::write(bimpp_binary_again, bimpp_binary_house);
+        if (bimpp_json_again.str() != bimpp_json.str() || bimpp_binary_again.str() != bimpp_json.str()
+            || bimpp_binary_house.holes.find(0)->second.kind != "door" || bimpp_binary_house.rooms.find(0)->second.kind != "office")
+        {
+            return 1;
+        }
+    }
+
+    /// A unit square island in a bigger square, its metrics are exact and it is a hole of the bigger room-ex
+    {
+        const double bimpp_squares[2][4][2] = {
+            { { -1.0, -1.0 }, { 2.0, -1.0 }, { 2.0, 2.0 }, { -1.0, 2.0 } },
+            { { 0.0, 0.0 }, { 1.0, 0.0 }, { 1.0, 1.0 }, { 0.0, 1.0 } },
+        };
+        bimpp::plan2d::house<> bimpp_island_house;
+        for (size_t i = 0; i < 2; ++i)
+        {
+            for (size_t j = 0; j < 4; ++j)
+            {
+                bimpp_island_house.nodes.insert(std::make_pair<>(i * 4 + j, bimpp::plan2d::node<>(bimpp_squares[i][j][0], bimpp_squares[i][j][1])));
+                bimpp_island_house.walls.insert(std::make_pair<>(i * 4 + j, bimpp::plan2d::wall<>(i * 4 + j, i * 4 + (j + 1) % 4)));
+            }
+        }
+        bimpp::plan2d::room<> bimpp_island_room;
+        bimpp_island_room.wall_ids = { 0, 1, 2, 3, 4, 5, 6, 7 };
+        bimpp_island_house.rooms.insert(std::make_pair<>(0, bimpp_island_room));
+        bimpp::plan2d::algorithm<>::room_ex_vector bimpp_island_room_exs;
+        bimpp::plan2d::algorithm<>::computeRoomExs(bimpp_island_house, bimpp_island_room_exs);
+        bimpp::plan2d::algorithm<>::room_ex_metrics_vector bimpp_metrics;
+        bimpp::plan2d::algorithm<>::computeRoomExMetrics(bimpp_island_house, bimpp_island_room_exs, bimpp_metrics);
+        bimpp::plan2d::algorithm<>::room_ex_hierarchy bimpp_hierarchy;
+        bimpp::plan2d::algorithm<>::computeRoomExHierarchy(bimpp_island_house, bimpp_island_room_exs, bimpp_hierarchy);
+        size_t bimpp_found[2][2] = {
+            { bimpp::plan2d::algorithm<>::room_ex_hierarchy::none_index, bimpp::plan2d::algorithm<>::room_ex_hierarchy::none_index },
+            { bimpp::plan2d::algorithm<>::room_ex_hierarchy::none_index, bimpp::plan2d::algorithm<>::room_ex_hierarchy::none_index },
+        };
+        for (size_t i = 0, ic = bimpp_island_room_exs.size(); i < ic; ++i)
+        {
+            const bool bimpp_is_in = (bimpp_island_room_exs[i].side == bimpp::plan2d::algorithm<>::room_side_in);
+            bimpp_found[bimpp_island_room_exs[i].walls.front().id / 4][bimpp_is_in ? 1 : 0] = i;
+        }
+        const size_t bimpp_unit = bimpp_found[1][1];
+        if (bimpp_island_room_exs.size() != 4 || bimpp_unit == bimpp::plan2d::algorithm<>::room_ex_hierarchy::none_index
+            || std::abs(bimpp_metrics[bimpp_unit].area - 1.0) > 1e-12
+            || std::abs(bimpp_metrics[bimpp_unit].centroid.x() - 0.5) > 1e-12 || std::abs(bimpp_metrics[bimpp_unit].centroid.y() - 0.5) > 1e-12
+            || bimpp_hierarchy.parents[bimpp_found[1][0]] != bimpp_found[0][1])
+        {
+            return 1;
+        }
+    }
+
+    /// The nearest wall of a point, and the room which contains it
+    {
+        bimpp::plan2d::spatial_index<> bimpp_index;
+        bimpp_index.build(bimpp_row_house, bimpp_row_room_exs);
+        double bimpp_distance = 0.0;
+        const size_t bimpp_index_of_room_ex = bimpp_index.findRoomEx(bimpp::plan2d::point<>(1.4, 0.5));
+        if (bimpp_index.findNearestWall(bimpp::plan2d::point<>(1.4, 0.5), &bimpp_distance) != 1 || std::abs(bimpp_distance - 0.4) > 1e-12
+            || bimpp_index_of_room_ex == bimpp::plan2d::spatial_index<>::none_index || bimpp_row_room_exs[bimpp_index_of_room_ex].id != 1)
+        {
+            return 1;
+        }
+    }
+
+    /// The middle room is next to both others by one wall and one door
+    {
+        bimpp::plan2d::room_graph<> bimpp_graph;
+        bimpp_graph.build(bimpp_row_house, bimpp_row_room_exs);
+        std::vector<size_t> bimpp_neighbour_ids;
+        std::vector<size_t> bimpp_wall_ids;
+        std::vector<size_t> bimpp_hole_ids;
+        if (!bimpp_graph.findNeighbours(1, bimpp_neighbour_ids) || bimpp_neighbour_ids != std::vector<size_t>{ 0, 2 }
+            || !bimpp_graph.findWalls(1, 2, bimpp_wall_ids) || bimpp_wall_ids != std::vector<size_t>{ 2 }
+            || !bimpp_graph.findHoles(0, 1, bimpp_hole_ids) || bimpp_hole_ids != std::vector<size_t>{ 1 }
+            || bimpp_graph.findLink(0, 2) != bimpp::plan2d::room_graph<>::none_index)
+        {
+            return 1;
+        }
+    }
+
+    /// Computing the houses of a project by some threads gives the same room-exs as computing them one by one
+    {
+        bimpp::plan2d::project<> bimpp_project;
+        bimpp::plan2d::building<>& bimpp_building = bimpp_project.sites[0].buildings[0];
+        bimpp_building.houses.insert(std::make_pair<>(0, bimpp_house));
+        bimpp_building.houses.insert(std::make_pair<>(1, bimpp_row_house));
+        bimpp_building.positions.insert(std::make_pair<>(bimpp::plan2d::point<>(10.0, 0.0), 1));
+        bimpp::plan2d::thread_pool bimpp_pool;
+        bimpp::plan2d::algorithm<>::house_room_ex_vector bimpp_results;
+        const bool bimpp_computed = bimpp::plan2d::algorithm<>::computeProjectRoomExs(bimpp_project, bimpp_results, bimpp_pool);
+        const bimpp::plan2d::algorithm<>::house_room_ex* bimpp_result = bimpp::plan2d::algorithm<>::findHouseRoomEx(bimpp_results, 0, 0, 0);
+        const bimpp::plan2d::algorithm<>::house_room_ex* bimpp_row_result = bimpp::plan2d::algorithm<>::findHouseRoomEx(bimpp_results, 0, 0, 1);
+        if (!bimpp_computed || bimpp_result == nullptr || bimpp_row_result == nullptr
+            || !isSameRoomExs(bimpp_room_exs, bimpp_result->room_exs, bimpp_same_id, bimpp_same_id)
+            || !isSameRoomExs(bimpp_row_room_exs, bimpp_row_result->room_exs, bimpp_same_id, bimpp_same_id)
+            || !bimpp_result->positions.empty() || bimpp_row_result->positions.size() != 1)
+        {
+            return 1;
+        }
+    }
+
+    /// The walking distance by A* is same as by Dijkstra, and goes through both doors between the rooms
+    {
+        bimpp::plan2d::navigation_graph<> bimpp_navigation;
+        bimpp_navigation.build(bimpp_row_house, bimpp_row_room_exs, std::vector<bimpp::plan2d::symbol>{ "door" });
+        std::vector<size_t> bimpp_door_ids;
+        const double bimpp_walking = bimpp_navigation.findDistance(0, 2, &bimpp_door_ids);
+        std::vector<double> bimpp_walkings;
+        bimpp_navigation.computeDistances(std::vector<size_t>{ 0 }, std::vector<size_t>{ 2 }, bimpp_walkings);
+        if (bimpp_walkings.size() != 1 || std::abs(bimpp_walking - bimpp_walkings.front()) > 1e-12
+            || std::abs(bimpp_walking - 2.0) > 1e-12 || bimpp_door_ids != std::vector<size_t>{ 1, 2 })
+        {
+            return 1;
+        }
+    }
     return 0;
 }
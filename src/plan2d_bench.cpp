@@ -0,0 +1,684 @@
+/*
+ * The MIT License (MIT)
+ * Copyright © 2020 BIM++
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the “Software”),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+/*!
+ * @file plan2d_bench.cpp
+ * 
+ * Time the functions of plan2d, and print the results as JSON.
+ * 
+ *     plan2d_bench [--filter <text>] [--grids 5,10,20] [--repetitions 10] [--min-time-ms 200] [--output <file>]
+ * 
+ * Every repetition runs the operation once if `--min-time-ms` is 0, which is used as a quick check by ctest.
+ */
+#include <bimpp/plan2d.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    typedef bimpp::plan2d::algorithm<>      algorithm_type;
+    typedef bimpp::plan2d::json_writer<>    json_writer_type;
+    typedef std::chrono::steady_clock       clock_type;
+
+    /// keep the results alive, so the compiler can't remove the timed calls
+    volatile double bench_sink = 0;
+
+    class bench_options
+    {
+    public:
+        bench_options()
+            : filter("")
+            , grids({ 5, 10, 20, 40 })
+            , repetitions(10)
+            , min_time_ms(200)
+            , output("")
+        {}
+
+    public:
+        std::string         filter;
+        std::vector<size_t> grids;
+        size_t              repetitions;
+        size_t              min_time_ms;    ///< The minimum time of all repetitions of a benchmark
+        std::string         output;
+    };
+
+    class bench_result
+    {
+    public:
+        bench_result()
+            : name("")
+            , grid(0)
+            , items_per_op(1)
+            , iterations(0)
+            , ns_per_ops()
+        {}
+
+    public:
+        std::string         name;
+        size_t              grid;           ///< The size of the grid, or 0 if the benchmark doesn't use it
+        size_t              items_per_op;   ///< The items which are processed by an operation, such as walls
+        size_t              iterations;     ///< The operations of every repetition
+        std::vector<double> ns_per_ops;     ///< The time of an operation of every repetition
+    };
+
+    /*!
+     * Run an operation some times, the count is calibrated to make every repetition long enough.
+     * 
+     * @param _options The options
+     * @param _operation It runs an operation and returns a value which is kept by `bench_sink`
+     * @param _result Output the times
+     */
+    template<typename TOperation>
+    void runBench(const bench_options& _options, const TOperation& _operation, bench_result& _result)
+    {
+        const double bim_min_repetition_ns = _options.min_time_ms * 1e6 / static_cast<double>(_options.repetitions);
+        size_t bim_iterations = 1;
+        while (true)
+        {
+            const clock_type::time_point bim_start = clock_type::now();
+            double bim_sum = 0;
+            for (size_t i = 0; i < bim_iterations; ++i)
+            {
+                bim_sum += _operation();
+            }
+            const double bim_ns = std::chrono::duration<double, std::nano>(clock_type::now() - bim_start).count();
+            bench_sink = bench_sink + bim_sum;
+            if (bim_ns >= bim_min_repetition_ns || bim_iterations >= (static_cast<size_t>(1) << 40))
+            {
+                break;
+            }
+            /// grow to the expected count, but not too fast when the timer is too coarse
+            const double bim_scale = (bim_ns > 0) ? (bim_min_repetition_ns / bim_ns) * 1.2 : 10.0;
+            bim_iterations = static_cast<size_t>(static_cast<double>(bim_iterations) * std::min(std::max(bim_scale, 1.5), 10.0)) + 1;
+        }
+
+        _result.iterations = bim_iterations;
+        _result.ns_per_ops.clear();
+        for (size_t r = 0; r < _options.repetitions; ++r)
+        {
+            const clock_type::time_point bim_start = clock_type::now();
+            double bim_sum = 0;
+            for (size_t i = 0; i < bim_iterations; ++i)
+            {
+                bim_sum += _operation();
+            }
+            const double bim_ns = std::chrono::duration<double, std::nano>(clock_type::now() - bim_start).count();
+            bench_sink = bench_sink + bim_sum;
+            _result.ns_per_ops.push_back(bim_ns / static_cast<double>(bim_iterations));
+        }
+    }
+
+    /// make a grid of nodes like the example in `plan2d.cpp`, and a room which uses all walls
+    void makeGrid(size_t _size, bimpp::plan2d::house<>& _house)
+    {
+        _house.reset();
+        for (size_t y = 0; y < _size; ++y)
+        {
+            for (size_t x = 0; x < _size; ++x)
+            {
+                _house.nodes.insert(std::make_pair<>(x * 10000 + y, bimpp::plan2d::node<>(bimpp::plan2d::constant<>::convert(x), bimpp::plan2d::constant<>::convert(y))));
+            }
+        }
+        bimpp::plan2d::room<> bim_room;
+        size_t bim_wall_id = 0;
+        for (size_t y = 0; y < _size; ++y)
+        {
+            for (size_t x = 0; x < _size; ++x)
+            {
+                if (x > 0)
+                {
+                    _house.walls.insert(std::make_pair<>(bim_wall_id, bimpp::plan2d::wall<>((x - 1) * 10000 + y, x * 10000 + y)));
+                    bim_room.wall_ids.push_back(bim_wall_id++);
+                }
+                if (y > 0)
+                {
+                    _house.walls.insert(std::make_pair<>(bim_wall_id, bimpp::plan2d::wall<>(x * 10000 + (y - 1), x * 10000 + y)));
+                    bim_room.wall_ids.push_back(bim_wall_id++);
+                }
+            }
+        }
+        _house.rooms.insert(std::make_pair<>(0, bim_room));
+    }
+
+    /// every cell of the grid is a room, and every wall between two rooms has a door in its middle
+    void makeRoomGrid(size_t _size, bimpp::plan2d::house<>& _house)
+    {
+        _house.reset();
+        for (size_t y = 0; y <= _size; ++y)
+        {
+            for (size_t x = 0; x <= _size; ++x)
+            {
+                _house.nodes.insert(std::make_pair<>(x * 10000 + y, bimpp::plan2d::node<>(bimpp::plan2d::constant<>::convert(x), bimpp::plan2d::constant<>::convert(y))));
+            }
+        }
+        std::vector<bimpp::plan2d::room<>> bim_rooms(_size * _size);
+        size_t bim_wall_id = 0;
+        size_t bim_hole_id = 0;
+        for (size_t y = 0; y <= _size; ++y)
+        {
+            for (size_t x = 0; x <= _size; ++x)
+            {
+                if (x < _size)
+                {
+                    _house.walls.insert(std::make_pair<>(bim_wall_id, bimpp::plan2d::wall<>(x * 10000 + y, (x + 1) * 10000 + y)));
+                    if (y > 0) bim_rooms[(y - 1) * _size + x].wall_ids.push_back(bim_wall_id);
+                    if (y < _size) bim_rooms[y * _size + x].wall_ids.push_back(bim_wall_id);
+                    if (y > 0 && y < _size) _house.holes.insert(std::make_pair<>(bim_hole_id++, bimpp::plan2d::hole<>(bim_wall_id, 0.25, 0.5)));
+                    ++bim_wall_id;
+                }
+                if (y < _size)
+                {
+                    _house.walls.insert(std::make_pair<>(bim_wall_id, bimpp::plan2d::wall<>(x * 10000 + y, x * 10000 + y + 1)));
+                    if (x > 0) bim_rooms[y * _size + x - 1].wall_ids.push_back(bim_wall_id);
+                    if (x < _size) bim_rooms[y * _size + x].wall_ids.push_back(bim_wall_id);
+                    if (x > 0 && x < _size) _house.holes.insert(std::make_pair<>(bim_hole_id++, bimpp::plan2d::hole<>(bim_wall_id, 0.25, 0.5)));
+                    ++bim_wall_id;
+                }
+            }
+        }
+        for (size_t i = 0, ic = bim_rooms.size(); i < ic; ++i)
+        {
+            _house.rooms.insert(std::make_pair<>(i, bim_rooms[i]));
+        }
+    }
+
+    bool isSelected(const bench_options& _options, const std::string& _name)
+    {
+        return (_options.filter.empty() || _name.find(_options.filter) != std::string::npos);
+    }
+
+    void benchAngles(const bench_options& _options, std::vector<bench_result>& _results)
+    {
+        std::mt19937 bim_random(5489u);
+        std::uniform_real_distribution<double> bim_distribution(-50.0, 50.0);
+        const size_t bim_nodes_count = 4096;
+        std::vector<bimpp::plan2d::node<>> bim_nodes;
+        std::vector<double> bim_xs;
+        std::vector<double> bim_ys;
+        for (size_t i = 0; i < bim_nodes_count; ++i)
+        {
+            const double bim_x = bim_distribution(bim_random);
+            const double bim_y = bim_distribution(bim_random);
+            bim_nodes.push_back(bimpp::plan2d::node<>(bim_x, bim_y));
+            bim_xs.push_back(bim_x);
+            bim_ys.push_back(bim_y);
+        }
+        const bimpp::plan2d::node<> bim_o(0.0, 0.0);
+        const bimpp::plan2d::node<> bim_a(1.0, 0.0);
+
+        typedef double (*angle_function)(const algorithm_type::node_type&, const algorithm_type::node_type&, const algorithm_type::node_type&);
+        const std::pair<const char*, angle_function> bim_functions[] = {
+            std::make_pair("calculateAngleEx", &algorithm_type::calculateAngleEx),
+            std::make_pair("calculateSinAngleEx", &algorithm_type::calculateSinAngleEx),
+            std::make_pair("calculateCosAngleEx", &algorithm_type::calculateCosAngleEx),
+        };
+        for (const std::pair<const char*, angle_function>& bim_function : bim_functions)
+        {
+            if (!isSelected(_options, bim_function.first)) continue;
+            bench_result bim_result;
+            bim_result.name = bim_function.first;
+            size_t bim_index = 0;
+            runBench(_options, [&]()
+            {
+                bim_index = (bim_index + 1) & (bim_nodes_count - 1);
+                return bim_function.second(bim_o, bim_a, bim_nodes[bim_index]);
+            }, bim_result);
+            _results.push_back(bim_result);
+        }
+
+        typedef void (*angles_function)(const algorithm_type::node_type&, const algorithm_type::node_type&, const double*, const double*, size_t, double*);
+        const std::pair<const char*, angles_function> bim_batch_functions[] = {
+            std::make_pair("calculateAngleExs", &algorithm_type::calculateAngleExs),
+            std::make_pair("calculateSinAngleExs", &algorithm_type::calculateSinAngleExs),
+            std::make_pair("calculateCosAngleExs", &algorithm_type::calculateCosAngleExs),
+        };
+        std::vector<double> bim_results(bim_nodes_count);
+        for (const std::pair<const char*, angles_function>& bim_function : bim_batch_functions)
+        {
+            if (!isSelected(_options, bim_function.first)) continue;
+            bench_result bim_result;
+            bim_result.name = bim_function.first;
+            bim_result.items_per_op = bim_nodes_count;
+            runBench(_options, [&]()
+            {
+                bim_function.second(bim_o, bim_a, &bim_xs[0], &bim_ys[0], bim_nodes_count, &bim_results[0]);
+                return bim_results[bim_nodes_count / 2];
+            }, bim_result);
+            _results.push_back(bim_result);
+        }
+    }
+
+    void benchContains(const bench_options& _options, std::vector<bench_result>& _results)
+    {
+        const size_t bim_sizes[] = { 64, 1024, 16384 };
+        for (size_t bim_size : bim_sizes)
+        {
+            std::ostringstream bim_name;
+            bim_name << "isContainsForBiggerVector/" << bim_size;
+            if (!isSelected(_options, bim_name.str())) continue;
+            algorithm_type::id_vector bim_all;
+            algorithm_type::id_vector bim_sub;
+            for (size_t i = 0; i < bim_size; ++i)
+            {
+                bim_all.push_back(i * 3);
+                if (i % 2 == 0) bim_sub.push_back(i * 3);
+            }
+            bench_result bim_result;
+            bim_result.name = bim_name.str();
+            bim_result.items_per_op = bim_size;
+            runBench(_options, [&]()
+            {
+                return algorithm_type::isContainsForBiggerVector(bim_all, bim_sub) ? 1.0 : 0.0;
+            }, bim_result);
+            _results.push_back(bim_result);
+        }
+    }
+
+    void benchRoomExs(const bench_options& _options, std::vector<bench_result>& _results)
+    {
+        const std::pair<const char*, algorithm_type::trace_mode> bim_modes[] = {
+            std::make_pair("angle", algorithm_type::trace_mode_angle),
+            std::make_pair("rotation", algorithm_type::trace_mode_rotation),
+            std::make_pair("face", algorithm_type::trace_mode_face),
+        };
+        for (size_t bim_grid : _options.grids)
+        {
+            bimpp::plan2d::house<> bim_house;
+            makeGrid(bim_grid, bim_house);
+            for (const std::pair<const char*, algorithm_type::trace_mode>& bim_mode : bim_modes)
+            {
+                for (size_t bim_with_workspace = 0; bim_with_workspace < 2; ++bim_with_workspace)
+                {
+                    std::string bim_name = std::string("computeRoomExs/") + bim_mode.first + (bim_with_workspace ? "/workspace" : "");
+                    if (!isSelected(_options, bim_name)) continue;
+                    bench_result bim_result;
+                    bim_result.name = bim_name;
+                    bim_result.grid = bim_grid;
+                    bim_result.items_per_op = bim_house.walls.size();
+                    algorithm_type::room_ex_vector bim_room_exs;
+                    algorithm_type::workspace bim_workspace;
+                    runBench(_options, [&]()
+                    {
+                        algorithm_type::computeRoomExs(bim_house, bim_room_exs, bimpp::plan2d::constant<>::none_id, bim_mode.second
+                            , nullptr, bim_with_workspace ? &bim_workspace : nullptr);
+                        return static_cast<double>(bim_room_exs.size());
+                    }, bim_result);
+                    _results.push_back(bim_result);
+                }
+            }
+            if (isSelected(_options, "computeRoomExMetrics"))
+            {
+                bench_result bim_result;
+                bim_result.name = "computeRoomExMetrics";
+                bim_result.grid = bim_grid;
+                bim_result.items_per_op = bim_house.walls.size();
+                algorithm_type::room_ex_vector bim_room_exs;
+                algorithm_type::computeRoomExs(bim_house, bim_room_exs);
+                algorithm_type::room_ex_metrics_vector bim_metrics;
+                runBench(_options, [&]()
+                {
+                    algorithm_type::computeRoomExMetrics(bim_house, bim_room_exs, bim_metrics);
+                    return bim_metrics.empty() ? 0.0 : bim_metrics[0].area;
+                }, bim_result);
+                _results.push_back(bim_result);
+            }
+            if (isSelected(_options, "computeRoomExHierarchy"))
+            {
+                bench_result bim_result;
+                bim_result.name = "computeRoomExHierarchy";
+                bim_result.grid = bim_grid;
+                algorithm_type::room_ex_vector bim_room_exs;
+                algorithm_type::computeRoomExs(bim_house, bim_room_exs);
+                bim_result.items_per_op = bim_room_exs.size();
+                algorithm_type::room_ex_hierarchy bim_hierarchy;
+                runBench(_options, [&]()
+                {
+                    algorithm_type::computeRoomExHierarchy(bim_house, bim_room_exs, bim_hierarchy);
+                    return static_cast<double>(bim_hierarchy.roots.size());
+                }, bim_result);
+                _results.push_back(bim_result);
+            }
+        }
+    }
+
+    void benchSpatialIndex(const bench_options& _options, std::vector<bench_result>& _results)
+    {
+        for (size_t bim_grid : _options.grids)
+        {
+            bimpp::plan2d::house<> bim_house;
+            makeGrid(bim_grid, bim_house);
+            algorithm_type::room_ex_vector bim_room_exs;
+            algorithm_type::computeRoomExs(bim_house, bim_room_exs);
+            bimpp::plan2d::spatial_index<> bim_index;
+            if (isSelected(_options, "spatial_index/build"))
+            {
+                bench_result bim_result;
+                bim_result.name = "spatial_index/build";
+                bim_result.grid = bim_grid;
+                bim_result.items_per_op = bim_house.walls.size();
+                runBench(_options, [&]()
+                {
+                    bim_index.build(bim_house, bim_room_exs);
+                    return static_cast<double>(bim_room_exs.size());
+                }, bim_result);
+                _results.push_back(bim_result);
+            }
+            bim_index.build(bim_house, bim_room_exs);
+
+            std::mt19937 bim_random(5489u);
+            std::uniform_real_distribution<double> bim_distribution(0.0, static_cast<double>(bim_grid));
+            const size_t bim_points_count = 4096;
+            std::vector<algorithm_type::point_type> bim_points;
+            for (size_t i = 0; i < bim_points_count; ++i)
+            {
+                bim_points.push_back(algorithm_type::point_type(bim_distribution(bim_random), bim_distribution(bim_random)));
+            }
+            if (isSelected(_options, "spatial_index/findRoomEx"))
+            {
+                bench_result bim_result;
+                bim_result.name = "spatial_index/findRoomEx";
+                bim_result.grid = bim_grid;
+                size_t bim_point = 0;
+                runBench(_options, [&]()
+                {
+                    bim_point = (bim_point + 1) & (bim_points_count - 1);
+                    return static_cast<double>(bim_index.findRoomEx(bim_points[bim_point]));
+                }, bim_result);
+                _results.push_back(bim_result);
+            }
+            if (isSelected(_options, "spatial_index/findNearestWall"))
+            {
+                bench_result bim_result;
+                bim_result.name = "spatial_index/findNearestWall";
+                bim_result.grid = bim_grid;
+                size_t bim_point = 0;
+                runBench(_options, [&]()
+                {
+                    bim_point = (bim_point + 1) & (bim_points_count - 1);
+                    return static_cast<double>(bim_index.findNearestWall(bim_points[bim_point]));
+                }, bim_result);
+                _results.push_back(bim_result);
+            }
+        }
+    }
+
+    void benchRoomGraph(const bench_options& _options, std::vector<bench_result>& _results)
+    {
+        for (size_t bim_grid : _options.grids)
+        {
+            bimpp::plan2d::house<> bim_house;
+            makeRoomGrid(bim_grid, bim_house);
+            bimpp::plan2d::room_graph<> bim_graph;
+            if (isSelected(_options, "room_graph/build"))
+            {
+                bench_result bim_result;
+                bim_result.name = "room_graph/build";
+                bim_result.grid = bim_grid;
+                bim_result.items_per_op = bim_house.rooms.size();
+                runBench(_options, [&]()
+                {
+                    bim_graph.build(bim_house);
+                    return static_cast<double>(bim_graph.linkCount());
+                }, bim_result);
+                _results.push_back(bim_result);
+            }
+            if (isSelected(_options, "room_graph/updateRooms"))
+            {
+                bench_result bim_result;
+                bim_result.name = "room_graph/updateRooms";
+                bim_result.grid = bim_grid;
+                bim_result.items_per_op = 1;
+                bim_graph.build(bim_house);
+                const std::vector<size_t> bim_room_ids(1, bim_house.rooms.size() / 2);
+                runBench(_options, [&]()
+                {
+                    bim_graph.updateRooms(bim_house, bim_room_ids);
+                    return static_cast<double>(bim_graph.linkCount());
+                }, bim_result);
+                _results.push_back(bim_result);
+            }
+        }
+    }
+
+    void benchNavigationGraph(const bench_options& _options, std::vector<bench_result>& _results)
+    {
+        for (size_t bim_grid : _options.grids)
+        {
+            bimpp::plan2d::house<> bim_house;
+            makeRoomGrid(bim_grid, bim_house);
+            algorithm_type::room_ex_vector bim_room_exs;
+            algorithm_type::computeRoomExs(bim_house, bim_room_exs);
+            bimpp::plan2d::navigation_graph<> bim_graph;
+            bim_graph.build(bim_house, bim_room_exs);
+            const size_t bim_rooms_count = bim_house.rooms.size();
+            if (isSelected(_options, "navigation_graph/build"))
+            {
+                bench_result bim_result;
+                bim_result.name = "navigation_graph/build";
+                bim_result.grid = bim_grid;
+                bim_result.items_per_op = bim_rooms_count;
+                runBench(_options, [&]()
+                {
+                    bim_graph.build(bim_house, bim_room_exs);
+                    return static_cast<double>(bim_graph.doorCount());
+                }, bim_result);
+                _results.push_back(bim_result);
+            }
+            if (isSelected(_options, "navigation_graph/findDistance"))
+            {
+                bench_result bim_result;
+                bim_result.name = "navigation_graph/findDistance";
+                bim_result.grid = bim_grid;
+                bim_result.items_per_op = 1;
+                size_t bim_index = 0;
+                runBench(_options, [&]()
+                {
+                    bim_index = (bim_index + 1) % bim_rooms_count;
+                    return bim_graph.findDistance(bim_index, bim_rooms_count - 1 - bim_index);
+                }, bim_result);
+                _results.push_back(bim_result);
+            }
+            if (isSelected(_options, "navigation_graph/computeDistances"))
+            {
+                bench_result bim_result;
+                bim_result.name = "navigation_graph/computeDistances";
+                bim_result.grid = bim_grid;
+                bim_result.items_per_op = bim_rooms_count * bim_rooms_count;
+                std::vector<size_t> bim_room_ids;
+                for (size_t i = 0; i < bim_rooms_count; ++i)
+                {
+                    bim_room_ids.push_back(i);
+                }
+                std::vector<double> bim_distances;
+                runBench(_options, [&]()
+                {
+                    bim_graph.clearCache();
+                    bim_graph.computeDistances(bim_room_ids, bim_room_ids, bim_distances);
+                    return bim_distances.back();
+                }, bim_result);
+                _results.push_back(bim_result);
+            }
+        }
+    }
+
+    void writeJson(std::ostream& _output, const bench_options& _options, const std::vector<bench_result>& _results)
+    {
+        const char* bim_levels[] = { "none", "sse2", "avx2", "neon" };
+        _output << "{\n  \"context\": {";
+#if defined(__VERSION__)
+        _output << "\"compiler\": ";
+        json_writer_type::writeString(_output, __VERSION__);
+        _output << ", ";
+#elif defined(_MSC_VER)
+        _output << "\"compiler\": \"msvc " << _MSC_VER << "\", ";
+#endif
+#if defined(NDEBUG)
+        _output << "\"build_type\": \"release\", ";
+#else
+        _output << "\"build_type\": \"debug\", ";
+#endif
+        _output << "\"simd_level\": \"" << bim_levels[bimpp::plan2d::simd::selected()] << "\", "
+            << "\"repetitions\": " << _options.repetitions << ", "
+            << "\"min_time_ms\": " << _options.min_time_ms << "},\n  \"benchmarks\": [";
+        char bim_text[64];
+        for (size_t i = 0, ic = _results.size(); i < ic; ++i)
+        {
+            const bench_result& bim_result = _results[i];
+            std::vector<double> bim_sorted(bim_result.ns_per_ops);
+            std::sort(bim_sorted.begin(), bim_sorted.end());
+            double bim_mean = 0;
+            for (double bim_ns : bim_sorted) bim_mean += bim_ns;
+            bim_mean /= static_cast<double>(bim_sorted.size());
+            double bim_variance = 0;
+            for (double bim_ns : bim_sorted) bim_variance += (bim_ns - bim_mean) * (bim_ns - bim_mean);
+            bim_variance = (bim_sorted.size() > 1) ? bim_variance / static_cast<double>(bim_sorted.size() - 1) : 0;
+            const size_t bim_middle = bim_sorted.size() / 2;
+            const double bim_median = (bim_sorted.size() % 2 == 1) ? bim_sorted[bim_middle] : (bim_sorted[bim_middle - 1] + bim_sorted[bim_middle]) / 2;
+            const double bim_stddev = std::sqrt(bim_variance);
+
+            _output << (i == 0 ? "\n" : ",\n") << "    {\"name\": ";
+            json_writer_type::writeString(_output, bim_result.name);
+            if (bim_result.grid > 0)
+            {
+                _output << ", \"grid\": " << bim_result.grid;
+            }
+            _output << ", \"iterations\": " << bim_result.iterations
+                << ", \"items_per_op\": " << bim_result.items_per_op;
+            std::snprintf(bim_text, sizeof(bim_text), "%.3f", bim_mean);
+            _output << ", \"ns_per_op\": " << bim_text;
+            std::snprintf(bim_text, sizeof(bim_text), "%.3f", bim_median);
+            _output << ", \"ns_per_op_median\": " << bim_text;
+            std::snprintf(bim_text, sizeof(bim_text), "%.3f", bim_sorted.front());
+            _output << ", \"ns_per_op_min\": " << bim_text;
+            std::snprintf(bim_text, sizeof(bim_text), "%.3f", bim_sorted.back());
+            _output << ", \"ns_per_op_max\": " << bim_text;
+            std::snprintf(bim_text, sizeof(bim_text), "%.6g", bim_variance);
+            _output << ", \"variance\": " << bim_text;
+            std::snprintf(bim_text, sizeof(bim_text), "%.3f", bim_stddev);
+            _output << ", \"stddev\": " << bim_text;
+            std::snprintf(bim_text, sizeof(bim_text), "%.5f", (bim_mean > 0) ? bim_stddev / bim_mean : 0.0);
+            _output << ", \"cv\": " << bim_text;
+            std::snprintf(bim_text, sizeof(bim_text), "%.6g", (bim_mean > 0) ? 1e9 / bim_mean : 0.0);
+            _output << ", \"ops_per_second\": " << bim_text;
+            std::snprintf(bim_text, sizeof(bim_text), "%.6g", (bim_mean > 0) ? 1e9 * static_cast<double>(bim_result.items_per_op) / bim_mean : 0.0);
+            _output << ", \"items_per_second\": " << bim_text << "}";
+        }
+        _output << "\n  ]\n}\n";
+    }
+
+    bool parseSizes(const char* _text, std::vector<size_t>& _sizes)
+    {
+        _sizes.clear();
+        std::istringstream bim_input(_text);
+        std::string bim_item;
+        while (std::getline(bim_input, bim_item, ','))
+        {
+            const long bim_size = std::strtol(bim_item.c_str(), nullptr, 10);
+            if (bim_size < 2) return false;
+            _sizes.push_back(static_cast<size_t>(bim_size));
+        }
+        return !_sizes.empty();
+    }
+
+    bool parseOptions(int _argc, char* _argv[], bench_options& _options)
+    {
+        for (int i = 1; i < _argc; ++i)
+        {
+            const std::string bim_argument = _argv[i];
+            const bool bim_has_value = (i + 1 < _argc);
+            if (bim_argument == "--filter" && bim_has_value)
+            {
+                _options.filter = _argv[++i];
+            }
+            else if (bim_argument == "--grids" && bim_has_value)
+            {
+                if (!parseSizes(_argv[++i], _options.grids)) return false;
+            }
+            else if (bim_argument == "--repetitions" && bim_has_value)
+            {
+                const long bim_repetitions = std::strtol(_argv[++i], nullptr, 10);
+                if (bim_repetitions < 1) return false;
+                _options.repetitions = static_cast<size_t>(bim_repetitions);
+            }
+            else if (bim_argument == "--min-time-ms" && bim_has_value)
+            {
+                const long bim_min_time_ms = std::strtol(_argv[++i], nullptr, 10);
+                if (bim_min_time_ms < 0) return false;
+                _options.min_time_ms = static_cast<size_t>(bim_min_time_ms);
+            }
+            else if (bim_argument == "--output" && bim_has_value)
+            {
+                _options.output = _argv[++i];
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    bench_options bim_options;
+    if (!parseOptions(argc, argv, bim_options))
+    {
+        std::cerr << "usage: plan2d_bench [--filter <text>] [--grids 5,10,20] [--repetitions 10] [--min-time-ms 200] [--output <file>]" << std::endl;
+        return 1;
+    }
+
+    std::vector<bench_result> bim_results;
+    benchAngles(bim_options, bim_results);
+    benchContains(bim_options, bim_results);
+    benchRoomExs(bim_options, bim_results);
+    benchSpatialIndex(bim_options, bim_results);
+    benchRoomGraph(bim_options, bim_results);
+    benchNavigationGraph(bim_options, bim_results);
+
+    if (bim_options.output.empty())
+    {
+        writeJson(std::cout, bim_options, bim_results);
+    }
+    else
+    {
+        std::ofstream bim_output(bim_options.output.c_str());
+        if (!bim_output)
+        {
+            std::cerr << "can't open " << bim_options.output << std::endl;
+            return 1;
+        }
+        writeJson(bim_output, bim_options, bim_results);
+    }
+    return 0;
+}